@@ -14,10 +14,6 @@ using PaintDotNet.Imaging;
 using System;
 using System.Buffers.Binary;
 using System.Collections.Generic;
-using System.Globalization;
-using System.IO;
-using System.Runtime.CompilerServices;
-using System.Text;
 
 namespace WebPFileType.Exif
 {
@@ -28,60 +24,46 @@ namespace WebPFileType.Exif
         /// </summary>
         /// <param name="exifBytes">The EXIF bytes.</param>
         /// <returns>
-        /// A collection containing the EXIF properties.
+        /// A collection containing the EXIF properties, the property values reference <paramref name="exifBytes"/>.
         /// </returns>
         /// <exception cref="ArgumentNullException"><paramref name="exifBytes"/> is null.</exception>
         internal static ExifValueCollection? Parse(byte[] exifBytes)
         {
             ArgumentNullException.ThrowIfNull(exifBytes);
 
-            ExifValueCollection? exifValues = null;
+            ReadOnlySpan<byte> data = exifBytes;
 
-            MemoryStream? stream = null;
-            try
+            // The byte order marker, signature and first IFD offset.
+            if (data.Length < 8)
             {
-                stream = new MemoryStream(exifBytes);
-
-                Endianess? byteOrder = TryDetectTiffByteOrder(stream);
-
-                if (byteOrder.HasValue)
-                {
-                    using (EndianBinaryReader reader = new(stream, byteOrder.Value))
-                    {
-                        stream = null;
-
-                        ushort signature = reader.ReadUInt16();
-
-                        if (signature == TiffConstants.Signature)
-                        {
-                            uint ifdOffset = reader.ReadUInt32();
+                return null;
+            }
 
-                            List<ParserIFDEntry> entries = ParseDirectories(reader, ifdOffset);
+            Endianess? byteOrder = TryDetectTiffByteOrder(data);
 
-                            exifValues = new ExifValueCollection(ConvertIFDEntriesToMetadataEntries(reader, entries));
-                        }
-                    }
-                }
-            }
-            catch (EndOfStreamException)
+            if (!byteOrder.HasValue)
             {
-                // The EXIF data is corrupt, ignore it.
-                exifValues = null;
+                return null;
             }
-            finally
+
+            bool isBigEndian = byteOrder.Value == Endianess.Big;
+
+            if (ReadUInt16(data, 2, isBigEndian) != TiffConstants.Signature)
             {
-                stream?.Dispose();
+                return null;
             }
 
-            return exifValues;
+            uint ifdOffset = ReadUInt32(data, 4, isBigEndian);
+
+            Dictionary<ExifPropertyPath, ParsedExifValue>? items = ParseDirectories(exifBytes, isBigEndian, ifdOffset);
+
+            // The EXIF data is corrupt if one of the directories extends past the end of the buffer, ignore it.
+            return items != null ? new ExifValueCollection(items) : null;
         }
 
-        [SkipLocalsInit]
-        private static Endianess? TryDetectTiffByteOrder(Stream stream)
+        private static Endianess? TryDetectTiffByteOrder(ReadOnlySpan<byte> data)
         {
-            Span<byte> byteOrderMarker = stackalloc byte[2];
-
-            stream.ReadExactly(byteOrderMarker);
+            ReadOnlySpan<byte> byteOrderMarker = data.Slice(0, 2);
 
             if (byteOrderMarker.SequenceEqual(TiffConstants.BigEndianByteOrderMarker))
             {
@@ -97,84 +79,27 @@ namespace WebPFileType.Exif
             }
         }
 
-        private static Dictionary<ExifPropertyPath, ExifValue> ConvertIFDEntriesToMetadataEntries(EndianBinaryReader reader, List<ParserIFDEntry> entries)
+        private static ushort ReadUInt16(ReadOnlySpan<byte> data, int offset, bool isBigEndian)
         {
-            Dictionary<ExifPropertyPath, ExifValue> items = new(entries.Count);
-            bool swapNumberByteOrder = reader.Endianess == Endianess.Big;
+            ReadOnlySpan<byte> bytes = data.Slice(offset, sizeof(ushort));
 
-            for (int i = 0; i < entries.Count; i++)
-            {
-                ParserIFDEntry entry = entries[i];
-
-                byte[]? propertyData;
-                if (entry.OffsetFieldContainsValue)
-                {
-                    propertyData = entry.GetValueBytesFromOffset();
-                    if (propertyData == null)
-                    {
-                        continue;
-                    }
-                }
-                else
-                {
-                    long bytesToRead = entry.Count * ExifValueTypeUtil.GetSizeInBytes(entry.Type);
-
-                    // Skip any tags that are empty or larger than 2 GB.
-                    if (bytesToRead == 0 || bytesToRead > int.MaxValue)
-                    {
-                        continue;
-                    }
-
-                    uint offset = entry.Offset;
-
-                    if ((offset + bytesToRead) > reader.Length)
-                    {
-                        continue;
-                    }
-
-                    reader.Position = offset;
-
-                    propertyData = reader.ReadBytes((int)bytesToRead);
-
-                    if (swapNumberByteOrder)
-                    {
-                        // Paint.NET converts all multi-byte numbers to little-endian.
-                        switch (entry.Type)
-                        {
-                            case ExifValueType.Short:
-                            case ExifValueType.SShort:
-                                propertyData = SwapShortArrayToLittleEndian(propertyData, entry.Count);
-                                break;
-                            case ExifValueType.Long:
-                            case ExifValueType.SLong:
-                            case ExifValueType.Float:
-                                propertyData = SwapLongArrayToLittleEndian(propertyData, entry.Count);
-                                break;
-                            case ExifValueType.Rational:
-                            case ExifValueType.SRational:
-                                propertyData = SwapRationalArrayToLittleEndian(propertyData, entry.Count);
-                                break;
-                            case ExifValueType.Double:
-                                propertyData = SwapDoubleArrayToLittleEndian(propertyData, entry.Count);
-                                break;
-                            case ExifValueType.Byte:
-                            case ExifValueType.Ascii:
-                            case ExifValueType.Undefined:
-                            default:
-                                break;
-                        }
-                    }
-                }
+            return isBigEndian ? BinaryPrimitives.ReadUInt16BigEndian(bytes) : BinaryPrimitives.ReadUInt16LittleEndian(bytes);
+        }
 
-                items.TryAdd(new ExifPropertyPath(entry.Section, entry.Tag), new ExifValue(entry.Type, propertyData));
-            }
+        private static uint ReadUInt32(ReadOnlySpan<byte> data, int offset, bool isBigEndian)
+        {
+            ReadOnlySpan<byte> bytes = data.Slice(offset, sizeof(uint));
 
-            return items;
+            return isBigEndian ? BinaryPrimitives.ReadUInt32BigEndian(bytes) : BinaryPrimitives.ReadUInt32LittleEndian(bytes);
         }
 
-        private static List<ParserIFDEntry> ParseDirectories(EndianBinaryReader reader, uint firstIFDOffset)
+        private static Dictionary<ExifPropertyPath, ParsedExifValue>? ParseDirectories(
+            byte[] exifBytes,
+            bool isBigEndian,
+            uint firstIFDOffset)
         {
-            List<ParserIFDEntry> items = [];
+            ReadOnlySpan<byte> data = exifBytes;
+            Dictionary<ExifPropertyPath, ParsedExifValue> items = [];
 
             bool foundExif = false;
             bool foundGps = false;
@@ -190,24 +115,40 @@ namespace WebPFileType.Exif
                 ExifSection section = metadataOffset.Section;
                 uint offset = metadataOffset.Offset;
 
-                if (offset >= reader.Length)
+                if (offset >= (uint)data.Length)
                 {
                     continue;
                 }
 
-                reader.Position = offset;
+                if ((offset + sizeof(ushort)) > (uint)data.Length)
+                {
+                    return null;
+                }
 
-                ushort count = reader.ReadUInt16();
+                ushort count = ReadUInt16(data, (int)offset, isBigEndian);
                 if (count == 0)
                 {
                     continue;
                 }
 
-                items.Capacity += count;
+                long entriesStart = offset + sizeof(ushort);
+
+                if ((entriesStart + ((long)count * IFDEntry.SizeOf)) > data.Length)
+                {
+                    return null;
+                }
+
+                // Grow the dictionary once per directory instead of once per doubling.
+                items.EnsureCapacity(items.Count + count);
 
                 for (int i = 0; i < count; i++)
                 {
-                    ParserIFDEntry entry = new(reader, section);
+                    int entryOffset = (int)(entriesStart + ((long)i * IFDEntry.SizeOf));
+
+                    IFDEntry entry = new(ReadUInt16(data, entryOffset, isBigEndian),
+                                         (ExifValueType)ReadUInt16(data, entryOffset + 2, isBigEndian),
+                                         ReadUInt32(data, entryOffset + 4, isBigEndian),
+                                         ReadUInt32(data, entryOffset + 8, isBigEndian));
 
                     switch (entry.Tag)
                     {
@@ -246,424 +187,39 @@ namespace WebPFileType.Exif
                             // The EXIF MakerNote tag is treated as an opaque blob, so those thumbnails will be preserved.
                             break;
                         default:
-                            items.Add(entry);
+                            if (TryGetValueData(exifBytes, entry, entryOffset, out ReadOnlyMemory<byte> valueData))
+                            {
+                                items.TryAdd(new ExifPropertyPath(section, entry.Tag),
+                                             new ParsedExifValue(entry.Type, entry.Count, valueData, isBigEndian));
+                            }
                             break;
                     }
-
-                    System.Diagnostics.Debug.WriteLine(entry.ToString());
                 }
             }
 
             return items;
         }
 
-        private static unsafe byte[] SwapShortArrayToLittleEndian(byte[] values, uint count)
-        {
-            fixed (byte* pBytes = values)
-            {
-                ushort* ptr = (ushort*)pBytes;
-                ushort* ptrEnd = ptr + count;
-
-                while (ptr < ptrEnd)
-                {
-                    *ptr = BinaryPrimitives.ReverseEndianness(*ptr);
-                    ptr++;
-                }
-            }
-
-            return values;
-        }
-
-        private static unsafe byte[] SwapLongArrayToLittleEndian(byte[] values, uint count)
-        {
-            fixed (byte* pBytes = values)
-            {
-                uint* ptr = (uint*)pBytes;
-                uint* ptrEnd = ptr + count;
-
-                while (ptr < ptrEnd)
-                {
-                    *ptr = BinaryPrimitives.ReverseEndianness(*ptr);
-                    ptr++;
-                }
-            }
-
-            return values;
-        }
-
-        private static unsafe byte[] SwapRationalArrayToLittleEndian(byte[] values, uint count)
+        private static bool TryGetValueData(byte[] exifBytes, IFDEntry entry, int entryOffset, out ReadOnlyMemory<byte> valueData)
         {
-            // A rational value consists of two 4-byte values, a numerator and a denominator.
-            long itemCount = (long)count * 2;
+            long length = entry.Count * ExifValueTypeUtil.GetSizeInBytes(entry.Type);
 
-            fixed (byte* pBytes = values)
+            if (ExifValueTypeUtil.ValueFitsInOffsetField(entry.Type, entry.Count))
             {
-                uint* ptr = (uint*)pBytes;
-                uint* ptrEnd = ptr + itemCount;
-
-                while (ptr < ptrEnd)
-                {
-                    *ptr = BinaryPrimitives.ReverseEndianness(*ptr);
-                    ptr++;
-                }
+                // The value is stored in the first bytes of the offset field.
+                valueData = new ReadOnlyMemory<byte>(exifBytes, entryOffset + 8, (int)length);
+                return true;
             }
 
-            return values;
-        }
-
-        private static unsafe byte[] SwapDoubleArrayToLittleEndian(byte[] values, uint count)
-        {
-            fixed (byte* pBytes = values)
+            // Skip any tags that are empty, larger than 2 GB or that extend past the end of the buffer.
+            if (length == 0 || length > int.MaxValue || (entry.Offset + length) > exifBytes.Length)
             {
-                ulong* ptr = (ulong*)pBytes;
-                ulong* ptrEnd = ptr + count;
-
-                while (ptr < ptrEnd)
-                {
-                    *ptr = BinaryPrimitives.ReverseEndianness(*ptr);
-                    ptr++;
-                }
+                valueData = default;
+                return false;
             }
 
-            return values;
-        }
-
-        private readonly struct ParserIFDEntry
-        {
-            private readonly IFDEntry entry;
-            private readonly bool offsetIsBigEndian;
-
-            public ParserIFDEntry(EndianBinaryReader reader, ExifSection section)
-            {
-                entry = new IFDEntry(reader);
-                offsetIsBigEndian = reader.Endianess == Endianess.Big;
-                Section = section;
-            }
-
-            public ushort Tag => entry.Tag;
-
-            public ExifValueType Type => entry.Type;
-
-            public uint Count => entry.Count;
-
-            public uint Offset => entry.Offset;
-
-            public bool OffsetFieldContainsValue
-            {
-                get
-                {
-                    return ExifValueTypeUtil.ValueFitsInOffsetField(Type, Count);
-                }
-            }
-
-            public ExifSection Section { get; }
-
-            public unsafe byte[]? GetValueBytesFromOffset()
-            {
-                if (!OffsetFieldContainsValue)
-                {
-                    return null;
-                }
-
-                ExifValueType type = entry.Type;
-                uint count = entry.Count;
-                uint offset = entry.Offset;
-
-                if (count == 0)
-                {
-                    return Array.Empty<byte>();
-                }
-
-                // Paint.NET always stores data in little-endian byte order.
-                byte[] bytes;
-                if (type == ExifValueType.Byte
-                    || type == ExifValueType.Ascii
-                    || type == (ExifValueType)6 // SByte
-                    || type == ExifValueType.Undefined)
-                {
-                    bytes = new byte[count];
-
-                    if (offsetIsBigEndian)
-                    {
-                        switch (count)
-                        {
-                            case 1:
-                                bytes[0] = (byte)((offset >> 24) & 0x000000ff);
-                                break;
-                            case 2:
-                                bytes[0] = (byte)((offset >> 24) & 0x000000ff);
-                                bytes[1] = (byte)((offset >> 16) & 0x000000ff);
-                                break;
-                            case 3:
-                                bytes[0] = (byte)((offset >> 24) & 0x000000ff);
-                                bytes[1] = (byte)((offset >> 16) & 0x000000ff);
-                                bytes[2] = (byte)((offset >> 8) & 0x000000ff);
-                                break;
-                            case 4:
-                                bytes[0] = (byte)((offset >> 24) & 0x000000ff);
-                                bytes[1] = (byte)((offset >> 16) & 0x000000ff);
-                                bytes[2] = (byte)((offset >> 8) & 0x000000ff);
-                                bytes[3] = (byte)(offset & 0x000000ff);
-                                break;
-                        }
-                    }
-                    else
-                    {
-                        switch (count)
-                        {
-                            case 1:
-                                bytes[0] = (byte)(offset & 0x000000ff);
-                                break;
-                            case 2:
-                                bytes[0] = (byte)(offset & 0x000000ff);
-                                bytes[1] = (byte)((offset >> 8) & 0x000000ff);
-                                break;
-                            case 3:
-                                bytes[0] = (byte)(offset & 0x000000ff);
-                                bytes[1] = (byte)((offset >> 8) & 0x000000ff);
-                                bytes[2] = (byte)((offset >> 16) & 0x000000ff);
-                                break;
-                            case 4:
-                                bytes[0] = (byte)(offset & 0x000000ff);
-                                bytes[1] = (byte)((offset >> 8) & 0x000000ff);
-                                bytes[2] = (byte)((offset >> 16) & 0x000000ff);
-                                bytes[3] = (byte)((offset >> 24) & 0x000000ff);
-                                break;
-                        }
-                    }
-                }
-                else if (type == ExifValueType.Short || type == ExifValueType.SShort)
-                {
-                    int byteArrayLength = unchecked((int)count) * sizeof(ushort);
-                    bytes = new byte[byteArrayLength];
-
-                    fixed (byte* ptr = bytes)
-                    {
-                        ushort* ushortPtr = (ushort*)ptr;
-
-                        if (offsetIsBigEndian)
-                        {
-                            switch (count)
-                            {
-                                case 1:
-                                    ushortPtr[0] = (ushort)((offset >> 16) & 0x0000ffff);
-                                    break;
-                                case 2:
-                                    ushortPtr[0] = (ushort)((offset >> 16) & 0x0000ffff);
-                                    ushortPtr[1] = (ushort)(offset & 0x0000ffff);
-                                    break;
-                            }
-                        }
-                        else
-                        {
-                            switch (count)
-                            {
-                                case 1:
-                                    ushortPtr[0] = (ushort)(offset & 0x0000ffff);
-                                    break;
-                                case 2:
-                                    ushortPtr[0] = (ushort)(offset & 0x0000ffff);
-                                    ushortPtr[1] = (ushort)((offset >> 16) & 0x0000ffff);
-                                    break;
-                            }
-                        }
-                    }
-                }
-                else
-                {
-                    bytes = new byte[4];
-
-                    fixed (byte* ptr = bytes)
-                    {
-                        // The offset is stored as little-endian in memory.
-                        *(uint*)ptr = offset;
-                    }
-                }
-
-                return bytes;
-            }
-
-            public override string ToString()
-            {
-                if (OffsetFieldContainsValue)
-                {
-                    return string.Format("Tag={0}, Type={1}, Count={2}, Value={3}",
-                                         entry.Tag.ToString(CultureInfo.InvariantCulture),
-                                         entry.Type.ToString(),
-                                         entry.Count.ToString(CultureInfo.InvariantCulture),
-                                         GetValueStringFromOffset());
-                }
-                else
-                {
-                    return string.Format("Tag={0}, Type={1}, Count={2}, Offset=0x{3}",
-                                         entry.Tag.ToString(CultureInfo.InvariantCulture),
-                                         entry.Type.ToString(),
-                                         entry.Count.ToString(CultureInfo.InvariantCulture),
-                                         entry.Offset.ToString("X", CultureInfo.InvariantCulture));
-                }
-            }
-
-            private string GetValueStringFromOffset()
-            {
-                string valueString;
-
-                ExifValueType type = entry.Type;
-                uint count = entry.Count;
-                uint offset = entry.Offset;
-
-                if (count == 0)
-                {
-                    return string.Empty;
-                }
-
-                int typeSizeInBytes = ExifValueTypeUtil.GetSizeInBytes(type);
-
-                if (typeSizeInBytes == 1)
-                {
-                    byte[] bytes = new byte[count];
-
-                    if (offsetIsBigEndian)
-                    {
-                        switch (count)
-                        {
-                            case 1:
-                                bytes[0] = (byte)((offset >> 24) & 0x000000ff);
-                                break;
-                            case 2:
-                                bytes[0] = (byte)((offset >> 24) & 0x000000ff);
-                                bytes[1] = (byte)((offset >> 16) & 0x000000ff);
-                                break;
-                            case 3:
-                                bytes[0] = (byte)((offset >> 24) & 0x000000ff);
-                                bytes[1] = (byte)((offset >> 16) & 0x000000ff);
-                                bytes[2] = (byte)((offset >> 8) & 0x000000ff);
-                                break;
-                            case 4:
-                                bytes[0] = (byte)((offset >> 24) & 0x000000ff);
-                                bytes[1] = (byte)((offset >> 16) & 0x000000ff);
-                                bytes[2] = (byte)((offset >> 8) & 0x000000ff);
-                                bytes[3] = (byte)(offset & 0x000000ff);
-                                break;
-                        }
-                    }
-                    else
-                    {
-                        switch (count)
-                        {
-                            case 1:
-                                bytes[0] = (byte)(offset & 0x000000ff);
-                                break;
-                            case 2:
-                                bytes[0] = (byte)(offset & 0x000000ff);
-                                bytes[1] = (byte)((offset >> 8) & 0x000000ff);
-                                break;
-                            case 3:
-                                bytes[0] = (byte)(offset & 0x000000ff);
-                                bytes[1] = (byte)((offset >> 8) & 0x000000ff);
-                                bytes[2] = (byte)((offset >> 16) & 0x000000ff);
-                                break;
-                            case 4:
-                                bytes[0] = (byte)(offset & 0x000000ff);
-                                bytes[1] = (byte)((offset >> 8) & 0x000000ff);
-                                bytes[2] = (byte)((offset >> 16) & 0x000000ff);
-                                bytes[3] = (byte)((offset >> 24) & 0x000000ff);
-                                break;
-                        }
-                    }
-
-                    if (type == ExifValueType.Ascii)
-                    {
-                        valueString = Encoding.UTF8.GetString(bytes).TrimEnd('\0');
-                    }
-                    else if (count == 1)
-                    {
-                        valueString = bytes[0].ToString(CultureInfo.InvariantCulture);
-                    }
-                    else
-                    {
-                        StringBuilder builder = new();
-
-                        uint lastItemIndex = count - 1;
-
-                        for (int i = 0; i < count; i++)
-                        {
-                            builder.Append(bytes[i].ToString(CultureInfo.InvariantCulture));
-
-                            if (i < lastItemIndex)
-                            {
-                                builder.Append(',');
-                            }
-                        }
-
-                        valueString = builder.ToString();
-                    }
-                }
-                else if (typeSizeInBytes == 2)
-                {
-                    ushort[] values = new ushort[count];
-                    if (offsetIsBigEndian)
-                    {
-                        switch (count)
-                        {
-                            case 1:
-                                values[0] = (ushort)((offset >> 16) & 0x0000ffff);
-                                break;
-                            case 2:
-                                values[0] = (ushort)((offset >> 16) & 0x0000ffff);
-                                values[1] = (ushort)(offset & 0x0000ffff);
-                                break;
-                        }
-                    }
-                    else
-                    {
-                        switch (count)
-                        {
-                            case 1:
-                                values[0] = (ushort)(offset & 0x0000ffff);
-                                break;
-                            case 2:
-                                values[0] = (ushort)(offset & 0x0000ffff);
-                                values[1] = (ushort)((offset >> 16) & 0x0000ffff);
-                                break;
-                        }
-                    }
-
-                    if (count == 1)
-                    {
-                        switch (type)
-                        {
-                            case ExifValueType.SShort:
-                                valueString = ((short)values[0]).ToString(CultureInfo.InvariantCulture);
-                                break;
-                            case ExifValueType.Short:
-                            default:
-                                valueString = values[0].ToString(CultureInfo.InvariantCulture);
-                                break;
-                        }
-                    }
-                    else
-                    {
-                        switch (type)
-                        {
-                            case ExifValueType.SShort:
-                                valueString = ((short)values[0]).ToString(CultureInfo.InvariantCulture) + "," +
-                                              ((short)values[1]).ToString(CultureInfo.InvariantCulture);
-                                break;
-                            case ExifValueType.Short:
-                            default:
-                                valueString = values[0].ToString(CultureInfo.InvariantCulture) + "," +
-                                              values[1].ToString(CultureInfo.InvariantCulture);
-                                break;
-                        }
-                    }
-                }
-                else
-                {
-                    valueString = offset.ToString(CultureInfo.InvariantCulture);
-                }
-
-                return valueString;
-            }
+            valueData = new ReadOnlyMemory<byte>(exifBytes, (int)entry.Offset, (int)length);
+            return true;
         }
 
         private readonly struct MetadataOffset
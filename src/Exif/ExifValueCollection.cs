@@ -23,9 +23,9 @@ namespace WebPFileType.Exif
     [DebuggerTypeProxy(typeof(ExifValueCollectionDebugView))]
     internal sealed class ExifValueCollection : IEnumerable<KeyValuePair<ExifPropertyPath, ExifValue>>
     {
-        private readonly Dictionary<ExifPropertyPath, ExifValue> exifMetadata;
+        private readonly Dictionary<ExifPropertyPath, ParsedExifValue> exifMetadata;
 
-        public ExifValueCollection(Dictionary<ExifPropertyPath, ExifValue> items)
+        public ExifValueCollection(Dictionary<ExifPropertyPath, ParsedExifValue> items)
         {
             exifMetadata = items ?? throw new ArgumentNullException(nameof(items));
         }
@@ -34,17 +34,21 @@ namespace WebPFileType.Exif
 
         public ExifValue? GetAndRemoveValue(ExifPropertyPath key)
         {
-            return exifMetadata.Remove(key, out ExifValue? value) ? value : null;
+            return exifMetadata.Remove(key, out ParsedExifValue value) ? value.ToExifValue() : null;
         }
 
         public IEnumerator<KeyValuePair<ExifPropertyPath, ExifValue>> GetEnumerator()
         {
-            return exifMetadata.GetEnumerator();
+            // The values are converted as they are enumerated.
+            foreach (KeyValuePair<ExifPropertyPath, ParsedExifValue> item in exifMetadata)
+            {
+                yield return new KeyValuePair<ExifPropertyPath, ExifValue>(item.Key, item.Value.ToExifValue());
+            }
         }
 
         IEnumerator IEnumerable.GetEnumerator()
         {
-            return exifMetadata.GetEnumerator();
+            return GetEnumerator();
         }
 
         private sealed class ExifValueCollectionDebugView
@@ -61,7 +65,7 @@ namespace WebPFileType.Exif
             {
                 get
                 {
-                    return collection.exifMetadata.ToArray();
+                    return collection.ToArray();
                 }
             }
         }
@@ -13,9 +13,8 @@
 using PaintDotNet;
 using PaintDotNet.Imaging;
 using System;
+using System.Buffers.Binary;
 using System.Collections.Generic;
-using System.IO;
-using System.Linq;
 
 namespace WebPFileType.Exif
 {
@@ -79,62 +78,55 @@ namespace WebPFileType.Exif
             IFDInfo ifdInfo = BuildIFDEntries();
             Dictionary<ExifSection, IFDEntryInfo> ifdEntries = ifdInfo.IFDEntries;
 
+            // The section offsets are known up front, so the blob is written in place into
+            // an exact-size buffer that the native encoder reads directly.
             byte[] exifBytes = new byte[checked((int)ifdInfo.EXIFDataLength)];
+            Span<byte> buffer = exifBytes;
 
-            using (MemoryStream stream = new(exifBytes))
-            using (BinaryWriter writer = new(stream))
-            {
-                IFDEntryInfo imageInfo = ifdEntries[ExifSection.Image];
-                IFDEntryInfo exifInfo = ifdEntries[ExifSection.Photo];
+            IFDEntryInfo imageInfo = ifdEntries[ExifSection.Image];
+            IFDEntryInfo exifInfo = ifdEntries[ExifSection.Photo];
 
-                writer.Write(TiffConstants.LittleEndianByteOrderMarker);
-                writer.Write(TiffConstants.Signature);
-                writer.Write((uint)imageInfo.StartOffset);
+            TiffConstants.LittleEndianByteOrderMarker.CopyTo(buffer);
+            BinaryPrimitives.WriteUInt16LittleEndian(buffer.Slice(2), TiffConstants.Signature);
+            BinaryPrimitives.WriteUInt32LittleEndian(buffer.Slice(4), (uint)imageInfo.StartOffset);
 
-                WriteDirectory(writer, metadata[ExifSection.Image], imageInfo.IFDEntries, imageInfo.StartOffset);
-                WriteDirectory(writer, metadata[ExifSection.Photo], exifInfo.IFDEntries, exifInfo.StartOffset);
+            WriteDirectory(buffer, metadata[ExifSection.Image], imageInfo.IFDEntries, imageInfo.StartOffset);
+            WriteDirectory(buffer, metadata[ExifSection.Photo], exifInfo.IFDEntries, exifInfo.StartOffset);
 
-                if (ifdEntries.TryGetValue(ExifSection.Interop, out IFDEntryInfo? interopInfo))
-                {
-                    WriteDirectory(writer, metadata[ExifSection.Interop], interopInfo.IFDEntries, interopInfo.StartOffset);
-                }
+            if (ifdEntries.TryGetValue(ExifSection.Interop, out IFDEntryInfo? interopInfo))
+            {
+                WriteDirectory(buffer, metadata[ExifSection.Interop], interopInfo.IFDEntries, interopInfo.StartOffset);
+            }
 
-                if (ifdEntries.TryGetValue(ExifSection.GpsInfo, out IFDEntryInfo? gpsInfo))
-                {
-                    WriteDirectory(writer, metadata[ExifSection.GpsInfo], gpsInfo.IFDEntries, gpsInfo.StartOffset);
-                }
+            if (ifdEntries.TryGetValue(ExifSection.GpsInfo, out IFDEntryInfo? gpsInfo))
+            {
+                WriteDirectory(buffer, metadata[ExifSection.GpsInfo], gpsInfo.IFDEntries, gpsInfo.StartOffset);
             }
 
             return exifBytes;
         }
 
-        private static void WriteDirectory(BinaryWriter writer, Dictionary<ushort, ExifValue> tags,  List<IFDEntry> entries, long ifdOffset)
+        private static void WriteDirectory(Span<byte> buffer, Dictionary<ushort, ExifValue> tags, List<IFDEntry> entries, long ifdOffset)
         {
-            writer.BaseStream.Position = ifdOffset;
-
-            long nextIFDPointerOffset = ifdOffset + sizeof(ushort) + ((long)entries.Count * IFDEntry.SizeOf);
+            Span<byte> directory = buffer.Slice(checked((int)ifdOffset));
 
-            writer.Write((ushort)entries.Count);
+            BinaryPrimitives.WriteUInt16LittleEndian(directory, (ushort)entries.Count);
+            directory = directory.Slice(sizeof(ushort));
 
-            foreach (IFDEntry entry in entries.OrderBy(e => e.Tag))
+            // The entries are already sorted by tag, see CreateIFDList.
+            foreach (IFDEntry entry in entries)
             {
-                entry.Write(writer);
+                entry.Write(directory);
+                directory = directory.Slice(IFDEntry.SizeOf);
 
                 if (!ExifValueTypeUtil.ValueFitsInOffsetField(entry.Type, entry.Count))
                 {
-                    long oldPosition = writer.BaseStream.Position;
-
-                    writer.BaseStream.Position = entry.Offset;
-
-                    writer.Write(tags[entry.Tag].Data.AsArrayOrToArray());
-
-                    writer.BaseStream.Position = oldPosition;
+                    tags[entry.Tag].Data.CopyTo(buffer.Slice(checked((int)entry.Offset)));
                 }
             }
 
-            writer.BaseStream.Position = nextIFDPointerOffset;
             // There is only one IFD in this directory.
-            writer.Write(0);
+            BinaryPrimitives.WriteUInt32LittleEndian(directory, 0);
         }
 
         private IFDInfo BuildIFDEntries()
@@ -246,10 +238,14 @@ namespace WebPFileType.Exif
             // Leave room for the tag count, tags and next IFD offset.
             long ifdDataOffset = startOffset + sizeof(ushort) + ((long)tags.Count * IFDEntry.SizeOf) + sizeof(uint);
 
-            foreach (KeyValuePair<ushort, ExifValue> item in tags.OrderBy(i => i.Key))
+            ushort[] tagIDs = [.. tags.Keys];
+            Array.Sort(tagIDs);
+
+            Span<byte> packedBytes = stackalloc byte[sizeof(uint)];
+
+            foreach (ushort tagID in tagIDs)
             {
-                ushort tagID = item.Key;
-                ExifValue entry = item.Value;
+                ExifValue entry = tags[tagID];
 
                 uint lengthInBytes = (uint)entry.Data.Count;
 
@@ -291,30 +287,16 @@ namespace WebPFileType.Exif
                     {
                         IReadOnlyList<byte> data = entry.Data;
 
-                        // The data is always in little-endian byte order.
-                        switch (data.Count)
+                        if (data.Count > sizeof(uint))
                         {
-                            case 1:
-                                packedOffset |= data[0];
-                                break;
-                            case 2:
-                                packedOffset |= data[0];
-                                packedOffset |= (uint)data[1] << 8;
-                                break;
-                            case 3:
-                                packedOffset |= data[0];
-                                packedOffset |= (uint)data[1] << 8;
-                                packedOffset |= (uint)data[2] << 16;
-                                break;
-                            case 4:
-                                packedOffset |= data[0];
-                                packedOffset |= (uint)data[1] << 8;
-                                packedOffset |= (uint)data[2] << 16;
-                                packedOffset |= (uint)data[3] << 24;
-                                break;
-                            default:
-                                throw new InvalidOperationException("data.Count must be in the range of [1-4].");
+                            throw new InvalidOperationException("data.Count must be in the range of [1-4].");
                         }
+
+                        // The data is always in little-endian byte order.
+                        packedBytes.Clear();
+                        data.CopyTo(packedBytes);
+
+                        packedOffset = BinaryPrimitives.ReadUInt32LittleEndian(packedBytes);
                     }
 
                     ifdEntries.Add(new IFDEntry(tagID, entry.Type, count, packedOffset));
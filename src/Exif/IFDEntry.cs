@@ -12,6 +12,7 @@
 
 using PaintDotNet.Imaging;
 using System;
+using System.Buffers.Binary;
 
 namespace WebPFileType.Exif
 {
@@ -19,14 +20,6 @@ namespace WebPFileType.Exif
     {
         public const int SizeOf = 12;
 
-        public IFDEntry(EndianBinaryReader reader)
-        {
-            Tag = reader.ReadUInt16();
-            Type = (ExifValueType)reader.ReadInt16();
-            Count = reader.ReadUInt32();
-            Offset = reader.ReadUInt32();
-        }
-
         public IFDEntry(ushort tag, ExifValueType type, uint count, uint offset)
         {
             Tag = tag;
@@ -71,12 +64,12 @@ namespace WebPFileType.Exif
             return hashCode;
         }
 
-        public void Write(System.IO.BinaryWriter writer)
+        public void Write(Span<byte> destination)
         {
-            writer.Write(Tag);
-            writer.Write((ushort)Type);
-            writer.Write(Count);
-            writer.Write(Offset);
+            BinaryPrimitives.WriteUInt16LittleEndian(destination, Tag);
+            BinaryPrimitives.WriteUInt16LittleEndian(destination.Slice(2), (ushort)Type);
+            BinaryPrimitives.WriteUInt32LittleEndian(destination.Slice(4), Count);
+            BinaryPrimitives.WriteUInt32LittleEndian(destination.Slice(8), Offset);
         }
 
         public static bool operator ==(IFDEntry left, IFDEntry right)
@@ -11,68 +11,162 @@
 ////////////////////////////////////////////////////////////////////////
 
 using PaintDotNet;
+using System;
+using System.Runtime.CompilerServices;
+using System.Runtime.Intrinsics;
+using System.Runtime.Intrinsics.Arm;
+using System.Runtime.Intrinsics.X86;
+using System.Threading.Tasks;
 
 namespace WebPFileType.Exif
 {
     internal static class ImageTransform
     {
+        // The rotations are processed in square tiles so that the source rows and the
+        // destination rows that a tile touches stay in the cache.
+        private const int TileSize = 64;
+        private const int BlockSize = 4;
+
+        private static bool IsVectorized => Sse2.IsSupported || AdvSimd.Arm64.IsSupported;
+
         internal static unsafe void FlipHorizontal(Surface surface)
         {
-            int lastColumn = surface.Width - 1;
-            int flipWidth = surface.Width / 2;
+            int width = surface.Width;
 
-            for (int y = 0; y < surface.Height; y++)
+            Parallel.For(0, surface.Height, y =>
             {
-                for (int x = 0; x < flipWidth; x++)
-                {
-                    int sampleColumn = lastColumn - x;
-
-                    (surface[sampleColumn, y], surface[x, y]) = (surface[x, y], surface[sampleColumn, y]);
-                }
-            }
+                new Span<uint>(surface.GetRowPointerUnchecked(y), width).Reverse();
+            });
         }
 
         internal static unsafe void FlipVertical(Surface surface)
         {
+            int width = surface.Width;
             int lastRow = surface.Height - 1;
-            int flipHeight = surface.Height / 2;
 
-            for (int x = 0; x < surface.Width; x++)
+            Parallel.For(0, surface.Height / 2, y =>
             {
-                for (int y = 0; y < flipHeight; y++)
-                {
-                    int sampleRow = lastRow - y;
+                SwapPixels((uint*)surface.GetRowPointerUnchecked(y),
+                           (uint*)surface.GetRowPointerUnchecked(lastRow - y),
+                           width);
+            });
+        }
 
-                    (surface[x, sampleRow], surface[x, y]) = (surface[x, y], surface[x, sampleRow]);
-                }
+        internal static unsafe void Rotate180(Surface surface)
+        {
+            int width = surface.Width;
+            int height = surface.Height;
+            int halfHeight = height / 2;
+
+            Parallel.For(0, halfHeight, y =>
+            {
+                Span<uint> top = new(surface.GetRowPointerUnchecked(y), width);
+                Span<uint> bottom = new(surface.GetRowPointerUnchecked(height - y - 1), width);
+
+                top.Reverse();
+                bottom.Reverse();
+                SwapPixels(top, bottom);
+            });
+
+            // The middle row must be handled separately if the height is odd.
+            if ((height & 1) == 1)
+            {
+                new Span<uint>(surface.GetRowPointerUnchecked(halfHeight), width).Reverse();
+            }
+        }
+
+        internal static void Rotate90CW(ref Surface surface)
+        {
+            if (surface.Width == surface.Height)
+            {
+                TransposeInPlace(surface);
+                FlipHorizontal(surface);
+            }
+            else
+            {
+                TransposeToNewSurface(ref surface, reverseRows: false, reverseColumns: true);
+            }
+        }
+
+        internal static void Rotate270CW(ref Surface surface)
+        {
+            // Rotating 270 degrees clockwise is equivalent to rotating 90 degrees counter-clockwise.
+
+            if (surface.Width == surface.Height)
+            {
+                TransposeInPlace(surface);
+                FlipVertical(surface);
+            }
+            else
+            {
+                TransposeToNewSurface(ref surface, reverseRows: true, reverseColumns: false);
             }
         }
 
-        internal static unsafe void Rotate90CW(ref Surface surface)
+        /// <summary>
+        /// Mirrors the image across its main diagonal.
+        /// </summary>
+        /// <remarks>
+        /// This is equivalent to rotating 90 degrees clockwise and flipping horizontally.
+        /// </remarks>
+        internal static void Transpose(ref Surface surface)
+        {
+            if (surface.Width == surface.Height)
+            {
+                TransposeInPlace(surface);
+            }
+            else
+            {
+                TransposeToNewSurface(ref surface, reverseRows: false, reverseColumns: false);
+            }
+        }
+
+        /// <summary>
+        /// Mirrors the image across its anti-diagonal.
+        /// </summary>
+        /// <remarks>
+        /// This is equivalent to rotating 270 degrees clockwise and flipping horizontally.
+        /// </remarks>
+        internal static void Transverse(ref Surface surface)
+        {
+            if (surface.Width == surface.Height)
+            {
+                TransposeInPlace(surface);
+                Rotate180(surface);
+            }
+            else
+            {
+                TransposeToNewSurface(ref surface, reverseRows: true, reverseColumns: true);
+            }
+        }
+
+        private static unsafe void TransposeToNewSurface(ref Surface surface, bool reverseRows, bool reverseColumns)
         {
             Surface? temp = null;
             try
             {
-                int newWidth = surface.Height;
-                int newHeight = surface.Width;
+                int width = surface.Width;
+                int height = surface.Height;
 
-                temp = new Surface(newWidth, newHeight);
+                // Every destination pixel is written, so the new surface does not need to be cleared.
+                temp = new Surface(height, width, SurfaceCreationFlags.DoNotZeroFillHint);
 
-                int lastColumn = newWidth - 1;
+                Surface source = surface;
+                Surface destination = temp;
+                int tileRowCount = (height + TileSize - 1) / TileSize;
 
-                for (int y = 0; y < newWidth; y++)
+                Parallel.For(0, tileRowCount, tileRow =>
                 {
-                    ColorBgra* srcPtr = surface.GetRowPointerUnchecked(y);
-                    ColorBgra* dstPtr = temp.GetPointPointerUnchecked(lastColumn - y, 0);
+                    int top = tileRow * TileSize;
+                    int bottom = Math.Min(top + TileSize, height);
 
-                    for (int x = 0; x < newHeight; x++)
+                    for (int left = 0; left < width; left += TileSize)
                     {
-                        *dstPtr = *srcPtr;
+                        int right = Math.Min(left + TileSize, width);
 
-                        srcPtr++;
-                        dstPtr += newWidth;
+                        TransposeTile(source, destination, left, top, right, bottom, reverseRows, reverseColumns);
                     }
-                }
+                });
 
                 surface.Dispose();
                 surface = temp;
@@ -84,79 +178,322 @@ namespace WebPFileType.Exif
             }
         }
 
-        internal static unsafe void Rotate180(Surface surface)
+        /// <summary>
+        /// Transposes the specified source tile into the destination surface.
+        /// </summary>
+        /// <remarks>
+        /// The source pixel at (x, y) is written to the destination row x and column y,
+        /// <paramref name="reverseRows"/> and <paramref name="reverseColumns"/> mirror the
+        /// destination row and column indices.
+        /// </remarks>
+        // The transforms run once per image, so the kernels are compiled with full optimization
+        // up front instead of starting in the unoptimized tier, which is several times slower.
+        [MethodImpl(MethodImplOptions.AggressiveOptimization)]
+        private static unsafe void TransposeTile(
+            Surface source,
+            Surface destination,
+            int left,
+            int top,
+            int right,
+            int bottom,
+            bool reverseRows,
+            bool reverseColumns)
         {
-            int width = surface.Width;
-            int height = surface.Height;
+            uint* srcScan0 = (uint*)source.GetRowPointerUnchecked(0);
+            uint* dstScan0 = (uint*)destination.GetRowPointerUnchecked(0);
+            nint srcStride = source.Stride / sizeof(uint);
+            nint dstStride = destination.Stride / sizeof(uint);
+            nint dstRowStep = reverseRows ? -dstStride : dstStride;
+            int lastDstRow = destination.Height - 1;
+            int lastDstColumn = destination.Width - 1;
 
-            int halfHeight = height / 2;
-            int lastColumn = width - 1;
+            int y = top;
 
-            for (int y = 0; y < halfHeight; y++)
+            for (; y <= bottom - BlockSize; y += BlockSize)
             {
-                ColorBgra* topPtr = surface.GetRowPointerUnchecked(y);
-                ColorBgra* bottomPtr = surface.GetPointPointerUnchecked(lastColumn, height - y - 1);
+                // Reading the source rows from the bottom up reverses each transposed destination span.
+                uint* srcRow = reverseColumns ? srcScan0 + ((y + BlockSize - 1) * srcStride) : srcScan0 + (y * srcStride);
+                nint srcRowStep = reverseColumns ? -srcStride : srcStride;
+                int dstColumn = reverseColumns ? lastDstColumn - (y + BlockSize - 1) : y;
 
-                for (int x = 0; x < width; x++)
+                int x = left;
+
+                for (; x <= right - BlockSize; x += BlockSize)
+                {
+                    int dstRow = reverseRows ? lastDstRow - x : x;
+
+                    TransposeBlock(srcRow + x, srcRowStep, dstScan0 + (dstRow * dstStride) + dstColumn, dstRowStep);
+                }
+
+                for (; x < right; x++)
                 {
-                    (*topPtr, *bottomPtr) = (*bottomPtr, *topPtr);
-                    topPtr++;
-                    bottomPtr--;
+                    int dstRow = reverseRows ? lastDstRow - x : x;
+                    uint* src = srcRow + x;
+                    uint* dst = dstScan0 + (dstRow * dstStride) + dstColumn;
+
+                    for (int i = 0; i < BlockSize; i++)
+                    {
+                        dst[i] = *src;
+                        src += srcRowStep;
+                    }
                 }
             }
 
-            // The middle row must be handled separately if the height is odd.
-            if ((height & 1) == 1)
+            for (; y < bottom; y++)
             {
-                int halfWidth = width / 2;
+                uint* srcRow = srcScan0 + (y * srcStride);
+                int dstColumn = reverseColumns ? lastDstColumn - y : y;
 
-                ColorBgra* leftPtr = surface.GetRowPointerUnchecked(halfHeight);
-                ColorBgra* rightPtr = surface.GetPointPointerUnchecked(lastColumn, halfHeight);
+                for (int x = left; x < right; x++)
+                {
+                    int dstRow = reverseRows ? lastDstRow - x : x;
+
+                    dstScan0[(dstRow * dstStride) + dstColumn] = srcRow[x];
+                }
+            }
+        }
 
-                for (int x = 0; x < halfWidth; x++)
+        private static unsafe void TransposeInPlace(Surface surface)
+        {
+            int size = surface.Width;
+            uint* scan0 = (uint*)surface.GetRowPointerUnchecked(0);
+            nint stride = surface.Stride / sizeof(uint);
+
+            int blockCount = size / BlockSize;
+            int blocksPerTile = TileSize / BlockSize;
+            int tileCount = (blockCount + blocksPerTile - 1) / blocksPerTile;
+
+            // Each tile above the diagonal is swapped with its mirror below the diagonal,
+            // so the tile rows can be processed independently.
+            Parallel.For(0, tileCount, tileRow =>
+            {
+                TransposeTileRowInPlace(scan0, stride, tileRow, tileCount, blockCount);
+            });
+
+            // The rows and columns that do not fill a whole block.
+            for (int y = blockCount * BlockSize; y < size; y++)
+            {
+                uint* row = scan0 + (y * stride);
+
+                for (int x = 0; x < y; x++)
                 {
-                    (*leftPtr, *rightPtr) = (*rightPtr, *leftPtr);
-                    leftPtr++;
-                    rightPtr--;
+                    uint* mirror = scan0 + (x * stride) + y;
+
+                    (row[x], *mirror) = (*mirror, row[x]);
                 }
             }
         }
 
-        internal static unsafe void Rotate270CW(ref Surface surface)
+        [MethodImpl(MethodImplOptions.AggressiveOptimization)]
+        private static unsafe void TransposeTileRowInPlace(uint* scan0, nint stride, int tileRow, int tileCount, int blockCount)
         {
-            // Rotating 270 degrees clockwise is equivalent to rotating 90 degrees counter-clockwise.
+            int blocksPerTile = TileSize / BlockSize;
+            int firstRowBlock = tileRow * blocksPerTile;
+            int lastRowBlock = Math.Min(firstRowBlock + blocksPerTile, blockCount);
 
-            Surface? temp = null;
-            try
+            for (int tileColumn = tileRow; tileColumn < tileCount; tileColumn++)
             {
-                int newWidth = surface.Height;
-                int newHeight = surface.Width;
+                int firstColumnBlock = tileColumn * blocksPerTile;
+                int lastColumnBlock = Math.Min(firstColumnBlock + blocksPerTile, blockCount);
 
-                temp = new Surface(newWidth, newHeight);
+                for (int i = firstRowBlock; i < lastRowBlock; i++)
+                {
+                    for (int j = Math.Max(firstColumnBlock, i); j < lastColumnBlock; j++)
+                    {
+                        uint* upper = scan0 + (i * BlockSize * stride) + (j * BlockSize);
 
-                int lastRow = newHeight - 1;
+                        if (i == j)
+                        {
+                            TransposeBlockInPlace(upper, stride);
+                        }
+                        else
+                        {
+                            uint* lower = scan0 + (j * BlockSize * stride) + (i * BlockSize);
 
-                for (int y = 0; y < newWidth; y++)
+                            SwapTransposeBlocks(upper, lower, stride);
+                        }
+                    }
+                }
+            }
+        }
+
+        [MethodImpl(MethodImplOptions.AggressiveInlining)]
+        private static unsafe void TransposeBlock(uint* src, nint srcStride, uint* dst, nint dstStride)
+        {
+            if (IsVectorized)
+            {
+                Transpose4x4(Vector128.Load(src),
+                             Vector128.Load(src + srcStride),
+                             Vector128.Load(src + (2 * srcStride)),
+                             Vector128.Load(src + (3 * srcStride)),
+                             out Vector128<uint> o0,
+                             out Vector128<uint> o1,
+                             out Vector128<uint> o2,
+                             out Vector128<uint> o3);
+
+                o0.Store(dst);
+                o1.Store(dst + dstStride);
+                o2.Store(dst + (2 * dstStride));
+                o3.Store(dst + (3 * dstStride));
+            }
+            else
+            {
+                for (int i = 0; i < BlockSize; i++)
                 {
-                    ColorBgra* srcPtr = surface.GetPointPointerUnchecked(0, y);
-                    ColorBgra* dstPtr = temp.GetPointPointerUnchecked(y, lastRow);
+                    for (int j = 0; j < BlockSize; j++)
+                    {
+                        dst[(j * dstStride) + i] = src[(i * srcStride) + j];
+                    }
+                }
+            }
+        }
 
-                    for (int x = 0; x < newHeight; x++)
+        [MethodImpl(MethodImplOptions.AggressiveInlining)]
+        private static unsafe void TransposeBlockInPlace(uint* block, nint stride)
+        {
+            if (IsVectorized)
+            {
+                TransposeBlock(block, stride, block, stride);
+            }
+            else
+            {
+                for (int i = 0; i < BlockSize; i++)
+                {
+                    for (int j = i + 1; j < BlockSize; j++)
                     {
-                        *dstPtr = *srcPtr;
+                        uint* a = block + (i * stride) + j;
+                        uint* b = block + (j * stride) + i;
 
-                        srcPtr++;
-                        dstPtr -= newWidth;
+                        (*a, *b) = (*b, *a);
                     }
                 }
+            }
+        }
 
-                surface.Dispose();
-                surface = temp;
-                temp = null;
+        [MethodImpl(MethodImplOptions.AggressiveInlining)]
+        private static unsafe void SwapTransposeBlocks(uint* a, uint* b, nint stride)
+        {
+            if (IsVectorized)
+            {
+                Transpose4x4(Vector128.Load(a),
+                             Vector128.Load(a + stride),
+                             Vector128.Load(a + (2 * stride)),
+                             Vector128.Load(a + (3 * stride)),
+                             out Vector128<uint> a0,
+                             out Vector128<uint> a1,
+                             out Vector128<uint> a2,
+                             out Vector128<uint> a3);
+                Transpose4x4(Vector128.Load(b),
+                             Vector128.Load(b + stride),
+                             Vector128.Load(b + (2 * stride)),
+                             Vector128.Load(b + (3 * stride)),
+                             out Vector128<uint> b0,
+                             out Vector128<uint> b1,
+                             out Vector128<uint> b2,
+                             out Vector128<uint> b3);
+
+                b0.Store(a);
+                b1.Store(a + stride);
+                b2.Store(a + (2 * stride));
+                b3.Store(a + (3 * stride));
+                a0.Store(b);
+                a1.Store(b + stride);
+                a2.Store(b + (2 * stride));
+                a3.Store(b + (3 * stride));
             }
-            finally
+            else
             {
-                temp?.Dispose();
+                for (int i = 0; i < BlockSize; i++)
+                {
+                    for (int j = 0; j < BlockSize; j++)
+                    {
+                        uint* x = a + (i * stride) + j;
+                        uint* y = b + (j * stride) + i;
+
+                        (*x, *y) = (*y, *x);
+                    }
+                }
+            }
+        }
+
+        [MethodImpl(MethodImplOptions.AggressiveInlining)]
+        private static void Transpose4x4(
+            Vector128<uint> r0,
+            Vector128<uint> r1,
+            Vector128<uint> r2,
+            Vector128<uint> r3,
+            out Vector128<uint> o0,
+            out Vector128<uint> o1,
+            out Vector128<uint> o2,
+            out Vector128<uint> o3)
+        {
+            if (Sse2.IsSupported)
+            {
+                Vector128<ulong> t0 = Sse2.UnpackLow(r0, r1).AsUInt64();
+                Vector128<ulong> t1 = Sse2.UnpackLow(r2, r3).AsUInt64();
+                Vector128<ulong> t2 = Sse2.UnpackHigh(r0, r1).AsUInt64();
+                Vector128<ulong> t3 = Sse2.UnpackHigh(r2, r3).AsUInt64();
+
+                o0 = Sse2.UnpackLow(t0, t1).AsUInt32();
+                o1 = Sse2.UnpackHigh(t0, t1).AsUInt32();
+                o2 = Sse2.UnpackLow(t2, t3).AsUInt32();
+                o3 = Sse2.UnpackHigh(t2, t3).AsUInt32();
+            }
+            else if (AdvSimd.Arm64.IsSupported)
+            {
+                Vector128<ulong> t0 = AdvSimd.Arm64.ZipLow(r0, r1).AsUInt64();
+                Vector128<ulong> t1 = AdvSimd.Arm64.ZipLow(r2, r3).AsUInt64();
+                Vector128<ulong> t2 = AdvSimd.Arm64.ZipHigh(r0, r1).AsUInt64();
+                Vector128<ulong> t3 = AdvSimd.Arm64.ZipHigh(r2, r3).AsUInt64();
+
+                o0 = AdvSimd.Arm64.ZipLow(t0, t1).AsUInt32();
+                o1 = AdvSimd.Arm64.ZipHigh(t0, t1).AsUInt32();
+                o2 = AdvSimd.Arm64.ZipLow(t2, t3).AsUInt32();
+                o3 = AdvSimd.Arm64.ZipHigh(t2, t3).AsUInt32();
+            }
+            else
+            {
+                throw new PlatformNotSupportedException();
+            }
+        }
+
+        private static unsafe void SwapPixels(uint* a, uint* b, int count)
+        {
+            SwapPixels(new Span<uint>(a, count), new Span<uint>(b, count));
+        }
+
+        [MethodImpl(MethodImplOptions.AggressiveOptimization)]
+        private static void SwapPixels(Span<uint> a, Span<uint> b)
+        {
+            int i = 0;
+
+            if (Vector256.IsHardwareAccelerated)
+            {
+                for (; i <= a.Length - Vector256<uint>.Count; i += Vector256<uint>.Count)
+                {
+                    Vector256<uint> va = Vector256.Create<uint>(a.Slice(i));
+                    Vector256<uint> vb = Vector256.Create<uint>(b.Slice(i));
+
+                    vb.CopyTo(a.Slice(i));
+                    va.CopyTo(b.Slice(i));
+                }
+            }
+
+            if (Vector128.IsHardwareAccelerated)
+            {
+                for (; i <= a.Length - Vector128<uint>.Count; i += Vector128<uint>.Count)
+                {
+                    Vector128<uint> va = Vector128.Create<uint>(a.Slice(i));
+                    Vector128<uint> vb = Vector128.Create<uint>(b.Slice(i));
+
+                    vb.CopyTo(a.Slice(i));
+                    va.CopyTo(b.Slice(i));
+                }
+            }
+
+            for (; i < a.Length; i++)
+            {
+                (a[i], b[i]) = (b[i], a[i]);
             }
         }
     }
@@ -43,8 +43,7 @@ namespace WebPFileType.Exif
                             break;
                         case TiffConstants.Orientation.LeftTop:
                             // Rotate 90 degrees clockwise and flip horizontally.
-                            ImageTransform.Rotate90CW(ref surface);
-                            ImageTransform.FlipHorizontal(surface);
+                            ImageTransform.Transpose(ref surface);
                             break;
                         case TiffConstants.Orientation.RightTop:
                             // Rotate 90 degrees clockwise.
@@ -52,8 +51,7 @@ namespace WebPFileType.Exif
                             break;
                         case TiffConstants.Orientation.RightBottom:
                             // Rotate 270 degrees clockwise and flip horizontally.
-                            ImageTransform.Rotate270CW(ref surface);
-                            ImageTransform.FlipHorizontal(surface);
+                            ImageTransform.Transverse(ref surface);
                             break;
                         case TiffConstants.Orientation.LeftBottom:
                             // Rotate 270 degrees clockwise.
@@ -0,0 +1,88 @@
+﻿////////////////////////////////////////////////////////////////////////
+//
+// This file is part of pdn-webp, a FileType plugin for Paint.NET
+// that loads and saves WebP images.
+//
+// Copyright (c) 2011-2026 Nicholas Hayes
+//
+// This file is licensed under the MIT License.
+// See LICENSE.txt for complete licensing and attribution information.
+//
+////////////////////////////////////////////////////////////////////////
+
+using PaintDotNet.Imaging;
+using System;
+using System.Buffers.Binary;
+using System.Globalization;
+using System.Runtime.InteropServices;
+
+namespace WebPFileType.Exif
+{
+    /// <summary>
+    /// An EXIF value that references its data in the original EXIF buffer.
+    /// </summary>
+    /// <remarks>
+    /// The data is only copied, and converted to little-endian, when <see cref="ToExifValue"/> is called.
+    /// </remarks>
+    internal readonly struct ParsedExifValue
+    {
+        private readonly ReadOnlyMemory<byte> data;
+        private readonly bool isBigEndian;
+
+        public ParsedExifValue(ExifValueType type, uint count, ReadOnlyMemory<byte> data, bool isBigEndian)
+        {
+            Type = type;
+            Count = count;
+            this.data = data;
+            this.isBigEndian = isBigEndian;
+        }
+
+        public ExifValueType Type { get; }
+
+        public uint Count { get; }
+
+        public ExifValue ToExifValue()
+        {
+            byte[] bytes = data.ToArray();
+
+            if (isBigEndian)
+            {
+                // Paint.NET converts all multi-byte numbers to little-endian.
+                switch (Type)
+                {
+                    case ExifValueType.Short:
+                    case ExifValueType.SShort:
+                        Span<ushort> shortValues = MemoryMarshal.Cast<byte, ushort>(bytes);
+                        BinaryPrimitives.ReverseEndianness(shortValues, shortValues);
+                        break;
+                    case ExifValueType.Long:
+                    case ExifValueType.SLong:
+                    case ExifValueType.Float:
+                    case (ExifValueType)13: // IFD
+                    case ExifValueType.Rational:
+                    case ExifValueType.SRational:
+                        // A rational value consists of two 4-byte values, a numerator and a denominator.
+                        Span<uint> longValues = MemoryMarshal.Cast<byte, uint>(bytes);
+                        BinaryPrimitives.ReverseEndianness(longValues, longValues);
+                        break;
+                    case ExifValueType.Double:
+                        Span<ulong> doubleValues = MemoryMarshal.Cast<byte, ulong>(bytes);
+                        BinaryPrimitives.ReverseEndianness(doubleValues, doubleValues);
+                        break;
+                    case ExifValueType.Byte:
+                    case ExifValueType.Ascii:
+                    case ExifValueType.Undefined:
+                    default:
+                        break;
+                }
+            }
+
+            return new ExifValue(Type, bytes);
+        }
+
+        public override string ToString()
+        {
+            return string.Format(CultureInfo.InvariantCulture, "Type={0}, Count={1}, Length={2}", Type, Count, data.Length);
+        }
+    }
+}
@@ -10,29 +10,34 @@
 //
 ////////////////////////////////////////////////////////////////////////
 
-using PaintDotNet;
+using System;
 using System.Collections.Generic;
 
 namespace WebPFileType.Exif
 {
     internal static class ReadOnlyListExtensions
     {
-        internal static T[] AsArrayOrToArray<T>(this IReadOnlyList<T> items)
+        internal static void CopyTo<T>(this IReadOnlyList<T> items, Span<T> destination)
         {
-            if (items is null)
-            {
-                ExceptionUtil.ThrowArgumentNullException(nameof(items));
-            }
-
-            T[]? asArray = items as T[];
+            ArgumentNullException.ThrowIfNull(items);
 
-            if (asArray is not null)
+            if (items is T[] asArray)
             {
-                return asArray;
+                asArray.CopyTo(destination);
             }
             else
             {
-                return [.. items];
+                int count = items.Count;
+
+                if (count > destination.Length)
+                {
+                    throw new ArgumentException("The destination is too small.", nameof(destination));
+                }
+
+                for (int i = 0; i < count; i++)
+                {
+                    destination[i] = items[i];
+                }
             }
         }
     }
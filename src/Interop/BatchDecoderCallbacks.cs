@@ -0,0 +1,124 @@
+﻿////////////////////////////////////////////////////////////////////////
+//
+// This file is part of pdn-webp, a FileType plugin for Paint.NET
+// that loads and saves WebP images.
+//
+// Copyright (c) 2011-2026 Nicholas Hayes
+//
+// This file is licensed under the MIT License.
+// See LICENSE.txt for complete licensing and attribution information.
+//
+////////////////////////////////////////////////////////////////////////
+
+using PaintDotNet;
+using System;
+using System.Runtime.CompilerServices;
+using System.Runtime.ExceptionServices;
+using System.Runtime.InteropServices;
+using System.Threading;
+
+namespace WebPFileType.Interop
+{
+    // The callbacks for WebPLoadBatch, these are called concurrently from the native thread pool.
+    // The native code receives a GCHandle to this class as the callback context.
+    // Each image in the batch only accesses the array elements at its own index.
+    internal sealed class BatchDecoderCallbacks
+    {
+        private readonly Surface?[] surfaces;
+        private readonly DecoderMetadata[] metadata;
+        private readonly ExceptionDispatchInfo?[] createImageErrors;
+        private readonly SurfacePool? surfacePool;
+
+        public BatchDecoderCallbacks(int count, SurfacePool? surfacePool)
+        {
+            this.surfacePool = surfacePool;
+            surfaces = new Surface?[count];
+            metadata = new DecoderMetadata[count];
+            createImageErrors = new ExceptionDispatchInfo?[count];
+
+            for (int i = 0; i < metadata.Length; i++)
+            {
+                metadata[i] = new DecoderMetadata();
+            }
+        }
+
+        [UnmanagedCallersOnly(CallConvs = new Type[] { typeof(CallConvStdcall) })]
+        public static unsafe void* CreateImage(nint context, nuint index, int width, int height, nuint* dataSize, int* stride)
+        {
+            BatchDecoderCallbacks callbacks = (BatchDecoderCallbacks)GCHandle.FromIntPtr(context).Target!;
+
+            return callbacks.CreateImage(index, width, height, out *dataSize, out *stride);
+        }
+
+        [UnmanagedCallersOnly(CallConvs = new Type[] { typeof(CallConvStdcall) })]
+        public static byte SetDecoderMetadata(nint context, nuint index, nint data, nuint size, MetadataType type)
+        {
+            BatchDecoderCallbacks callbacks = (BatchDecoderCallbacks)GCHandle.FromIntPtr(context).Target!;
+
+            return (byte)(((IDecoderMetadataNative)callbacks.metadata[index]).SetDecoderMetadata(data, size, type) ? 1 : 0);
+        }
+
+        public Exception? GetCallbackError(int index)
+        {
+            ExceptionDispatchInfo? errorInfo = createImageErrors[index] ?? ((IDecoderMetadataNative)metadata[index]).CallbackError;
+
+            return errorInfo?.SourceException;
+        }
+
+        public DecoderMetadata GetMetadata(int index) => metadata[index];
+
+        public Surface? GetSurface(int index) => Interlocked.Exchange(ref surfaces[index], null);
+
+        public void ReleaseSurface(int index)
+        {
+            Surface? released = GetSurface(index);
+
+            if (released != null)
+            {
+                if (surfacePool != null)
+                {
+                    surfacePool.Return(released);
+                }
+                else
+                {
+                    released.Dispose();
+                }
+            }
+        }
+
+        public void ReleaseSurfaces()
+        {
+            for (int i = 0; i < surfaces.Length; i++)
+            {
+                ReleaseSurface(i);
+            }
+        }
+
+        private unsafe void* CreateImage(nuint index, int width, int height, out nuint dataSize, out int stride)
+        {
+            dataSize = 0;
+            stride = 0;
+
+            // The metadata has already been delivered, so it can be parsed while the image is decoded.
+            metadata[index].BeginParse();
+
+            try
+            {
+                // The native decoder clears the area that the first frame of an animated image does not cover,
+                // so a pooled surface does not need to be cleared. A new surface is zero-filled by default.
+                Surface surface = surfacePool?.Rent(width, height) ?? new Surface(width, height);
+                surfaces[index] = surface;
+
+                stride = surface.Stride;
+                dataSize = (nuint)surface.Scan0.Length;
+
+                return surface.Scan0.VoidStar;
+            }
+            catch (Exception ex)
+            {
+                createImageErrors[index] = ExceptionDispatchInfo.Capture(ex);
+                return null;
+            }
+        }
+    }
+}
@@ -0,0 +1,100 @@
+﻿////////////////////////////////////////////////////////////////////////
+//
+// This file is part of pdn-webp, a FileType plugin for Paint.NET
+// that loads and saves WebP images.
+//
+// Copyright (c) 2011-2026 Nicholas Hayes
+//
+// This file is licensed under the MIT License.
+// See LICENSE.txt for complete licensing and attribution information.
+//
+////////////////////////////////////////////////////////////////////////
+
+using PaintDotNet;
+using System;
+using System.Runtime.CompilerServices;
+using System.Runtime.ExceptionServices;
+using System.Runtime.InteropServices;
+using System.Threading;
+
+namespace WebPFileType.Interop
+{
+    // The callbacks for WebPLoad, the native code receives a GCHandle to this class as the callback context.
+    internal sealed class DecoderCallbacks
+    {
+        private readonly SurfacePool? surfacePool;
+        private Surface? surface;
+
+        public DecoderCallbacks(SurfacePool? surfacePool)
+        {
+            this.surfacePool = surfacePool;
+            surface = null;
+            Metadata = new DecoderMetadata();
+            CallbackErrorInfo = null;
+        }
+
+        public ExceptionDispatchInfo? CallbackErrorInfo { get; private set; }
+
+        public DecoderMetadata Metadata { get; }
+
+        [UnmanagedCallersOnly(CallConvs = new Type[] { typeof(CallConvStdcall) })]
+        public static unsafe void* CreateImage(nint context, int width, int height, nuint* dataSize, int* stride)
+        {
+            DecoderCallbacks callbacks = (DecoderCallbacks)GCHandle.FromIntPtr(context).Target!;
+
+            return callbacks.CreateImage(width, height, out *dataSize, out *stride);
+        }
+
+        [UnmanagedCallersOnly(CallConvs = new Type[] { typeof(CallConvStdcall) })]
+        public static byte SetDecoderMetadata(nint context, nint data, nuint size, MetadataType type)
+        {
+            DecoderCallbacks callbacks = (DecoderCallbacks)GCHandle.FromIntPtr(context).Target!;
+
+            return (byte)(((IDecoderMetadataNative)callbacks.Metadata).SetDecoderMetadata(data, size, type) ? 1 : 0);
+        }
+
+        public Surface? GetSurface() => Interlocked.Exchange(ref surface, null);
+
+        public void ReleaseSurface()
+        {
+            Surface? released = GetSurface();
+
+            if (released != null)
+            {
+                if (surfacePool != null)
+                {
+                    surfacePool.Return(released);
+                }
+                else
+                {
+                    released.Dispose();
+                }
+            }
+        }
+
+        private unsafe void* CreateImage(int width, int height, out nuint dataSize, out int stride)
+        {
+            dataSize = 0;
+            stride = 0;
+
+            // The metadata has already been delivered, so it can be parsed while the image is decoded.
+            Metadata.BeginParse();
+
+            try
+            {
+                // The native decoder clears the area that the first frame of an animated image does not cover,
+                // so a pooled surface does not need to be cleared. A new surface is zero-filled by default.
+                surface = surfacePool?.Rent(width, height) ?? new Surface(width, height);
+                stride = surface.Stride;
+                dataSize = (nuint)surface.Scan0.Length;
+
+                return surface.Scan0.VoidStar;
+            }
+            catch (Exception ex)
+            {
+                CallbackErrorInfo = ExceptionDispatchInfo.Capture(ex);
+                return null;
+            }
+        }
+    }
+}
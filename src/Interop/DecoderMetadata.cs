@@ -10,9 +10,11 @@
 //
 ////////////////////////////////////////////////////////////////////////
 
+using PaintDotNet.Imaging;
 using System;
 using System.Diagnostics;
 using System.Runtime.ExceptionServices;
+using System.Threading.Tasks;
 using WebPFileType.Exif;
 
 namespace WebPFileType.Interop
@@ -24,6 +26,7 @@ namespace WebPFileType.Interop
         private byte[]? xmp;
         private ExceptionDispatchInfo? callbackErrorInfo;
         private readonly Lazy<ExifValueCollection?> parsedExifData;
+        private readonly Lazy<XmpPacket?> parsedXmpData;
 
         public DecoderMetadata()
         {
@@ -32,6 +35,7 @@ namespace WebPFileType.Interop
             xmp = null;
             callbackErrorInfo = null;
             parsedExifData = new Lazy<ExifValueCollection?>(ParseExifData);
+            parsedXmpData = new Lazy<XmpPacket?>(ParseXmpData);
         }
 
         unsafe bool IDecoderMetadataNative.SetDecoderMetadata(nint data, nuint size, MetadataType type)
@@ -77,7 +81,36 @@ namespace WebPFileType.Interop
 
         public byte[]? GetColorProfileBytes() => iccProfile;
 
-        public byte[]? GetXmpBytes() => xmp;
+        [DebuggerBrowsable(DebuggerBrowsableState.Never)]
+        public XmpPacket? Xmp => parsedXmpData.Value;
+
+        /// <summary>
+        /// Starts parsing the EXIF and XMP metadata on a thread pool thread.
+        /// </summary>
+        /// <remarks>
+        /// The native decoder delivers the metadata before it requests the output image, so calling
+        /// this from the create image callback lets the parsing run while the image is decoded.
+        /// The <see cref="Exif"/> and <see cref="Xmp"/> properties wait for the parsing to finish,
+        /// any parsing exception is thrown from those properties.
+        /// </remarks>
+        internal void BeginParse()
+        {
+            if (exif != null || xmp != null)
+            {
+                Task.Run(() =>
+                {
+                    try
+                    {
+                        _ = parsedExifData.Value;
+                        _ = parsedXmpData.Value;
+                    }
+                    catch (Exception)
+                    {
+                        // The Lazy caches the exception and rethrows it to the caller.
+                    }
+                });
+            }
+        }
 
         private ExifValueCollection? ParseExifData()
         {
@@ -90,5 +123,7 @@ namespace WebPFileType.Interop
 
             return data;
         }
+
+        private XmpPacket? ParseXmpData() => xmp != null ? XmpPacket.TryParse(xmp) : null;
     }
 }
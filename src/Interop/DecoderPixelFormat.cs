@@ -0,0 +1,24 @@
+﻿////////////////////////////////////////////////////////////////////////
+//
+// This file is part of pdn-webp, a FileType plugin for Paint.NET
+// that loads and saves WebP images.
+//
+// Copyright (c) 2011-2026 Nicholas Hayes
+//
+// This file is licensed under the MIT License.
+// See LICENSE.txt for complete licensing and attribution information.
+//
+////////////////////////////////////////////////////////////////////////
+
+namespace WebPFileType.Interop
+{
+    // The pixel format of the decoded image, libwebp writes it directly in its output stage.
+    // This must be kept in sync with the DecoderPixelFormat enumeration in WebPDecoder.h.
+    internal enum DecoderPixelFormat : int
+    {
+        Bgra = 0,
+        PremultipliedBgra,
+        Rgba,
+        PremultipliedRgba
+    }
+}
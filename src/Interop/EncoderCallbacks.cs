@@ -0,0 +1,63 @@
+﻿////////////////////////////////////////////////////////////////////////
+//
+// This file is part of pdn-webp, a FileType plugin for Paint.NET
+// that loads and saves WebP images.
+//
+// Copyright (c) 2011-2026 Nicholas Hayes
+//
+// This file is licensed under the MIT License.
+// See LICENSE.txt for complete licensing and attribution information.
+//
+////////////////////////////////////////////////////////////////////////
+
+using System;
+using System.IO;
+using System.Runtime.CompilerServices;
+using System.Runtime.ExceptionServices;
+using System.Runtime.InteropServices;
+
+namespace WebPFileType.Interop
+{
+    // The callbacks for WebPSave and WebPSaveToFile, the native code receives a GCHandle to this class as the callback context.
+    internal sealed class EncoderCallbacks
+    {
+        private readonly StreamIOHandler? handler;
+        private readonly WebPReportProgress? progressCallback;
+
+        public EncoderCallbacks(Stream? output, WebPReportProgress? progressCallback)
+        {
+            handler = output != null ? new StreamIOHandler(output) : null;
+            this.progressCallback = progressCallback;
+            ProgressErrorInfo = null;
+        }
+
+        public Exception? WriteException => handler?.WriteException;
+
+        public ExceptionDispatchInfo? ProgressErrorInfo { get; private set; }
+
+        [UnmanagedCallersOnly(CallConvs = new Type[] { typeof(CallConvStdcall) })]
+        public static WebPStatus WriteImage(nint context, nint image, nuint imageSize)
+        {
+            EncoderCallbacks callbacks = (EncoderCallbacks)GCHandle.FromIntPtr(context).Target!;
+
+            return callbacks.handler!.WriteImageCallback(image, imageSize);
+        }
+
+        [UnmanagedCallersOnly(CallConvs = new Type[] { typeof(CallConvStdcall) })]
+        public static byte ReportProgress(nint context, int progress)
+        {
+            EncoderCallbacks callbacks = (EncoderCallbacks)GCHandle.FromIntPtr(context).Target!;
+
+            try
+            {
+                return (byte)(callbacks.progressCallback!(progress) ? 1 : 0);
+            }
+            catch (Exception ex)
+            {
+                // Exceptions cannot propagate through the native code, the caller rethrows it after the encoder aborts.
+                callbacks.ProgressErrorInfo = ExceptionDispatchInfo.Capture(ex);
+                return 0;
+            }
+        }
+    }
+}
@@ -11,13 +11,12 @@
 ////////////////////////////////////////////////////////////////////////
 
 using System;
+using System.Buffers;
 using System.Runtime.InteropServices;
-using System.Runtime.InteropServices.Marshalling;
 
 namespace WebPFileType.Interop
 {
-    [NativeMarshalling(typeof(Marshaller))]
-    internal sealed partial class EncoderMetadata
+    internal sealed class EncoderMetadata
     {
         public ReadOnlyMemory<byte> iccProfile;
         public ReadOnlyMemory<byte> exif;
@@ -29,5 +28,56 @@ namespace WebPFileType.Interop
             exif = exifBytes;
             xmp = xmpBytes;
         }
+
+        /// <summary>
+        /// Pins the metadata buffers so that the native code can read them without a copy.
+        /// </summary>
+        /// <returns>The pinned buffers, which must be disposed after the native call returns.</returns>
+        internal PinnedNative Pin() => new(this);
+
+        // This must be kept in sync with the EncoderMetadata structure in WebPEncoder.h.
+        [StructLayout(LayoutKind.Sequential)]
+        internal struct Native
+        {
+            public nint iccProfile;
+            public nuint iccProfileSize;
+            public nint exif;
+            public nuint exifSize;
+            public nint xmp;
+            public nuint xmpSize;
+        }
+
+        internal readonly unsafe struct PinnedNative : IDisposable
+        {
+            private readonly MemoryHandle iccProfileHandle;
+            private readonly MemoryHandle exifHandle;
+            private readonly MemoryHandle xmpHandle;
+
+            public PinnedNative(EncoderMetadata metadata)
+            {
+                iccProfileHandle = metadata.iccProfile.Pin();
+                exifHandle = metadata.exif.Pin();
+                xmpHandle = metadata.xmp.Pin();
+
+                Value = new Native
+                {
+                    iccProfile = (nint)iccProfileHandle.Pointer,
+                    iccProfileSize = (nuint)metadata.iccProfile.Length,
+                    exif = (nint)exifHandle.Pointer,
+                    exifSize = (nuint)metadata.exif.Length,
+                    xmp = (nint)xmpHandle.Pointer,
+                    xmpSize = (nuint)metadata.xmp.Length
+                };
+            }
+
+            public Native Value { get; }
+
+            public void Dispose()
+            {
+                iccProfileHandle.Dispose();
+                exifHandle.Dispose();
+                xmpHandle.Dispose();
+            }
+        }
     }
 }
@@ -10,16 +10,85 @@
 //
 ////////////////////////////////////////////////////////////////////////
 
-using System.Runtime.InteropServices.Marshalling;
+using System.Runtime.InteropServices;
 
 namespace WebPFileType.Interop
 {
-    [NativeMarshalling(typeof(Marshaller))]
-    internal sealed partial class EncoderOptions
+    internal sealed class EncoderOptions
     {
         public float quality;
         public int effort;
         public WebPPreset preset;
         public bool lossless;
+
+        /// <summary>
+        /// Lets lossless images change the color of fully transparent pixels, lossy images always do.
+        /// </summary>
+        public bool cleanupTransparentArea;
+
+        /// <summary>
+        /// The lossy alpha quality, 0 (smallest) to 100 (lossless).
+        /// </summary>
+        public int alphaQuality = 100;
+
+        /// <summary>
+        /// The alpha filtering, 0 = none, 1 = fast, 2 = best, -1 to select it from the effort.
+        /// </summary>
+        public int alphaFiltering = -1;
+
+        /// <summary>
+        /// The alpha compression, 0 = none, 1 = lossless.
+        /// </summary>
+        public int alphaCompression = 1;
+
+        /// <summary>
+        /// The lossless preprocessing strength, 0 (off) to 100 (the most preprocessing).
+        /// </summary>
+        public int nearLosslessStrength;
+
+        /// <summary>
+        /// Reduces lossless images to 2 - 256 colors before encoding, 0 keeps all of the colors.
+        /// </summary>
+        public int paletteColors;
+
+        /// <summary>
+        /// Dithers the reduced colors.
+        /// </summary>
+        public bool paletteDither;
+
+        // This must be kept in sync with the EncoderOptions structure in WebPEncoder.h.
+        [StructLayout(LayoutKind.Sequential)]
+        internal struct Native
+        {
+            public float quality;
+            public int effort;
+            public int preset;
+            public byte lossless;
+            public byte cleanupTransparentArea;
+            public int alphaQualityReduction;
+            public int alphaFiltering;
+            public byte uncompressedAlpha;
+            public int nearLosslessStrength;
+            public int paletteColors;
+            public byte paletteDither;
+        }
+
+        internal Native ToNative()
+        {
+            return new Native
+            {
+                quality = quality,
+                effort = effort,
+                preset = (int)preset,
+                lossless = (byte)(lossless ? 1 : 0),
+                cleanupTransparentArea = (byte)(cleanupTransparentArea ? 1 : 0),
+                alphaQualityReduction = 100 - alphaQuality,
+                alphaFiltering = alphaFiltering + 1,
+                uncompressedAlpha = (byte)(alphaCompression == 0 ? 1 : 0),
+                nearLosslessStrength = nearLosslessStrength,
+                paletteColors = paletteColors,
+                paletteDither = (byte)(paletteDither ? 1 : 0)
+            };
+        }
     }
 }
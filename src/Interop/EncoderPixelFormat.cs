@@ -10,12 +10,15 @@
 //
 ////////////////////////////////////////////////////////////////////////
 
-using System;
-using System.Runtime.InteropServices;
-
 namespace WebPFileType.Interop
 {
-    [UnmanagedFunctionPointer(CallingConvention.StdCall)]
-    [return: MarshalAs(UnmanagedType.U1)]
-    internal delegate bool WebPSetDecoderMetadata(IntPtr image, UIntPtr imageSize, MetadataType type);
+    // The pixel format of the bitmap that is passed to the encoder.
+    // This must be kept in sync with the EncoderPixelFormat enumeration in WebPEncoder.h.
+    internal enum EncoderPixelFormat : int
+    {
+        Bgra = 0,
+        PremultipliedBgra,
+        Rgba,
+        Rgba64
+    }
 }
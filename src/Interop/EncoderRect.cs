@@ -14,6 +14,14 @@ using System.Runtime.InteropServices;
 
 namespace WebPFileType.Interop
 {
-    [UnmanagedFunctionPointer(CallingConvention.StdCall)]
-    internal unsafe delegate void* WebPCreateImage(int width, int height, out nuint outDataSize, out int outStride);
+    // The part of the image that is encoded.
+    // This must be kept in sync with the EncoderRect structure in WebPEncoder.h.
+    [StructLayout(LayoutKind.Sequential)]
+    internal struct EncoderRect
+    {
+        public int x;
+        public int y;
+        public int width;
+        public int height;
+    }
 }
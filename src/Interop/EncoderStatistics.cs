@@ -0,0 +1,52 @@
+﻿////////////////////////////////////////////////////////////////////////
+//
+// This file is part of pdn-webp, a FileType plugin for Paint.NET
+// that loads and saves WebP images.
+//
+// Copyright (c) 2011-2026 Nicholas Hayes
+//
+// This file is licensed under the MIT License.
+// See LICENSE.txt for complete licensing and attribution information.
+//
+////////////////////////////////////////////////////////////////////////
+
+using System.Runtime.InteropServices;
+
+namespace WebPFileType.Interop
+{
+    // This must be kept in sync with the EncoderStatistics structure in WebPEncoder.h.
+    [StructLayout(LayoutKind.Sequential)]
+    internal unsafe struct EncoderStatistics
+    {
+        public byte computeDistortion;
+
+        public int codedSize;
+        public fixed float psnr[5];             // Y/U/V/All/Alpha
+        public fixed int blockCount[3];         // intra4/intra16/skipped macroblocks
+        public fixed int headerBytes[2];        // header and mode-partition #0
+        public fixed int residualBytes[3 * 4];  // DC/AC/uv coefficients for each segment
+        public fixed int segmentSize[4];
+        public fixed int segmentQuant[4];
+        public fixed int segmentLevel[4];
+        public int alphaDataSize;
+        public uint losslessFeatures;
+        public int histogramBits;
+        public int transformBits;
+        public int cacheBits;
+        public int paletteSize;
+        public int losslessSize;
+        public int losslessHeaderSize;
+        public int losslessDataSize;
+
+        public fixed float distortionPsnr[5];   // B/G/R/A/All
+        public fixed float distortionSsim[5];   // B/G/R/A/All
+
+        public ulong fileSize;
+
+        public double importTime;
+        public double encodeTime;
+        public double muxTime;
+        public double writeTime;
+        public double distortionTime;
+    }
+}
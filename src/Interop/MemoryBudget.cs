@@ -0,0 +1,52 @@
+﻿////////////////////////////////////////////////////////////////////////
+//
+// This file is part of pdn-webp, a FileType plugin for Paint.NET
+// that loads and saves WebP images.
+//
+// Copyright (c) 2011-2026 Nicholas Hayes
+//
+// This file is licensed under the MIT License.
+// See LICENSE.txt for complete licensing and attribution information.
+//
+////////////////////////////////////////////////////////////////////////
+
+using System.Runtime.InteropServices;
+
+namespace WebPFileType.Interop
+{
+    internal sealed class MemoryBudget
+    {
+        /// <summary>
+        /// The maximum number of bytes that a decode or encode call may use, 0 for no limit.
+        /// </summary>
+        public ulong limit;
+
+        /// <summary>
+        /// Decoder only, downscale the image to fit within the limit instead of failing.
+        /// </summary>
+        public bool allowDownscale;
+
+        /// <summary>
+        /// The peak memory usage of the last call.
+        /// </summary>
+        public ulong peakUsage;
+
+        // This must be kept in sync with the MemoryBudget structure in MemoryTracker.h.
+        [StructLayout(LayoutKind.Sequential)]
+        internal struct Native
+        {
+            public ulong limit;
+            public byte allowDownscale;
+            public ulong peakUsage;
+        }
+
+        internal Native ToNative()
+        {
+            return new Native
+            {
+                limit = limit,
+                allowDownscale = (byte)(allowDownscale ? 1 : 0)
+            };
+        }
+    }
+}
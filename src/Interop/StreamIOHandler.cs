@@ -12,7 +12,6 @@
 
 using System;
 using System.IO;
-using System.Runtime.InteropServices;
 
 namespace WebPFileType.Interop
 {
@@ -27,7 +26,7 @@ namespace WebPFileType.Interop
 
         public Exception? WriteException { get; private set; }
 
-        public WebPStatus WriteImageCallback(IntPtr image, UIntPtr imageSize)
+        public unsafe WebPStatus WriteImageCallback(IntPtr image, UIntPtr imageSize)
         {
             if (image == IntPtr.Zero)
             {
@@ -40,32 +39,24 @@ namespace WebPFileType.Interop
                 return WebPStatus.Ok;
             }
 
-            // 81920 is the largest multiple of 4096 that is below the large object heap threshold.
-            const int MaxBufferSize = 81920;
-
             try
             {
                 long size = checked((long)imageSize.ToUInt64());
 
-                int bufferSize = (int)Math.Min(size, MaxBufferSize);
-
-                byte[] streamBuffer = new byte[bufferSize];
-
                 output.SetLength(size);
 
-                long offset = 0;
+                byte* source = (byte*)image;
                 long remaining = size;
 
+                // The stream reads directly from the native buffer, a span is limited to int.MaxValue bytes.
                 while (remaining > 0)
                 {
-                    int copySize = (int)Math.Min(MaxBufferSize, remaining);
-
-                    Marshal.Copy(new IntPtr(image.ToInt64() + offset), streamBuffer, 0, copySize);
+                    int writeSize = (int)Math.Min(remaining, int.MaxValue);
 
-                    output.Write(streamBuffer, 0, copySize);
+                    output.Write(new ReadOnlySpan<byte>(source, writeSize));
 
-                    offset += copySize;
-                    remaining -= copySize;
+                    source += writeSize;
+                    remaining -= writeSize;
                 }
             }
             catch (OperationCanceledException)
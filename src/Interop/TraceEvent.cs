@@ -0,0 +1,26 @@
+﻿////////////////////////////////////////////////////////////////////////
+//
+// This file is part of pdn-webp, a FileType plugin for Paint.NET
+// that loads and saves WebP images.
+//
+// Copyright (c) 2011-2026 Nicholas Hayes
+//
+// This file is licensed under the MIT License.
+// See LICENSE.txt for complete licensing and attribution information.
+//
+////////////////////////////////////////////////////////////////////////
+
+using System.Runtime.InteropServices;
+
+namespace WebPFileType.Interop
+{
+    // This must be kept in sync with the TraceEvent structure in Trace.h.
+    [StructLayout(LayoutKind.Sequential)]
+    internal struct TraceEvent
+    {
+        public ulong timestamp; // Monotonic time in nanoseconds.
+        public uint operationId;
+        public TracePhase phase;
+        public TraceEventType type;
+    }
+}
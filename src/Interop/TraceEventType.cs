@@ -10,11 +10,11 @@
 //
 ////////////////////////////////////////////////////////////////////////
 
-using System;
-using System.Runtime.InteropServices;
-
 namespace WebPFileType.Interop
 {
-    [UnmanagedFunctionPointer(CallingConvention.StdCall)]
-    internal delegate WebPStatus WebPWriteImage(IntPtr image, UIntPtr imageSize);
+    internal enum TraceEventType : int
+    {
+        Begin = 0,
+        End
+    }
 }
@@ -0,0 +1,30 @@
+﻿////////////////////////////////////////////////////////////////////////
+//
+// This file is part of pdn-webp, a FileType plugin for Paint.NET
+// that loads and saves WebP images.
+//
+// Copyright (c) 2011-2026 Nicholas Hayes
+//
+// This file is licensed under the MIT License.
+// See LICENSE.txt for complete licensing and attribution information.
+//
+////////////////////////////////////////////////////////////////////////
+
+namespace WebPFileType.Interop
+{
+    // This must be kept in sync with the TracePhase enumeration in Trace.h.
+    internal enum TracePhase : int
+    {
+        Decode = 0,
+        Demux,
+        CreateImageCallback,
+        DecodeImage,
+        SetMetadataCallback,
+        Encode,
+        TransparencyScan,
+        Import,
+        WebPEncode,
+        Mux,
+        WriteImageCallback
+    }
+}
@@ -0,0 +1,162 @@
+﻿////////////////////////////////////////////////////////////////////////
+//
+// This file is part of pdn-webp, a FileType plugin for Paint.NET
+// that loads and saves WebP images.
+//
+// Copyright (c) 2011-2026 Nicholas Hayes
+//
+// This file is licensed under the MIT License.
+// See LICENSE.txt for complete licensing and attribution information.
+//
+////////////////////////////////////////////////////////////////////////
+
+using System;
+using System.Reflection;
+using System.Runtime.CompilerServices;
+using System.Runtime.InteropServices;
+
+namespace WebPFileType.Interop
+{
+    // The native library imports, "WebP" is resolved to the DLL that matches the process architecture.
+    // All of the callbacks are [UnmanagedCallersOnly] methods that receive a GCHandle to their state as the context.
+    [System.Security.SuppressUnmanagedCodeSecurity]
+    internal static unsafe partial class WebP
+    {
+        private const string LibraryName = "WebP";
+
+        static WebP()
+        {
+            NativeLibrary.SetDllImportResolver(typeof(WebP).Assembly, ResolveLibrary);
+        }
+
+        [LibraryImport(LibraryName, EntryPoint = "GetLibWebPVersion")]
+        [UnmanagedCallConv(CallConvs = new Type[] { typeof(CallConvStdcall) })]
+        public static partial int GetLibWebPVersion();
+
+        [LibraryImport(LibraryName, EntryPoint = "WebPLoad")]
+        [UnmanagedCallConv(CallConvs = new Type[] { typeof(CallConvStdcall) })]
+        public static partial WebPStatus WebPLoad(byte* data,
+                                                  nuint dataSize,
+                                                  DecoderPixelFormat pixelFormat,
+                                                  delegate* unmanaged[Stdcall]<nint, int, int, nuint*, int*, void*> createImage,
+                                                  delegate* unmanaged[Stdcall]<nint, nint, nuint, MetadataType, byte> setDecoderMetadata,
+                                                  nint callbackContext,
+                                                  MemoryBudget.Native* memoryBudget);
+
+        [LibraryImport(LibraryName, EntryPoint = "WebPLoadBatch")]
+        [UnmanagedCallConv(CallConvs = new Type[] { typeof(CallConvStdcall) })]
+        public static partial WebPStatus WebPLoadBatch(nint* data,
+                                                       nuint* dataSizes,
+                                                       nuint count,
+                                                       DecoderPixelFormat pixelFormat,
+                                                       delegate* unmanaged[Stdcall]<nint, nuint, int, int, nuint*, int*, void*> createImage,
+                                                       delegate* unmanaged[Stdcall]<nint, nuint, nint, nuint, MetadataType, byte> setDecoderMetadata,
+                                                       nint callbackContext,
+                                                       WebPStatus* itemStatus);
+
+        [LibraryImport(LibraryName, EntryPoint = "WebPGetImageSize")]
+        [UnmanagedCallConv(CallConvs = new Type[] { typeof(CallConvStdcall) })]
+        public static partial WebPStatus WebPGetImageSize(byte* data, nuint dataSize, int* width, int* height);
+
+        [LibraryImport(LibraryName, EntryPoint = "WebPLoadInto")]
+        [UnmanagedCallConv(CallConvs = new Type[] { typeof(CallConvStdcall) })]
+        public static partial WebPStatus WebPLoadInto(byte* data,
+                                                      nuint dataSize,
+                                                      DecoderPixelFormat pixelFormat,
+                                                      void* output,
+                                                      nuint outputSize,
+                                                      int outputStride,
+                                                      int x,
+                                                      int y);
+
+        [LibraryImport(LibraryName, EntryPoint = "WebPSave")]
+        [UnmanagedCallConv(CallConvs = new Type[] { typeof(CallConvStdcall) })]
+        public static partial WebPStatus WebPSave(delegate* unmanaged[Stdcall]<nint, nint, nuint, WebPStatus> writeImage,
+                                                  nint scan0,
+                                                  int width,
+                                                  int height,
+                                                  int stride,
+                                                  EncoderPixelFormat pixelFormat,
+                                                  EncoderRect* cropRect,
+                                                  EncoderOptions.Native* options,
+                                                  EncoderMetadata.Native* metadata,
+                                                  delegate* unmanaged[Stdcall]<nint, int, byte> reportProgress,
+                                                  nint callbackContext,
+                                                  EncoderStatistics* statistics,
+                                                  MemoryBudget.Native* memoryBudget);
+
+        [LibraryImport(LibraryName, EntryPoint = "WebPSaveToFile")]
+        [UnmanagedCallConv(CallConvs = new Type[] { typeof(CallConvStdcall) })]
+        public static partial WebPStatus WebPSaveToFile(char* path,
+                                                        nint scan0,
+                                                        int width,
+                                                        int height,
+                                                        int stride,
+                                                        EncoderPixelFormat pixelFormat,
+                                                        EncoderRect* cropRect,
+                                                        EncoderOptions.Native* options,
+                                                        EncoderMetadata.Native* metadata,
+                                                        delegate* unmanaged[Stdcall]<nint, int, byte> reportProgress,
+                                                        nint callbackContext,
+                                                        EncoderStatistics* statistics,
+                                                        MemoryBudget.Native* memoryBudget);
+
+        [LibraryImport(LibraryName, EntryPoint = "WebPCreateEncodeQueue")]
+        [UnmanagedCallConv(CallConvs = new Type[] { typeof(CallConvStdcall) })]
+        public static partial WebPStatus WebPCreateEncodeQueue(uint threadCount, ulong memoryBudget, nint* queue);
+
+        [LibraryImport(LibraryName, EntryPoint = "WebPSubmitEncodeJob")]
+        [UnmanagedCallConv(CallConvs = new Type[] { typeof(CallConvStdcall) })]
+        public static partial WebPStatus WebPSubmitEncodeJob(nint queue,
+                                                             nint scan0,
+                                                             int width,
+                                                             int height,
+                                                             int stride,
+                                                             EncoderOptions.Native* options,
+                                                             EncoderMetadata.Native* metadata,
+                                                             delegate* unmanaged[Stdcall]<nint, nint, nuint, WebPStatus> writeImage,
+                                                             delegate* unmanaged[Stdcall]<nint, WebPStatus, void> completed,
+                                                             nint context);
+
+        [LibraryImport(LibraryName, EntryPoint = "WebPWaitEncodeQueue")]
+        [UnmanagedCallConv(CallConvs = new Type[] { typeof(CallConvStdcall) })]
+        public static partial void WebPWaitEncodeQueue(nint queue);
+
+        [LibraryImport(LibraryName, EntryPoint = "WebPDestroyEncodeQueue")]
+        [UnmanagedCallConv(CallConvs = new Type[] { typeof(CallConvStdcall) })]
+        public static partial void WebPDestroyEncodeQueue(nint queue);
+
+        [LibraryImport(LibraryName, EntryPoint = "WebPSetTraceEnabled")]
+        [UnmanagedCallConv(CallConvs = new Type[] { typeof(CallConvStdcall) })]
+        public static partial void WebPSetTraceEnabled(byte enabled);
+
+        [LibraryImport(LibraryName, EntryPoint = "WebPReadTraceEvents")]
+        [UnmanagedCallConv(CallConvs = new Type[] { typeof(CallConvStdcall) })]
+        public static partial nuint WebPReadTraceEvents(TraceEvent* events, nuint capacity);
+
+        [LibraryImport(LibraryName, EntryPoint = "GetWebPMetrics")]
+        [UnmanagedCallConv(CallConvs = new Type[] { typeof(CallConvStdcall) })]
+        public static partial void GetWebPMetrics(WebPMetrics* metrics);
+
+        [LibraryImport(LibraryName, EntryPoint = "ResetWebPMetrics")]
+        [UnmanagedCallConv(CallConvs = new Type[] { typeof(CallConvStdcall) })]
+        public static partial void ResetWebPMetrics();
+
+        private static nint ResolveLibrary(string libraryName, Assembly assembly, DllImportSearchPath? searchPath)
+        {
+            if (libraryName != LibraryName)
+            {
+                return 0;
+            }
+
+            string fileName = RuntimeInformation.ProcessArchitecture switch
+            {
+                Architecture.X64 => "WebP_x64.dll",
+                Architecture.Arm64 => "WebP_ARM64.dll",
+                _ => throw new PlatformNotSupportedException()
+            };
+
+            return NativeLibrary.Load(fileName, assembly, searchPath);
+        }
+    }
+}
@@ -0,0 +1,51 @@
+﻿////////////////////////////////////////////////////////////////////////
+//
+// This file is part of pdn-webp, a FileType plugin for Paint.NET
+// that loads and saves WebP images.
+//
+// Copyright (c) 2011-2026 Nicholas Hayes
+//
+// This file is licensed under the MIT License.
+// See LICENSE.txt for complete licensing and attribution information.
+//
+////////////////////////////////////////////////////////////////////////
+
+using System.Runtime.InteropServices;
+
+namespace WebPFileType.Interop
+{
+    // This must be kept in sync with the WebPMetrics structure in Metrics.h.
+    [StructLayout(LayoutKind.Sequential)]
+    internal unsafe struct WebPMetrics
+    {
+        public const int StatusCount = (int)WebPStatus.DecodeFailed + 1;
+        public const int EffortLevels = 10;
+        public const int MegapixelBuckets = 6;
+        public const int LatencyBuckets = 16;
+
+        public ulong imagesDecoded;
+        public ulong bytesDecoded;
+        public ulong pixelsDecoded;
+        public ulong imagesEncoded;
+        public ulong bytesEncoded;
+        public ulong pixelsEncoded;
+        public fixed ulong decodeFailures[StatusCount];
+        public fixed ulong encodeFailures[StatusCount];
+        public fixed ulong decodeLatency[MegapixelBuckets * LatencyBuckets];
+        public fixed ulong encodeLatency[2 * EffortLevels * MegapixelBuckets * LatencyBuckets];
+        public ulong peakDecodeTransientBytes;
+        public ulong peakEncodeTransientBytes;
+
+        public readonly ulong GetDecodeLatency(int megapixelBucket, int latencyBucket)
+        {
+            return decodeLatency[(megapixelBucket * LatencyBuckets) + latencyBucket];
+        }
+
+        public readonly ulong GetEncodeLatency(bool lossless, int effort, int megapixelBucket, int latencyBucket)
+        {
+            int mode = lossless ? 1 : 0;
+
+            return encodeLatency[(((((mode * EffortLevels) + effort) * MegapixelBuckets) + megapixelBucket) * LatencyBuckets) + latencyBucket];
+        }
+    }
+}
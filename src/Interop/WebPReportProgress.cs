@@ -10,11 +10,7 @@
 //
 ////////////////////////////////////////////////////////////////////////
 
-using System.Runtime.InteropServices;
-
 namespace WebPFileType.Interop
 {
-    [UnmanagedFunctionPointer(CallingConvention.StdCall)]
-    [return: MarshalAs(UnmanagedType.U1)]
     internal delegate bool WebPReportProgress(int progress);
 }
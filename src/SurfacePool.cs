@@ -0,0 +1,132 @@
+﻿////////////////////////////////////////////////////////////////////////
+//
+// This file is part of pdn-webp, a FileType plugin for Paint.NET
+// that loads and saves WebP images.
+//
+// Copyright (c) 2011-2026 Nicholas Hayes
+//
+// This file is licensed under the MIT License.
+// See LICENSE.txt for complete licensing and attribution information.
+//
+////////////////////////////////////////////////////////////////////////
+
+using PaintDotNet;
+using System;
+using System.Collections.Generic;
+
+namespace WebPFileType
+{
+    /// <summary>
+    /// A pool of reusable surfaces for the decoder.
+    /// </summary>
+    /// <remarks>
+    /// The surfaces are not cleared when they are created or reused. The native decoder writes the first frame
+    /// to the top-left corner and clears the rest of the canvas, so every pixel of a decoded surface is written.
+    /// <para>
+    /// The surfaces are keyed by their exact dimensions, a Paint.NET surface cannot be handed out with a
+    /// different size than it was allocated with. The pool therefore only helps callers that decode many
+    /// images of the same size, such as frames or tiles.
+    /// </para>
+    /// <para>
+    /// A surface that is passed to <see cref="Return(Surface)"/> belongs to the pool, the caller must not access
+    /// or dispose it afterwards. Surfaces that are never returned are simply owned by the caller.
+    /// </para>
+    /// </remarks>
+    internal sealed class SurfacePool : IDisposable
+    {
+        private readonly Dictionary<(int Width, int Height), Stack<Surface>> surfaces;
+        private readonly long maxRetainedBytes;
+        private long retainedBytes;
+        private bool disposed;
+
+        /// <summary>
+        /// Initializes a new instance of the <see cref="SurfacePool"/> class.
+        /// </summary>
+        /// <param name="maxRetainedBytes">The maximum number of bytes held by the idle surfaces in the pool.</param>
+        /// <exception cref="ArgumentOutOfRangeException"><paramref name="maxRetainedBytes"/> is negative.</exception>
+        public SurfacePool(long maxRetainedBytes)
+        {
+            ArgumentOutOfRangeException.ThrowIfNegative(maxRetainedBytes);
+
+            surfaces = new Dictionary<(int Width, int Height), Stack<Surface>>();
+            this.maxRetainedBytes = maxRetainedBytes;
+            retainedBytes = 0;
+        }
+
+        /// <summary>
+        /// Gets a surface with the specified dimensions, the pixel data is undefined.
+        /// </summary>
+        /// <param name="width">The surface width.</param>
+        /// <param name="height">The surface height.</param>
+        /// <returns>A surface from the pool, or a new surface if the pool has none of the requested size.</returns>
+        public Surface Rent(int width, int height)
+        {
+            lock (surfaces)
+            {
+                ObjectDisposedException.ThrowIf(disposed, this);
+
+                if (surfaces.TryGetValue((width, height), out Stack<Surface>? available) && available.Count > 0)
+                {
+                    Surface surface = available.Pop();
+                    retainedBytes -= surface.Scan0.Length;
+
+                    return surface;
+                }
+            }
+
+            return new Surface(width, height, SurfaceCreationFlags.DoNotZeroFillHint);
+        }
+
+        /// <summary>
+        /// Returns a surface to the pool.
+        /// </summary>
+        /// <param name="surface">The surface.</param>
+        /// <exception cref="ArgumentNullException"><paramref name="surface"/> is null.</exception>
+        public void Return(Surface surface)
+        {
+            ArgumentNullException.ThrowIfNull(surface);
+
+            lock (surfaces)
+            {
+                if (!disposed && retainedBytes + surface.Scan0.Length <= maxRetainedBytes)
+                {
+                    (int, int) key = (surface.Width, surface.Height);
+
+                    if (!surfaces.TryGetValue(key, out Stack<Surface>? available))
+                    {
+                        available = new Stack<Surface>();
+                        surfaces.Add(key, available);
+                    }
+
+                    available.Push(surface);
+                    retainedBytes += surface.Scan0.Length;
+                    return;
+                }
+            }
+
+            surface.Dispose();
+        }
+
+        public void Dispose()
+        {
+            lock (surfaces)
+            {
+                if (!disposed)
+                {
+                    disposed = true;
+
+                    foreach (Stack<Surface> available in surfaces.Values)
+                    {
+                        while (available.Count > 0)
+                        {
+                            available.Pop().Dispose();
+                        }
+                    }
+
+                    surfaces.Clear();
+                    retainedBytes = 0;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,1151 @@
+////////////////////////////////////////////////////////////////////////
+//
+// This file is part of pdn-webp, a FileType plugin for Paint.NET
+// that loads and saves WebP images.
+//
+// Copyright (c) 2011-2026 Nicholas Hayes
+//
+// This file is licensed under the MIT License.
+// See LICENSE.txt for complete licensing and attribution information.
+//
+////////////////////////////////////////////////////////////////////////
+
+// A standalone benchmark for the exported WebP API, run with --help for the options.
+// The results are written as JSON so that they can be compared between commits.
+
+#include "Corpus.h"
+#include "WebP.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <Windows.h>
+#include <Psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+    struct ImageSize
+    {
+        int width;
+        int height;
+    };
+
+    struct Options
+    {
+        std::vector<CorpusKind> corpus;
+        std::vector<ImageSize> sizes;
+        std::vector<int> efforts;
+        std::vector<bool> lossless;
+        std::vector<bool> cleanup;
+        float quality;
+        int alphaQuality;
+        int nearLossless;
+        int paletteColors;
+        int iterations;
+        int warmup;
+        int batchCount;
+        int batchEffort;
+        bool planar;
+        int pyramidLevels;
+        std::string outputPath;
+    };
+
+    struct TimeSummary
+    {
+        double min;
+        double mean;
+        double p50;
+        double p90;
+        double p99;
+        double max;
+    };
+
+    class BenchmarkError
+    {
+    public:
+        BenchmarkError(const std::string& operation, WebPStatus status)
+            : operation(operation), status(status)
+        {
+        }
+
+        std::string operation;
+        WebPStatus status;
+    };
+
+    void PrintUsage()
+    {
+        std::cerr <<
+            "Usage: WebPBenchmark [options]\n"
+            "  --corpus <list>      The synthetic images: photo,graphics,alpha,text,sprite (default: all).\n"
+            "  --sizes <list>       The image sizes as WIDTHxHEIGHT (default: 512x512,1920x1080,4000x3000).\n"
+            "  --efforts <list>     The encoder effort levels, ranges such as 0-9 are allowed (default: 0-9).\n"
+            "  --modes <list>       lossy,lossless (default: both).\n"
+            "  --quality <value>    The encoder quality (default: 75).\n"
+            "  --cleanup <list>     Clean up the transparent area: off,on (default: off).\n"
+            "  --alpha-quality <n>  The lossy alpha quality (default: 100).\n"
+            "  --near-lossless <n>  The lossless preprocessing strength, 0 (off) to 100 (default: 0).\n"
+            "  --palette <n>        Reduce lossless images to 2-256 colors, 0 to keep them (default: 0).\n"
+            "  --iterations <n>     The timed runs of each operation (default: 5).\n"
+            "  --warmup <n>         The untimed runs before each operation (default: 1).\n"
+            "  --batch-count <n>    The images in each batch decode comparison, 0 to skip it (default: 16).\n"
+            "  --batch-effort <n>   The effort level of the batch decode and planar images (default: 4).\n"
+            "  --planar <on|off>    Decode the lossy images into YUV planes and encode them again (default: on).\n"
+            "  --pyramid <n>        The levels of the pyramid encode, each half the size of the last, 0 to skip it (default: 3).\n"
+            "  --output <path>      Write the JSON results to a file instead of stdout.\n";
+    }
+
+    std::vector<std::string> SplitList(const std::string& value)
+    {
+        std::vector<std::string> items;
+        std::istringstream stream(value);
+        std::string item;
+
+        while (std::getline(stream, item, ','))
+        {
+            if (!item.empty())
+            {
+                items.push_back(item);
+            }
+        }
+
+        return items;
+    }
+
+    bool TryParseInt(const std::string& value, int& result)
+    {
+        char* end = nullptr;
+        const long parsed = std::strtol(value.c_str(), &end, 10);
+
+        if (value.empty() || *end != '\0' || parsed < 0 || parsed > 1000000)
+        {
+            return false;
+        }
+
+        result = static_cast<int>(parsed);
+        return true;
+    }
+
+    bool TryParseEfforts(const std::string& value, std::vector<int>& efforts)
+    {
+        efforts.clear();
+
+        for (const std::string& item : SplitList(value))
+        {
+            const size_t dash = item.find('-');
+            int first = 0;
+            int last = 0;
+
+            if (dash == std::string::npos)
+            {
+                if (!TryParseInt(item, first))
+                {
+                    return false;
+                }
+                last = first;
+            }
+            else if (!TryParseInt(item.substr(0, dash), first) || !TryParseInt(item.substr(dash + 1), last) || last < first)
+            {
+                return false;
+            }
+
+            if (last > 9)
+            {
+                return false;
+            }
+
+            for (int effort = first; effort <= last; effort++)
+            {
+                efforts.push_back(effort);
+            }
+        }
+
+        return !efforts.empty();
+    }
+
+    bool TryParseSizes(const std::string& value, std::vector<ImageSize>& sizes)
+    {
+        sizes.clear();
+
+        for (const std::string& item : SplitList(value))
+        {
+            const size_t separator = item.find('x');
+            ImageSize size{};
+
+            if (separator == std::string::npos ||
+                !TryParseInt(item.substr(0, separator), size.width) ||
+                !TryParseInt(item.substr(separator + 1), size.height) ||
+                size.width < 1 || size.width > 16383 || size.height < 1 || size.height > 16383)
+            {
+                return false;
+            }
+
+            sizes.push_back(size);
+        }
+
+        return !sizes.empty();
+    }
+
+    bool TryParseOptions(int argc, char** argv, Options& options)
+    {
+        options.corpus = { CorpusKind::Photo, CorpusKind::Graphics, CorpusKind::AlphaGradient, CorpusKind::Text, CorpusKind::Sprite };
+        options.sizes = { { 512, 512 }, { 1920, 1080 }, { 4000, 3000 } };
+        options.efforts = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+        options.lossless = { false, true };
+        options.cleanup = { false };
+        options.quality = 75.0f;
+        options.alphaQuality = 100;
+        options.nearLossless = 0;
+        options.paletteColors = 0;
+        options.iterations = 5;
+        options.warmup = 1;
+        options.batchCount = 16;
+        options.batchEffort = 4;
+        options.planar = true;
+        options.pyramidLevels = 3;
+
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string name = argv[i];
+
+            if (name == "--help" || name == "-h")
+            {
+                return false;
+            }
+
+            if (i + 1 >= argc)
+            {
+                std::cerr << "Missing value for " << name << ".\n";
+                return false;
+            }
+
+            const std::string value = argv[++i];
+            bool valid = true;
+
+            if (name == "--corpus")
+            {
+                options.corpus.clear();
+
+                for (const std::string& item : SplitList(value))
+                {
+                    CorpusKind kind;
+
+                    if (!Corpus::TryParse(item, kind))
+                    {
+                        valid = false;
+                        break;
+                    }
+
+                    options.corpus.push_back(kind);
+                }
+
+                valid = valid && !options.corpus.empty();
+            }
+            else if (name == "--sizes")
+            {
+                valid = TryParseSizes(value, options.sizes);
+            }
+            else if (name == "--efforts")
+            {
+                valid = TryParseEfforts(value, options.efforts);
+            }
+            else if (name == "--modes")
+            {
+                options.lossless.clear();
+
+                for (const std::string& item : SplitList(value))
+                {
+                    if (item == "lossy" || item == "lossless")
+                    {
+                        options.lossless.push_back(item == "lossless");
+                    }
+                    else
+                    {
+                        valid = false;
+                    }
+                }
+
+                valid = valid && !options.lossless.empty();
+            }
+            else if (name == "--quality")
+            {
+                int quality = 0;
+                valid = TryParseInt(value, quality) && quality <= 100;
+                options.quality = static_cast<float>(quality);
+            }
+            else if (name == "--cleanup")
+            {
+                options.cleanup.clear();
+
+                for (const std::string& item : SplitList(value))
+                {
+                    if (item == "off" || item == "on")
+                    {
+                        options.cleanup.push_back(item == "on");
+                    }
+                    else
+                    {
+                        valid = false;
+                    }
+                }
+
+                valid = valid && !options.cleanup.empty();
+            }
+            else if (name == "--alpha-quality")
+            {
+                valid = TryParseInt(value, options.alphaQuality) && options.alphaQuality <= 100;
+            }
+            else if (name == "--near-lossless")
+            {
+                valid = TryParseInt(value, options.nearLossless) && options.nearLossless <= 100;
+            }
+            else if (name == "--palette")
+            {
+                valid = TryParseInt(value, options.paletteColors) && options.paletteColors != 1 && options.paletteColors <= 256;
+            }
+            else if (name == "--iterations")
+            {
+                valid = TryParseInt(value, options.iterations) && options.iterations > 0;
+            }
+            else if (name == "--warmup")
+            {
+                valid = TryParseInt(value, options.warmup);
+            }
+            else if (name == "--batch-count")
+            {
+                valid = TryParseInt(value, options.batchCount);
+            }
+            else if (name == "--batch-effort")
+            {
+                valid = TryParseInt(value, options.batchEffort) && options.batchEffort <= 9;
+            }
+            else if (name == "--planar")
+            {
+                valid = value == "on" || value == "off";
+                options.planar = value == "on";
+            }
+            else if (name == "--pyramid")
+            {
+                valid = TryParseInt(value, options.pyramidLevels) && options.pyramidLevels <= 8;
+            }
+            else if (name == "--output")
+            {
+                options.outputPath = value;
+            }
+            else
+            {
+                std::cerr << "Unknown option " << name << ".\n";
+                return false;
+            }
+
+            if (!valid)
+            {
+                std::cerr << "Invalid value for " << name << ": " << value << "\n";
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    uint64_t GetPeakResidentSetSize()
+    {
+#if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters{};
+
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        {
+            return counters.PeakWorkingSetSize;
+        }
+
+        return 0;
+#else
+        struct rusage usage{};
+
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+        {
+            return 0;
+        }
+
+#if defined(__APPLE__)
+        return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+        // Linux reports the value in kilobytes.
+        return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+    }
+
+    TimeSummary Summarize(std::vector<double> times)
+    {
+        std::sort(times.begin(), times.end());
+
+        // The nearest-rank percentile.
+        auto percentile = [&times](double p)
+        {
+            const size_t rank = static_cast<size_t>(std::ceil(p * static_cast<double>(times.size())));
+            return times[std::min(std::max(rank, static_cast<size_t>(1)), times.size()) - 1];
+        };
+
+        double total = 0;
+        for (double time : times)
+        {
+            total += time;
+        }
+
+        TimeSummary summary{};
+        summary.min = times.front();
+        summary.mean = total / static_cast<double>(times.size());
+        summary.p50 = percentile(0.50);
+        summary.p90 = percentile(0.90);
+        summary.p99 = percentile(0.99);
+        summary.max = times.back();
+
+        return summary;
+    }
+
+    double MegapixelsPerSecond(uint64_t pixels, double milliseconds)
+    {
+        return milliseconds > 0 ? (static_cast<double>(pixels) / 1000000.0) / (milliseconds / 1000.0) : 0;
+    }
+
+    // Times the specified operation, which returns the peak transient memory of the native call.
+    template <typename Operation>
+    TimeSummary Measure(const Options& options, const Operation& operation, uint64_t& peakTransientBytes)
+    {
+        peakTransientBytes = 0;
+
+        for (int i = 0; i < options.warmup; i++)
+        {
+            operation();
+        }
+
+        std::vector<double> times;
+        times.reserve(options.iterations);
+
+        for (int i = 0; i < options.iterations; i++)
+        {
+            const auto start = std::chrono::steady_clock::now();
+
+            const uint64_t transientBytes = operation();
+
+            times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            peakTransientBytes = std::max(peakTransientBytes, transientBytes);
+        }
+
+        return Summarize(times);
+    }
+
+    WebPStatus __stdcall WriteToVector(void* context, const uint8_t* image, const size_t imageSize)
+    {
+        std::vector<uint8_t>* output = static_cast<std::vector<uint8_t>*>(context);
+        output->insert(output->end(), image, image + imageSize);
+
+        return WebPStatus::Ok;
+    }
+
+    void* __stdcall CreateImage(void* context, int width, int height, size_t& outImageDataSize, int& outStride)
+    {
+        // The buffer is reused between iterations, so only the first decode pays for the allocation.
+        std::vector<uint8_t>* pixels = static_cast<std::vector<uint8_t>*>(context);
+
+        outStride = width * 4;
+        outImageDataSize = static_cast<size_t>(outStride) * height;
+        pixels->resize(outImageDataSize);
+
+        return pixels->data();
+    }
+
+    bool __stdcall IgnoreMetadata(void*, const uint8_t*, size_t, MetadataType)
+    {
+        return true;
+    }
+
+    void* __stdcall CreateBatchImage(void* context, size_t index, int width, int height, size_t& outImageDataSize, int& outStride)
+    {
+        std::vector<std::vector<uint8_t>>* images = static_cast<std::vector<std::vector<uint8_t>>*>(context);
+
+        return CreateImage(&(*images)[index], width, height, outImageDataSize, outStride);
+    }
+
+    // The planar decode output, the alpha plane is only allocated when it is requested.
+    struct PlaneBuffers
+    {
+        std::vector<uint8_t> y;
+        std::vector<uint8_t> u;
+        std::vector<uint8_t> v;
+        std::vector<uint8_t> a;
+        bool allocateAlpha;
+    };
+
+    bool __stdcall CreatePlanes(void* context, int width, int height, bool hasAlpha, DecoderPlanes& outPlanes)
+    {
+        // The buffers are reused between iterations, so only the first decode pays for the allocation.
+        PlaneBuffers* planes = static_cast<PlaneBuffers*>(context);
+
+        const int uvWidth = (width + 1) / 2;
+        const int uvHeight = (height + 1) / 2;
+
+        planes->y.resize(static_cast<size_t>(width) * height);
+        planes->u.resize(static_cast<size_t>(uvWidth) * uvHeight);
+        planes->v.resize(static_cast<size_t>(uvWidth) * uvHeight);
+
+        outPlanes.y = planes->y.data();
+        outPlanes.u = planes->u.data();
+        outPlanes.v = planes->v.data();
+        outPlanes.yStride = width;
+        outPlanes.uStride = uvWidth;
+        outPlanes.vStride = uvWidth;
+        outPlanes.ySize = planes->y.size();
+        outPlanes.uSize = planes->u.size();
+        outPlanes.vSize = planes->v.size();
+
+        if (planes->allocateAlpha && hasAlpha)
+        {
+            planes->a.resize(static_cast<size_t>(width) * height);
+
+            outPlanes.a = planes->a.data();
+            outPlanes.aStride = width;
+            outPlanes.aSize = planes->a.size();
+        }
+        else
+        {
+            planes->a.clear();
+        }
+
+        return true;
+    }
+
+    std::vector<uint8_t> Encode(const CorpusImage& image, const EncoderOptions& encoderOptions, uint64_t& peakTransientBytes)
+    {
+        std::vector<uint8_t> output;
+        MemoryBudget budget{};
+
+        const WebPStatus status = WebPSave(
+            WriteToVector,
+            image.pixels.data(),
+            image.width,
+            image.height,
+            image.stride,
+            EncoderPixelFormat::Bgra,
+            nullptr,
+            &encoderOptions,
+            nullptr,
+            nullptr,
+            &output,
+            nullptr,
+            &budget);
+
+        if (status != WebPStatus::Ok)
+        {
+            throw BenchmarkError("WebPSave", status);
+        }
+
+        peakTransientBytes = budget.peakUsage;
+
+        return output;
+    }
+
+    uint64_t Decode(const std::vector<uint8_t>& encoded, std::vector<uint8_t>& pixels)
+    {
+        MemoryBudget budget{};
+
+        const WebPStatus status = WebPLoad(
+            encoded.data(),
+            encoded.size(),
+            DecoderPixelFormat::Bgra,
+            CreateImage,
+            IgnoreMetadata,
+            &pixels,
+            &budget);
+
+        if (status != WebPStatus::Ok)
+        {
+            throw BenchmarkError("WebPLoad", status);
+        }
+
+        return budget.peakUsage;
+    }
+
+    uint64_t DecodePlanes(const std::vector<uint8_t>& encoded, PlaneBuffers& planes)
+    {
+        MemoryBudget budget{};
+
+        const WebPStatus status = WebPLoadPlanes(
+            encoded.data(),
+            encoded.size(),
+            CreatePlanes,
+            IgnoreMetadata,
+            &planes,
+            &budget);
+
+        if (status != WebPStatus::Ok)
+        {
+            throw BenchmarkError("WebPLoadPlanes", status);
+        }
+
+        return budget.peakUsage;
+    }
+
+    std::vector<uint8_t> EncodePlanes(
+        const PlaneBuffers& planes,
+        int width,
+        int height,
+        const EncoderOptions& encoderOptions,
+        uint64_t& peakTransientBytes)
+    {
+        std::vector<uint8_t> output;
+        MemoryBudget budget{};
+
+        YUVImage yuvImage{};
+        yuvImage.y = planes.y.data();
+        yuvImage.u = planes.u.data();
+        yuvImage.v = planes.v.data();
+        yuvImage.a = planes.a.empty() ? nullptr : planes.a.data();
+        yuvImage.yStride = width;
+        yuvImage.uvStride = (width + 1) / 2;
+        yuvImage.aStride = width;
+
+        const WebPStatus status = WebPSaveYUV(
+            WriteToVector,
+            &yuvImage,
+            width,
+            height,
+            &encoderOptions,
+            nullptr,
+            nullptr,
+            &output,
+            nullptr,
+            &budget);
+
+        if (status != WebPStatus::Ok)
+        {
+            throw BenchmarkError("WebPSaveYUV", status);
+        }
+
+        peakTransientBytes = budget.peakUsage;
+
+        return output;
+    }
+
+    class JsonWriter
+    {
+    public:
+        explicit JsonWriter(std::ostream& stream) : stream(stream), needsComma(false)
+        {
+        }
+
+        void BeginObject(const char* name = nullptr)
+        {
+            WriteName(name);
+            stream << '{';
+            needsComma = false;
+        }
+
+        void EndObject()
+        {
+            stream << '}';
+            needsComma = true;
+        }
+
+        void BeginArray(const char* name)
+        {
+            WriteName(name);
+            stream << '[';
+            needsComma = false;
+        }
+
+        void EndArray()
+        {
+            stream << ']';
+            needsComma = true;
+        }
+
+        void Write(const char* name, const std::string& value)
+        {
+            WriteName(name);
+            stream << '"';
+
+            for (char c : value)
+            {
+                if (c == '"' || c == '\\')
+                {
+                    stream << '\\';
+                }
+                stream << c;
+            }
+
+            stream << '"';
+            needsComma = true;
+        }
+
+        void Write(const char* name, const char* value)
+        {
+            Write(name, std::string(value));
+        }
+
+        void Write(const char* name, bool value)
+        {
+            WriteName(name);
+            stream << (value ? "true" : "false");
+            needsComma = true;
+        }
+
+        void Write(const char* name, int value)
+        {
+            WriteName(name);
+            stream << value;
+            needsComma = true;
+        }
+
+        void Write(const char* name, uint64_t value)
+        {
+            WriteName(name);
+            stream << value;
+            needsComma = true;
+        }
+
+        void Write(const char* name, double value)
+        {
+            WriteName(name);
+            stream << value;
+            needsComma = true;
+        }
+
+        void Write(const char* name, const TimeSummary& summary)
+        {
+            BeginObject(name);
+            Write("min", summary.min);
+            Write("mean", summary.mean);
+            Write("p50", summary.p50);
+            Write("p90", summary.p90);
+            Write("p99", summary.p99);
+            Write("max", summary.max);
+            EndObject();
+        }
+
+    private:
+        void WriteName(const char* name)
+        {
+            if (needsComma)
+            {
+                stream << ',';
+            }
+
+            if (name)
+            {
+                stream << '"' << name << "\":";
+            }
+        }
+
+        std::ostream& stream;
+        bool needsComma;
+    };
+
+    void WriteResultHeader(
+        JsonWriter& json,
+        const char* operation,
+        const CorpusImage& image,
+        bool lossless,
+        int effort,
+        bool cleanup,
+        const Options& options)
+    {
+        json.Write("operation", operation);
+        json.Write("corpus", Corpus::GetName(image.kind));
+        json.Write("width", image.width);
+        json.Write("height", image.height);
+        json.Write("mode", lossless ? "lossless" : "lossy");
+        json.Write("effort", effort);
+        json.Write("quality", static_cast<double>(options.quality));
+        json.Write("cleanupTransparentArea", cleanup);
+        json.Write("alphaQuality", options.alphaQuality);
+        json.Write("nearLossless", options.nearLossless);
+        json.Write("paletteColors", options.paletteColors);
+        json.Write("iterations", options.iterations);
+    }
+
+    EncoderOptions CreateEncoderOptions(const Options& options, bool lossless, int effort, bool cleanup)
+    {
+        EncoderOptions encoderOptions{};
+        encoderOptions.quality = options.quality;
+        encoderOptions.effort = effort;
+        encoderOptions.preset = 0;
+        encoderOptions.lossless = lossless;
+        encoderOptions.cleanupTransparentArea = cleanup;
+        encoderOptions.alphaQualityReduction = 100 - options.alphaQuality;
+        encoderOptions.alphaFiltering = 0;
+        encoderOptions.uncompressedAlpha = false;
+        encoderOptions.nearLosslessStrength = options.nearLossless;
+        encoderOptions.paletteColors = options.paletteColors;
+        encoderOptions.paletteDither = false;
+
+        return encoderOptions;
+    }
+
+    // Encodes and decodes the image at every selected effort level, mode and cleanup setting.
+    void RunEncodeDecode(JsonWriter& json, const CorpusImage& image, const Options& options)
+    {
+        const uint64_t pixelCount = static_cast<uint64_t>(image.width) * image.height;
+        std::vector<uint8_t> decodedPixels;
+
+        for (bool lossless : options.lossless)
+        {
+            for (bool cleanup : options.cleanup)
+            {
+                for (int effort : options.efforts)
+                {
+                    std::cerr << "  " << (lossless ? "lossless" : "lossy") << " effort " << effort << (cleanup ? " with cleanup" : "") << "\n";
+
+                    const EncoderOptions encoderOptions = CreateEncoderOptions(options, lossless, effort, cleanup);
+
+                    std::vector<uint8_t> encoded;
+                    uint64_t encodeTransientBytes = 0;
+
+                    const TimeSummary encodeTime = Measure(options, [&]()
+                    {
+                        uint64_t transientBytes = 0;
+                        encoded = Encode(image, encoderOptions, transientBytes);
+                        return transientBytes;
+                    }, encodeTransientBytes);
+
+                    json.BeginObject();
+                    WriteResultHeader(json, "encode", image, lossless, effort, cleanup, options);
+                    json.Write("encodedBytes", static_cast<uint64_t>(encoded.size()));
+                    json.Write("bytesPerPixel", static_cast<double>(encoded.size()) / static_cast<double>(pixelCount));
+                    json.Write("megapixelsPerSecond", MegapixelsPerSecond(pixelCount, encodeTime.p50));
+                    json.Write("peakTransientBytes", encodeTransientBytes);
+                    json.Write("timeMs", encodeTime);
+                    json.EndObject();
+
+                    uint64_t decodeTransientBytes = 0;
+
+                    const TimeSummary decodeTime = Measure(options, [&]()
+                    {
+                        return Decode(encoded, decodedPixels);
+                    }, decodeTransientBytes);
+
+                    json.BeginObject();
+                    WriteResultHeader(json, "decode", image, lossless, effort, cleanup, options);
+                    json.Write("encodedBytes", static_cast<uint64_t>(encoded.size()));
+                    json.Write("bytesPerPixel", static_cast<double>(encoded.size()) / static_cast<double>(pixelCount));
+                    json.Write("megapixelsPerSecond", MegapixelsPerSecond(pixelCount, decodeTime.p50));
+                    json.Write("peakTransientBytes", decodeTransientBytes);
+                    json.Write("timeMs", decodeTime);
+                    json.EndObject();
+                }
+            }
+        }
+    }
+
+    // Compares decoding the same image batchCount times with WebPLoadBatch against a WebPLoad loop.
+    void RunBatchDecode(JsonWriter& json, const CorpusImage& image, const Options& options)
+    {
+        const uint64_t pixelCount = static_cast<uint64_t>(image.width) * image.height * options.batchCount;
+        const size_t count = static_cast<size_t>(options.batchCount);
+
+        for (bool lossless : options.lossless)
+        {
+            std::cerr << "  " << (lossless ? "lossless" : "lossy") << " batch decode of " << count << " images\n";
+
+            const EncoderOptions encoderOptions = CreateEncoderOptions(options, lossless, options.batchEffort, false);
+
+            uint64_t unused = 0;
+            const std::vector<uint8_t> encoded = Encode(image, encoderOptions, unused);
+
+            std::vector<std::vector<uint8_t>> outputs(count);
+            const std::vector<const uint8_t*> data(count, encoded.data());
+            const std::vector<size_t> dataSizes(count, encoded.size());
+            std::vector<WebPStatus> itemStatus(count);
+
+            const TimeSummary loopTime = Measure(options, [&]()
+            {
+                for (size_t i = 0; i < count; i++)
+                {
+                    Decode(encoded, outputs[i]);
+                }
+
+                return static_cast<uint64_t>(0);
+            }, unused);
+
+            const TimeSummary batchTime = Measure(options, [&]()
+            {
+                const WebPStatus status = WebPLoadBatch(
+                    data.data(),
+                    dataSizes.data(),
+                    count,
+                    DecoderPixelFormat::Bgra,
+                    CreateBatchImage,
+                    nullptr,
+                    &outputs,
+                    itemStatus.data());
+
+                if (status != WebPStatus::Ok)
+                {
+                    throw BenchmarkError("WebPLoadBatch", status);
+                }
+
+                for (WebPStatus item : itemStatus)
+                {
+                    if (item != WebPStatus::Ok)
+                    {
+                        throw BenchmarkError("WebPLoadBatch", item);
+                    }
+                }
+
+                return static_cast<uint64_t>(0);
+            }, unused);
+
+            json.BeginObject();
+            WriteResultHeader(json, "decodeBatch", image, lossless, options.batchEffort, false, options);
+            json.Write("images", options.batchCount);
+            json.Write("encodedBytes", static_cast<uint64_t>(encoded.size()));
+            json.BeginObject("loop");
+            json.Write("megapixelsPerSecond", MegapixelsPerSecond(pixelCount, loopTime.p50));
+            json.Write("timeMs", loopTime);
+            json.EndObject();
+            json.BeginObject("batch");
+            json.Write("megapixelsPerSecond", MegapixelsPerSecond(pixelCount, batchTime.p50));
+            json.Write("timeMs", batchTime);
+            json.EndObject();
+            json.Write("speedup", batchTime.p50 > 0 ? loopTime.p50 / batchTime.p50 : 0.0);
+            json.EndObject();
+        }
+    }
+
+    // Decodes the lossy image into YUV planes, with and without an alpha plane,
+    // and encodes the planes again.
+    void RunPlanar(JsonWriter& json, const CorpusImage& image, const Options& options)
+    {
+        const uint64_t pixelCount = static_cast<uint64_t>(image.width) * image.height;
+
+        std::cerr << "  lossy planar decode\n";
+
+        const EncoderOptions encoderOptions = CreateEncoderOptions(options, false, options.batchEffort, false);
+
+        uint64_t unused = 0;
+        const std::vector<uint8_t> encoded = Encode(image, encoderOptions, unused);
+
+        PlaneBuffers planes{};
+
+        for (bool alphaPlane : { true, false })
+        {
+            planes.allocateAlpha = alphaPlane;
+
+            uint64_t decodeTransientBytes = 0;
+
+            const TimeSummary decodeTime = Measure(options, [&]()
+            {
+                return DecodePlanes(encoded, planes);
+            }, decodeTransientBytes);
+
+            json.BeginObject();
+            WriteResultHeader(json, "decodePlanes", image, false, options.batchEffort, false, options);
+            json.Write("alphaPlane", alphaPlane);
+            json.Write("encodedBytes", static_cast<uint64_t>(encoded.size()));
+            json.Write("megapixelsPerSecond", MegapixelsPerSecond(pixelCount, decodeTime.p50));
+            json.Write("peakTransientBytes", decodeTransientBytes);
+            json.Write("timeMs", decodeTime);
+            json.EndObject();
+
+            std::vector<uint8_t> reencoded;
+            uint64_t encodeTransientBytes = 0;
+
+            const TimeSummary encodeTime = Measure(options, [&]()
+            {
+                uint64_t transientBytes = 0;
+                reencoded = EncodePlanes(planes, image.width, image.height, encoderOptions, transientBytes);
+                return transientBytes;
+            }, encodeTransientBytes);
+
+            json.BeginObject();
+            WriteResultHeader(json, "encodePlanes", image, false, options.batchEffort, false, options);
+            json.Write("alphaPlane", alphaPlane);
+            json.Write("encodedBytes", static_cast<uint64_t>(reencoded.size()));
+            json.Write("bytesPerPixel", static_cast<double>(reencoded.size()) / static_cast<double>(pixelCount));
+            json.Write("megapixelsPerSecond", MegapixelsPerSecond(pixelCount, encodeTime.p50));
+            json.Write("peakTransientBytes", encodeTransientBytes);
+            json.Write("timeMs", encodeTime);
+            json.EndObject();
+        }
+    }
+
+    // Encodes the image and its downscaled levels with WebPSavePyramid, in every selected mode.
+    void RunPyramid(JsonWriter& json, const CorpusImage& image, const Options& options)
+    {
+        std::vector<PyramidLevel> levels;
+        uint64_t pixelCount = 0;
+
+        for (int i = 0; i < options.pyramidLevels; i++)
+        {
+            PyramidLevel level{};
+            level.width = std::max(1, image.width >> i);
+            level.height = std::max(1, image.height >> i);
+
+            levels.push_back(level);
+            pixelCount += static_cast<uint64_t>(level.width) * level.height;
+        }
+
+        std::vector<std::vector<uint8_t>> outputs(levels.size());
+        std::vector<WebPStatus> levelStatus(levels.size());
+
+        for (bool lossless : options.lossless)
+        {
+            std::cerr << "  " << (lossless ? "lossless" : "lossy") << " pyramid of " << levels.size() << " levels\n";
+
+            for (size_t i = 0; i < levels.size(); i++)
+            {
+                levels[i].options = CreateEncoderOptions(options, lossless, options.batchEffort, false);
+                levels[i].writeImageCallback = WriteToVector;
+                levels[i].callbackContext = &outputs[i];
+            }
+
+            uint64_t unused = 0;
+
+            const TimeSummary pyramidTime = Measure(options, [&]()
+            {
+                for (std::vector<uint8_t>& output : outputs)
+                {
+                    output.clear();
+                }
+
+                const WebPStatus status = WebPSavePyramid(
+                    image.pixels.data(),
+                    image.width,
+                    image.height,
+                    image.stride,
+                    levels.data(),
+                    levels.size(),
+                    nullptr,
+                    0,
+                    levelStatus.data());
+
+                if (status != WebPStatus::Ok)
+                {
+                    throw BenchmarkError("WebPSavePyramid", status);
+                }
+
+                for (WebPStatus item : levelStatus)
+                {
+                    if (item != WebPStatus::Ok)
+                    {
+                        throw BenchmarkError("WebPSavePyramid", item);
+                    }
+                }
+
+                return static_cast<uint64_t>(0);
+            }, unused);
+
+            uint64_t encodedBytes = 0;
+
+            for (const std::vector<uint8_t>& output : outputs)
+            {
+                encodedBytes += output.size();
+            }
+
+            json.BeginObject();
+            WriteResultHeader(json, "encodePyramid", image, lossless, options.batchEffort, false, options);
+            json.Write("levels", static_cast<int>(levels.size()));
+            json.Write("encodedBytes", encodedBytes);
+            json.Write("megapixelsPerSecond", MegapixelsPerSecond(pixelCount, pyramidTime.p50));
+            json.Write("timeMs", pyramidTime);
+            json.EndObject();
+        }
+    }
+
+    std::string FormatVersion(int packedVersion)
+    {
+        std::ostringstream version;
+        version << ((packedVersion >> 16) & 0xff) << '.' << ((packedVersion >> 8) & 0xff) << '.' << (packedVersion & 0xff);
+
+        return version.str();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+
+    if (!TryParseOptions(argc, argv, options))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    std::ostringstream results;
+    JsonWriter json(results);
+
+    json.BeginObject();
+    json.Write("libwebpVersion", FormatVersion(GetLibWebPVersion()));
+    json.Write("hardwareThreads", static_cast<int>(std::thread::hardware_concurrency()));
+    json.BeginArray("results");
+
+    try
+    {
+        for (CorpusKind kind : options.corpus)
+        {
+            for (const ImageSize& size : options.sizes)
+            {
+                std::cerr << Corpus::GetName(kind) << " " << size.width << "x" << size.height << "\n";
+
+                const CorpusImage image = Corpus::Generate(kind, size.width, size.height);
+
+                RunEncodeDecode(json, image, options);
+
+                if (options.batchCount > 0)
+                {
+                    RunBatchDecode(json, image, options);
+                }
+
+                if (options.planar)
+                {
+                    RunPlanar(json, image, options);
+                }
+
+                if (options.pyramidLevels > 0)
+                {
+                    RunPyramid(json, image, options);
+                }
+            }
+        }
+    }
+    catch (const BenchmarkError& error)
+    {
+        std::cerr << error.operation << " failed with status " << static_cast<int>(error.status) << ".\n";
+        return 2;
+    }
+
+    json.EndArray();
+    json.Write("peakRssBytes", GetPeakResidentSetSize());
+    json.EndObject();
+
+    if (options.outputPath.empty())
+    {
+        std::cout << results.str() << std::endl;
+    }
+    else
+    {
+        std::ofstream output(options.outputPath);
+        output << results.str() << std::endl;
+
+        if (!output)
+        {
+            std::cerr << "Unable to write " << options.outputPath << ".\n";
+            return 2;
+        }
+    }
+
+    return 0;
+}
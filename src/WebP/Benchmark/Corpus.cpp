@@ -0,0 +1,373 @@
+////////////////////////////////////////////////////////////////////////
+//
+// This file is part of pdn-webp, a FileType plugin for Paint.NET
+// that loads and saves WebP images.
+//
+// Copyright (c) 2011-2026 Nicholas Hayes
+//
+// This file is licensed under the MIT License.
+// See LICENSE.txt for complete licensing and attribution information.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include "Corpus.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // A small deterministic generator, the standard library distributions are not guaranteed
+    // to produce the same sequence on every platform.
+    class Random
+    {
+    public:
+        explicit Random(uint32_t seed) : state(seed != 0 ? seed : 1)
+        {
+        }
+
+        uint32_t Next()
+        {
+            // xorshift32
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return state;
+        }
+
+        // Returns a value in the range [0, max).
+        int Next(int max)
+        {
+            return static_cast<int>(Next() % static_cast<uint32_t>(max));
+        }
+
+    private:
+        uint32_t state;
+    };
+
+    uint8_t ClampToByte(int value)
+    {
+        return static_cast<uint8_t>(std::min(std::max(value, 0), 255));
+    }
+
+    void SetPixel(CorpusImage& image, int x, int y, uint8_t b, uint8_t g, uint8_t r, uint8_t a)
+    {
+        uint8_t* pixel = image.pixels.data() + (static_cast<size_t>(y) * image.stride) + (static_cast<size_t>(x) * 4);
+
+        pixel[0] = b;
+        pixel[1] = g;
+        pixel[2] = r;
+        pixel[3] = a;
+    }
+
+    void FillRect(CorpusImage& image, int left, int top, int right, int bottom, uint8_t b, uint8_t g, uint8_t r)
+    {
+        left = std::max(left, 0);
+        top = std::max(top, 0);
+        right = std::min(right, image.width);
+        bottom = std::min(bottom, image.height);
+
+        for (int y = top; y < bottom; y++)
+        {
+            for (int x = left; x < right; x++)
+            {
+                SetPixel(image, x, y, b, g, r, 255);
+            }
+        }
+    }
+
+    // Bilinearly interpolated value noise over a grid of random values, one grid per color channel.
+    class ValueNoise
+    {
+    public:
+        ValueNoise(int width, int height, int cellSize, Random& random)
+            : cellSize(cellSize), columns((width / cellSize) + 2), rows((height / cellSize) + 2),
+              values(static_cast<size_t>(columns) * rows * 3)
+        {
+            for (uint8_t& value : values)
+            {
+                value = static_cast<uint8_t>(random.Next(256));
+            }
+        }
+
+        int Sample(int x, int y, int channel) const
+        {
+            const int cellX = x / cellSize;
+            const int cellY = y / cellSize;
+            const int fx = x % cellSize;
+            const int fy = y % cellSize;
+
+            const int v00 = GetValue(cellX, cellY, channel);
+            const int v10 = GetValue(cellX + 1, cellY, channel);
+            const int v01 = GetValue(cellX, cellY + 1, channel);
+            const int v11 = GetValue(cellX + 1, cellY + 1, channel);
+
+            const int top = (v00 * (cellSize - fx)) + (v10 * fx);
+            const int bottom = (v01 * (cellSize - fx)) + (v11 * fx);
+
+            return ((top * (cellSize - fy)) + (bottom * fy)) / (cellSize * cellSize);
+        }
+
+    private:
+        int GetValue(int column, int row, int channel) const
+        {
+            return values[((static_cast<size_t>(row) * columns) + column) * 3 + channel];
+        }
+
+        int cellSize;
+        int columns;
+        int rows;
+        std::vector<uint8_t> values;
+    };
+
+    void GeneratePhoto(CorpusImage& image, Random& random)
+    {
+        const ValueNoise coarse(image.width, image.height, 128, random);
+        const ValueNoise fine(image.width, image.height, 16, random);
+
+        for (int y = 0; y < image.height; y++)
+        {
+            for (int x = 0; x < image.width; x++)
+            {
+                const int grain = random.Next(13) - 6;
+
+                int channels[3];
+
+                for (int c = 0; c < 3; c++)
+                {
+                    channels[c] = ((coarse.Sample(x, y, c) * 3) + fine.Sample(x, y, c)) / 4 + grain;
+                }
+
+                SetPixel(image, x, y, ClampToByte(channels[0]), ClampToByte(channels[1]), ClampToByte(channels[2]), 255);
+            }
+        }
+    }
+
+    void GenerateGraphics(CorpusImage& image, Random& random)
+    {
+        static const uint8_t palette[][3] =
+        {
+            { 255, 255, 255 },
+            { 40, 40, 40 },
+            { 200, 80, 30 },
+            { 30, 160, 230 },
+            { 60, 200, 90 },
+            { 0, 210, 250 },
+            { 180, 60, 170 },
+            { 120, 120, 120 },
+        };
+        const int paletteSize = static_cast<int>(sizeof(palette) / sizeof(palette[0]));
+
+        FillRect(image, 0, 0, image.width, image.height, palette[0][0], palette[0][1], palette[0][2]);
+
+        const int shapeCount = 8 + static_cast<int>((static_cast<int64_t>(image.width) * image.height) / 20000);
+
+        for (int i = 0; i < shapeCount; i++)
+        {
+            const uint8_t* color = palette[1 + random.Next(paletteSize - 1)];
+            const int left = random.Next(image.width);
+            const int top = random.Next(image.height);
+            const int right = left + 1 + random.Next(std::max(image.width / 4, 1));
+            const int bottom = top + 1 + random.Next(std::max(image.height / 4, 1));
+
+            FillRect(image, left, top, right, bottom, color[0], color[1], color[2]);
+        }
+    }
+
+    void GenerateAlphaGradient(CorpusImage& image)
+    {
+        const int maxX = std::max(image.width - 1, 1);
+        const int maxY = std::max(image.height - 1, 1);
+
+        for (int y = 0; y < image.height; y++)
+        {
+            for (int x = 0; x < image.width; x++)
+            {
+                const uint8_t b = static_cast<uint8_t>((x * 255) / maxX);
+                const uint8_t g = static_cast<uint8_t>((y * 255) / maxY);
+                const uint8_t r = static_cast<uint8_t>(255 - b);
+                const uint8_t a = static_cast<uint8_t>(((static_cast<int64_t>(x) * maxY + static_cast<int64_t>(y) * maxX) * 255) /
+                                                       (2 * static_cast<int64_t>(maxX) * maxY));
+
+                SetPixel(image, x, y, b, g, r, a);
+            }
+        }
+    }
+
+    void GenerateText(CorpusImage& image, Random& random)
+    {
+        const int glyphWidth = 7;
+        const int glyphHeight = 12;
+        const int advance = 9;
+        const int lineHeight = 18;
+        const int stroke = 2;
+
+        FillRect(image, 0, 0, image.width, image.height, 245, 245, 245);
+
+        for (int top = 4; top + glyphHeight <= image.height; top += lineHeight)
+        {
+            for (int left = 4; left + glyphWidth <= image.width - 4; left += advance)
+            {
+                // Leave gaps between the words.
+                if (random.Next(6) == 0)
+                {
+                    continue;
+                }
+
+                // Each glyph is a random set of the seven segment strokes.
+                const int segments = 1 + random.Next(127);
+                const int middle = top + (glyphHeight / 2) - (stroke / 2);
+                const int right = left + glyphWidth;
+                const int bottom = top + glyphHeight;
+
+                if (segments & 1)
+                {
+                    FillRect(image, left, top, right, top + stroke, 20, 20, 20);
+                }
+                if (segments & 2)
+                {
+                    FillRect(image, left, middle, right, middle + stroke, 20, 20, 20);
+                }
+                if (segments & 4)
+                {
+                    FillRect(image, left, bottom - stroke, right, bottom, 20, 20, 20);
+                }
+                if (segments & 8)
+                {
+                    FillRect(image, left, top, left + stroke, middle, 20, 20, 20);
+                }
+                if (segments & 16)
+                {
+                    FillRect(image, right - stroke, top, right, middle, 20, 20, 20);
+                }
+                if (segments & 32)
+                {
+                    FillRect(image, left, middle, left + stroke, bottom, 20, 20, 20);
+                }
+                if (segments & 64)
+                {
+                    FillRect(image, right - stroke, middle, right, bottom, 20, 20, 20);
+                }
+            }
+        }
+    }
+
+    // The transparent pixels keep random colors, as some editors leave behind after erasing,
+    // which the encoder must spend bits on unless the transparent area is cleaned up.
+    void GenerateSprite(CorpusImage& image, Random& random)
+    {
+        for (int y = 0; y < image.height; y++)
+        {
+            for (int x = 0; x < image.width; x++)
+            {
+                const uint32_t noise = random.Next();
+
+                SetPixel(image, x, y, static_cast<uint8_t>(noise), static_cast<uint8_t>(noise >> 8), static_cast<uint8_t>(noise >> 16), 0);
+            }
+        }
+
+        const int shapeCount = 4 + static_cast<int>((static_cast<int64_t>(image.width) * image.height) / 60000);
+        const int maxRadius = std::max(std::min(image.width, image.height) / 12, 2);
+
+        for (int i = 0; i < shapeCount; i++)
+        {
+            const int centerX = random.Next(image.width);
+            const int centerY = random.Next(image.height);
+            const int radius = 1 + random.Next(maxRadius);
+            const uint8_t b = static_cast<uint8_t>(random.Next(256));
+            const uint8_t g = static_cast<uint8_t>(random.Next(256));
+            const uint8_t r = static_cast<uint8_t>(random.Next(256));
+
+            const int top = std::max(centerY - radius - 1, 0);
+            const int bottom = std::min(centerY + radius + 1, image.height - 1);
+            const int left = std::max(centerX - radius - 1, 0);
+            const int right = std::min(centerX + radius + 1, image.width - 1);
+
+            for (int y = top; y <= bottom; y++)
+            {
+                for (int x = left; x <= right; x++)
+                {
+                    const double distance = std::sqrt(static_cast<double>((x - centerX) * (x - centerX) + (y - centerY) * (y - centerY)));
+                    const double coverage = std::min(std::max(radius + 0.5 - distance, 0.0), 1.0);
+
+                    if (coverage > 0.0)
+                    {
+                        // Shade the shape towards its edge so that it is not a single flat color.
+                        const int shade = static_cast<int>((distance * 64) / radius);
+
+                        SetPixel(image, x, y, ClampToByte(b - shade), ClampToByte(g - shade), ClampToByte(r - shade),
+                                 static_cast<uint8_t>(coverage * 255 + 0.5));
+                    }
+                }
+            }
+        }
+    }
+}
+
+const char* Corpus::GetName(CorpusKind kind)
+{
+    switch (kind)
+    {
+    case CorpusKind::Photo:
+        return "photo";
+    case CorpusKind::Graphics:
+        return "graphics";
+    case CorpusKind::AlphaGradient:
+        return "alpha";
+    case CorpusKind::Text:
+        return "text";
+    case CorpusKind::Sprite:
+        return "sprite";
+    default:
+        return "unknown";
+    }
+}
+
+bool Corpus::TryParse(const std::string& name, CorpusKind& kind)
+{
+    const CorpusKind kinds[] = { CorpusKind::Photo, CorpusKind::Graphics, CorpusKind::AlphaGradient, CorpusKind::Text, CorpusKind::Sprite };
+
+    for (CorpusKind item : kinds)
+    {
+        if (name == GetName(item))
+        {
+            kind = item;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+CorpusImage Corpus::Generate(CorpusKind kind, int width, int height)
+{
+    CorpusImage image{};
+    image.kind = kind;
+    image.width = width;
+    image.height = height;
+    image.stride = width * 4;
+    image.pixels.resize(static_cast<size_t>(image.stride) * height);
+
+    // Each kind uses its own seed so that adding a kind does not change the existing images.
+    Random random(0x9E3779B9u + static_cast<uint32_t>(kind));
+
+    switch (kind)
+    {
+    case CorpusKind::Photo:
+        GeneratePhoto(image, random);
+        break;
+    case CorpusKind::Graphics:
+        GenerateGraphics(image, random);
+        break;
+    case CorpusKind::AlphaGradient:
+        GenerateAlphaGradient(image);
+        break;
+    case CorpusKind::Text:
+        GenerateText(image, random);
+        break;
+    case CorpusKind::Sprite:
+        GenerateSprite(image, random);
+        break;
+    }
+
+    return image;
+}
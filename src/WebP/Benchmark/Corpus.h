@@ -0,0 +1,49 @@
+////////////////////////////////////////////////////////////////////////
+//
+// This file is part of pdn-webp, a FileType plugin for Paint.NET
+// that loads and saves WebP images.
+//
+// Copyright (c) 2011-2026 Nicholas Hayes
+//
+// This file is licensed under the MIT License.
+// See LICENSE.txt for complete licensing and attribution information.
+//
+////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The kinds of synthetic image in the benchmark corpus, chosen to exercise the different
+// paths of the lossy and lossless encoders.
+enum class CorpusKind
+{
+    Photo,          // Smooth gradients with fine grain noise.
+    Graphics,       // Flat colored shapes with hard edges and a small palette.
+    AlphaGradient,  // A color gradient with a varying alpha channel.
+    Text,           // Dark glyph strokes on a light background.
+    Sprite          // Anti-aliased shapes on a transparent background that has leftover color noise.
+};
+
+// A 32-bit BGRA image.
+struct CorpusImage
+{
+    CorpusKind kind;
+    int width;
+    int height;
+    int stride;
+    std::vector<uint8_t> pixels;
+};
+
+namespace Corpus
+{
+    const char* GetName(CorpusKind kind);
+
+    // Returns false if the name does not match a corpus kind.
+    bool TryParse(const std::string& name, CorpusKind& kind);
+
+    // The images are generated from a fixed seed, so the corpus is identical on every run and platform.
+    CorpusImage Generate(CorpusKind kind, int width, int height);
+}
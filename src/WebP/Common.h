@@ -12,8 +12,14 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
+#if !defined(_WIN32)
+// The exports use the Windows calling convention keyword, other platforms use their default convention.
+#define __stdcall
+#endif
+
 enum class WebPStatus : int32_t
 {
     Ok = 0,
@@ -0,0 +1,203 @@
+////////////////////////////////////////////////////////////////////////
+//
+// This file is part of pdn-webp, a FileType plugin for Paint.NET
+// that loads and saves WebP images.
+//
+// Copyright (c) 2011-2026 Nicholas Hayes
+//
+// This file is licensed under the MIT License.
+// See LICENSE.txt for complete licensing and attribution information.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include "EncodeQueue.h"
+#include <memory>
+#include <vector>
+
+struct EncodeQueue::Job
+{
+    const void* bitmap;
+    int width;
+    int height;
+    int stride;
+    EncoderOptions options;
+    bool hasMetadata;
+    std::vector<uint8_t> iccProfile;
+    std::vector<uint8_t> exif;
+    std::vector<uint8_t> xmp;
+    WriteImageFn writeImageCallback;
+    EncodeJobCompletedFn completedCallback;
+    void* context;
+    uint64_t memoryCost;
+};
+
+namespace
+{
+    void CopyMetadata(std::vector<uint8_t>& destination, const uint8_t* data, size_t size)
+    {
+        if (data != nullptr && size > 0)
+        {
+            destination.assign(data, data + size);
+        }
+    }
+
+    uint8_t* GetMetadataPointer(std::vector<uint8_t>& data)
+    {
+        return data.empty() ? nullptr : data.data();
+    }
+}
+
+EncodeQueue::EncodeQueue(unsigned int threadCount, uint64_t memoryBudget)
+    : memoryBudget(memoryBudget), memoryInFlight(0), jobsInFlight(0),
+      threadPool(threadCount != 0 ? threadCount : std::thread::hardware_concurrency())
+{
+}
+
+EncodeQueue::~EncodeQueue()
+{
+    Wait();
+}
+
+WebPStatus EncodeQueue::Submit(
+    const void* bitmap,
+    int width,
+    int height,
+    int stride,
+    const EncoderOptions* encodeOptions,
+    const EncoderMetadata* metadata,
+    const WriteImageFn writeImageCallback,
+    const EncodeJobCompletedFn completedCallback,
+    void* context)
+{
+    if (bitmap == nullptr
+        || width <= 0
+        || height <= 0
+        || stride <= 0
+        || encodeOptions == nullptr
+        || writeImageCallback == nullptr
+        || completedCallback == nullptr)
+    {
+        return WebPStatus::InvalidParameter;
+    }
+
+    std::unique_ptr<Job> job;
+
+    try
+    {
+        job.reset(new Job());
+
+        job->hasMetadata = metadata != nullptr;
+
+        if (metadata != nullptr)
+        {
+            CopyMetadata(job->iccProfile, metadata->iccProfile, metadata->iccProfileSize);
+            CopyMetadata(job->exif, metadata->exif, metadata->exifSize);
+            CopyMetadata(job->xmp, metadata->xmp, metadata->xmpSize);
+        }
+    }
+    catch (const std::bad_alloc&)
+    {
+        return WebPStatus::OutOfMemory;
+    }
+
+    job->bitmap = bitmap;
+    job->width = width;
+    job->height = height;
+    job->stride = stride;
+    job->options = *encodeOptions;
+    job->writeImageCallback = writeImageCallback;
+    job->completedCallback = completedCallback;
+    job->context = context;
+    // The transparency scan has not run yet, so assume the worst case for the alpha plane.
+    job->memoryCost = WebPEncoder::EstimateWorkingSet(width, height, encodeOptions->lossless, true)
+        + static_cast<uint64_t>(stride) * static_cast<uint64_t>(height)
+        + job->iccProfile.size()
+        + job->exif.size()
+        + job->xmp.size();
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        if (memoryBudget != 0)
+        {
+            // A job that is larger than the whole budget is allowed to run by itself,
+            // otherwise it would never be started.
+            jobCompleted.wait(lock, [this, &job]()
+            {
+                return jobsInFlight == 0 || (memoryInFlight + job->memoryCost) <= memoryBudget;
+            });
+        }
+
+        memoryInFlight += job->memoryCost;
+        jobsInFlight++;
+    }
+
+    Job* rawJob = job.get();
+
+    if (!threadPool.Submit([this, rawJob]() { RunJob(rawJob); }))
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            memoryInFlight -= job->memoryCost;
+            jobsInFlight--;
+        }
+
+        jobCompleted.notify_all();
+
+        return WebPStatus::OutOfMemory;
+    }
+
+    job.release();
+
+    return WebPStatus::Ok;
+}
+
+void EncodeQueue::Wait()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    jobCompleted.wait(lock, [this]() { return jobsInFlight == 0; });
+}
+
+void EncodeQueue::RunJob(Job* job)
+{
+    std::unique_ptr<Job> ownedJob(job);
+
+    EncoderMetadata metadata{};
+    metadata.iccProfile = GetMetadataPointer(job->iccProfile);
+    metadata.iccProfileSize = job->iccProfile.size();
+    metadata.exif = GetMetadataPointer(job->exif);
+    metadata.exifSize = job->exif.size();
+    metadata.xmp = GetMetadataPointer(job->xmp);
+    metadata.xmpSize = job->xmp.size();
+
+    WebPStatus status = WebPEncoder::Encode(
+        job->writeImageCallback,
+        job->bitmap,
+        job->width,
+        job->height,
+        job->stride,
+        EncoderPixelFormat::Bgra,
+        nullptr,
+        &job->options,
+        job->hasMetadata ? &metadata : nullptr,
+        nullptr,
+        job->context,
+        nullptr,
+        nullptr);
+
+    job->completedCallback(job->context, status);
+
+    const uint64_t memoryCost = job->memoryCost;
+    ownedJob.reset();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        memoryInFlight -= memoryCost;
+        jobsInFlight--;
+    }
+
+    jobCompleted.notify_all();
+}
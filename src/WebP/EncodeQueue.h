@@ -0,0 +1,66 @@
+////////////////////////////////////////////////////////////////////////
+//
+// This file is part of pdn-webp, a FileType plugin for Paint.NET
+// that loads and saves WebP images.
+//
+// Copyright (c) 2011-2026 Nicholas Hayes
+//
+// This file is licensed under the MIT License.
+// See LICENSE.txt for complete licensing and attribution information.
+//
+////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Common.h"
+#include "ThreadPool.h"
+#include "WebPEncoder.h"
+#include <condition_variable>
+#include <mutex>
+
+// The callback that is invoked on a worker thread when an encode job has finished.
+typedef void(__stdcall* EncodeJobCompletedFn)(void* context, WebPStatus status);
+
+// Encodes images on a dedicated set of worker threads.
+// The memory budget bounds the estimated memory used by the jobs that are in flight,
+// when a new job would exceed it Submit blocks until enough of the running jobs have finished.
+class EncodeQueue
+{
+public:
+    EncodeQueue(unsigned int threadCount, uint64_t memoryBudget);
+
+    // Waits for the pending jobs to complete.
+    ~EncodeQueue();
+
+    // Disable copying and assignment.
+    EncodeQueue(const EncodeQueue&) = delete;
+    const EncodeQueue& operator=(const EncodeQueue&) = delete;
+
+    // Queues an encode job.
+    // The options and metadata are copied, the bitmap must remain valid until the completion callback is invoked.
+    WebPStatus Submit(
+        const void* bitmap,
+        int width,
+        int height,
+        int stride,
+        const EncoderOptions* encodeOptions,
+        const EncoderMetadata* metadata,
+        const WriteImageFn writeImageCallback,
+        const EncodeJobCompletedFn completedCallback,
+        void* context);
+
+    // Waits until all of the queued jobs have completed.
+    void Wait();
+
+private:
+    struct Job;
+
+    void RunJob(Job* job);
+
+    uint64_t memoryBudget;
+    uint64_t memoryInFlight;
+    size_t jobsInFlight;
+    std::mutex mutex;
+    std::condition_variable jobCompleted;
+    ThreadPool threadPool;
+};
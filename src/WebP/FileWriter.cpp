@@ -0,0 +1,149 @@
+////////////////////////////////////////////////////////////////////////
+//
+// This file is part of pdn-webp, a FileType plugin for Paint.NET
+// that loads and saves WebP images.
+//
+// Copyright (c) 2011-2026 Nicholas Hayes
+//
+// This file is licensed under the MIT License.
+// See LICENSE.txt for complete licensing and attribution information.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include "FileWriter.h"
+#include <algorithm>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/falloc.h>
+#endif // __linux__
+#endif // _WIN32
+
+namespace
+{
+    // A multiple of the sector and page sizes that is large enough to amortize the cost of each write call.
+    constexpr size_t WriteBlockSize = 4 * 1024 * 1024;
+
+#ifdef _WIN32
+    bool WriteAll(HANDLE file, const uint8_t* data, size_t size)
+    {
+        FILE_ALLOCATION_INFO allocationInfo{};
+        allocationInfo.AllocationSize.QuadPart = static_cast<LONGLONG>(size);
+
+        // Preallocation is only a hint to the file system, so a failure is not an error.
+        SetFileInformationByHandle(file, FileAllocationInfo, &allocationInfo, sizeof(allocationInfo));
+
+        while (size > 0)
+        {
+            const DWORD blockSize = static_cast<DWORD>(std::min(size, WriteBlockSize));
+            DWORD bytesWritten = 0;
+
+            if (!::WriteFile(file, data, blockSize, &bytesWritten, nullptr) || bytesWritten == 0)
+            {
+                return false;
+            }
+
+            data += bytesWritten;
+            size -= bytesWritten;
+        }
+
+        return true;
+    }
+#else
+    bool WriteAll(int file, const uint8_t* data, size_t size)
+    {
+#ifdef __linux__
+        // Preallocation is only a hint to the file system, so a failure is not an error.
+        // posix_fallocate is not used because glibc emulates it by writing zeros when the file
+        // system does not support fallocate, which returns EOPNOTSUPP instead.
+        // FALLOC_FL_KEEP_SIZE leaves the file size to the writes.
+        while (fallocate(file, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(size)) != 0 && errno == EINTR)
+        {
+        }
+#endif // __linux__
+
+        while (size > 0)
+        {
+            const ssize_t bytesWritten = write(file, data, std::min(size, WriteBlockSize));
+
+            if (bytesWritten < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+
+                return false;
+            }
+
+            data += bytesWritten;
+            size -= static_cast<size_t>(bytesWritten);
+        }
+
+        return true;
+    }
+#endif // _WIN32
+}
+
+WebPStatus FileWriter::WriteFile(const FilePathChar* path, const uint8_t* data, size_t size)
+{
+    if (path == nullptr || data == nullptr)
+    {
+        return WebPStatus::InvalidParameter;
+    }
+
+#ifdef _WIN32
+    HANDLE file = CreateFileW(
+        path,
+        GENERIC_WRITE,
+        0,
+        nullptr,
+        CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+        nullptr);
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return WebPStatus::BadWrite;
+    }
+
+    const bool succeeded = WriteAll(file, data, size);
+    const bool closed = CloseHandle(file) != FALSE;
+
+    if (!succeeded || !closed)
+    {
+        DeleteFileW(path);
+        return WebPStatus::BadWrite;
+    }
+#else
+    int file;
+
+    do
+    {
+        file = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    } while (file < 0 && errno == EINTR);
+
+    if (file < 0)
+    {
+        return WebPStatus::BadWrite;
+    }
+
+    const bool succeeded = WriteAll(file, data, size);
+    const bool closed = close(file) == 0;
+
+    if (!succeeded || !closed)
+    {
+        unlink(path);
+        return WebPStatus::BadWrite;
+    }
+#endif // _WIN32
+
+    return WebPStatus::Ok;
+}
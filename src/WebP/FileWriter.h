@@ -0,0 +1,29 @@
+////////////////////////////////////////////////////////////////////////
+//
+// This file is part of pdn-webp, a FileType plugin for Paint.NET
+// that loads and saves WebP images.
+//
+// Copyright (c) 2011-2026 Nicholas Hayes
+//
+// This file is licensed under the MIT License.
+// See LICENSE.txt for complete licensing and attribution information.
+//
+////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Common.h"
+
+#ifdef _WIN32
+typedef wchar_t FilePathChar;
+#else
+typedef char FilePathChar;
+#endif // _WIN32
+
+namespace FileWriter
+{
+    // Creates or truncates the file and writes the data to it.
+    // The file is preallocated to the final size and written in large sequential blocks,
+    // if any of the writes fail the partial file is deleted.
+    WebPStatus WriteFile(const FilePathChar* path, const uint8_t* data, size_t size);
+}
@@ -0,0 +1,145 @@
+////////////////////////////////////////////////////////////////////////
+//
+// This file is part of pdn-webp, a FileType plugin for Paint.NET
+// that loads and saves WebP images.
+//
+// Copyright (c) 2011-2026 Nicholas Hayes
+//
+// This file is licensed under the MIT License.
+// See LICENSE.txt for complete licensing and attribution information.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include "MemoryTracker.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+MemoryTracker::MemoryTracker(uint64_t limit)
+    : limit(limit), currentUsage(0), peakUsage(0), limitExceeded(false)
+{
+}
+
+bool MemoryTracker::Reserve(uint64_t size)
+{
+    if (!CanReserve(size))
+    {
+        limitExceeded = true;
+        return false;
+    }
+
+    currentUsage += size;
+
+    if (currentUsage > peakUsage)
+    {
+        peakUsage = currentUsage;
+    }
+
+    return true;
+}
+
+void MemoryTracker::Release(uint64_t size)
+{
+    currentUsage = size < currentUsage ? currentUsage - size : 0;
+}
+
+bool MemoryTracker::CanReserve(uint64_t size) const
+{
+    return limit == 0 || size <= GetAvailable();
+}
+
+uint64_t MemoryTracker::GetAvailable() const
+{
+    if (limit == 0)
+    {
+        return UINT64_MAX;
+    }
+
+    return currentUsage < limit ? limit - currentUsage : 0;
+}
+
+TrackedMemoryWriter::TrackedMemoryWriter(MemoryTracker& tracker)
+    : tracker(tracker), buffer(nullptr), size(0), capacity(0)
+{
+}
+
+TrackedMemoryWriter::~TrackedMemoryWriter()
+{
+    if (buffer != nullptr)
+    {
+        std::free(buffer);
+        tracker.Release(capacity);
+        buffer = nullptr;
+    }
+}
+
+int TrackedMemoryWriter::Write(const uint8_t* data, size_t dataSize, const WebPPicture* picture)
+{
+    TrackedMemoryWriter* writer = static_cast<TrackedMemoryWriter*>(picture->custom_ptr);
+
+    if (writer == nullptr)
+    {
+        return 0;
+    }
+
+    if (dataSize == 0)
+    {
+        return 1;
+    }
+
+    const size_t requiredSize = writer->size + dataSize;
+
+    if (requiredSize < writer->size)
+    {
+        return 0;
+    }
+
+    if (requiredSize > writer->capacity)
+    {
+        // Grow the buffer geometrically to reduce the number of reallocations.
+        size_t newCapacity = writer->capacity > 0 ? writer->capacity * 2 : 8192;
+
+        if (newCapacity < requiredSize)
+        {
+            newCapacity = requiredSize;
+        }
+
+        // Fall back to the required size when the doubled capacity does not fit in the remaining budget,
+        // the output may still fit.
+        const uint64_t available = writer->tracker.GetAvailable();
+
+        if (newCapacity - writer->capacity > available)
+        {
+            newCapacity = std::max(requiredSize, static_cast<size_t>(std::min<uint64_t>(writer->capacity + available, SIZE_MAX)));
+        }
+
+        if (!writer->tracker.Reserve(newCapacity - writer->capacity))
+        {
+            return 0;
+        }
+
+        uint8_t* newBuffer = static_cast<uint8_t*>(std::realloc(writer->buffer, newCapacity));
+
+        if (newBuffer == nullptr && newCapacity > requiredSize)
+        {
+            writer->tracker.Release(newCapacity - requiredSize);
+            newCapacity = requiredSize;
+            newBuffer = static_cast<uint8_t*>(std::realloc(writer->buffer, newCapacity));
+        }
+
+        if (newBuffer == nullptr)
+        {
+            writer->tracker.Release(newCapacity - writer->capacity);
+            return 0;
+        }
+
+        writer->buffer = newBuffer;
+        writer->capacity = newCapacity;
+    }
+
+    std::memcpy(writer->buffer + writer->size, data, dataSize);
+    writer->size += dataSize;
+
+    return 1;
+}
@@ -0,0 +1,95 @@
+////////////////////////////////////////////////////////////////////////
+//
+// This file is part of pdn-webp, a FileType plugin for Paint.NET
+// that loads and saves WebP images.
+//
+// Copyright (c) 2011-2026 Nicholas Hayes
+//
+// This file is licensed under the MIT License.
+// See LICENSE.txt for complete licensing and attribution information.
+//
+////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Common.h"
+#include "encode.h"
+
+// The caller-supplied memory budget for a decode or encode call.
+// This must be kept in sync with the Native structure in MemoryBudget.cs.
+typedef struct MemoryBudget
+{
+    uint64_t limit;         // The maximum number of bytes, 0 for no limit.
+    bool allowDownscale;    // Decoder only, downscale the image to fit the limit instead of failing.
+    uint64_t peakUsage;     // Output: the peak memory usage of the call.
+}MemoryBudget;
+
+// Tracks the memory that is allocated by, or on behalf of, a single decode or encode call.
+// libwebp does not expose an allocator hook, so its internal buffers are reserved using estimates.
+class MemoryTracker
+{
+public:
+    MemoryTracker(uint64_t limit);
+
+    // Disable copying and assignment.
+    MemoryTracker(const MemoryTracker&) = delete;
+    const MemoryTracker& operator=(const MemoryTracker&) = delete;
+
+    // Returns true if the reservation fits within the limit.
+    bool Reserve(uint64_t size);
+
+    void Release(uint64_t size);
+
+    // Returns true if the specified size would fit within the limit.
+    bool CanReserve(uint64_t size) const;
+
+    uint64_t GetAvailable() const;
+
+    uint64_t GetPeakUsage() const
+    {
+        return peakUsage;
+    }
+
+    bool IsLimitExceeded() const
+    {
+        return limitExceeded;
+    }
+
+private:
+    uint64_t limit;
+    uint64_t currentUsage;
+    uint64_t peakUsage;
+    bool limitExceeded;
+};
+
+// A WebPWriterFunction target that allocates its buffer through a MemoryTracker.
+class TrackedMemoryWriter
+{
+public:
+    TrackedMemoryWriter(MemoryTracker& tracker);
+
+    ~TrackedMemoryWriter();
+
+    // Disable copying and assignment.
+    TrackedMemoryWriter(const TrackedMemoryWriter&) = delete;
+    const TrackedMemoryWriter& operator=(const TrackedMemoryWriter&) = delete;
+
+    // The writer function, picture->custom_ptr must point to the TrackedMemoryWriter.
+    static int Write(const uint8_t* data, size_t dataSize, const WebPPicture* picture);
+
+    const uint8_t* GetBuffer() const
+    {
+        return buffer;
+    }
+
+    size_t GetBufferSize() const
+    {
+        return size;
+    }
+
+private:
+    MemoryTracker& tracker;
+    uint8_t* buffer;
+    size_t size;
+    size_t capacity;
+};
@@ -0,0 +1,234 @@
+////////////////////////////////////////////////////////////////////////
+//
+// This file is part of pdn-webp, a FileType plugin for Paint.NET
+// that loads and saves WebP images.
+//
+// Copyright (c) 2011-2026 Nicholas Hayes
+//
+// This file is licensed under the MIT License.
+// See LICENSE.txt for complete licensing and attribution information.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include "Metrics.h"
+#include <atomic>
+
+namespace
+{
+    constexpr unsigned int ShardCount = 16;
+
+    // Each shard is aligned to a cache line to prevent false sharing between threads.
+    struct alignas(64) MetricsShard
+    {
+        std::atomic<uint64_t> imagesDecoded;
+        std::atomic<uint64_t> bytesDecoded;
+        std::atomic<uint64_t> pixelsDecoded;
+        std::atomic<uint64_t> imagesEncoded;
+        std::atomic<uint64_t> bytesEncoded;
+        std::atomic<uint64_t> pixelsEncoded;
+        std::atomic<uint64_t> decodeFailures[MetricsStatusCount];
+        std::atomic<uint64_t> encodeFailures[MetricsStatusCount];
+        std::atomic<uint64_t> decodeLatency[MetricsMegapixelBuckets][MetricsLatencyBuckets];
+        std::atomic<uint64_t> encodeLatency[2][MetricsEffortLevels][MetricsMegapixelBuckets][MetricsLatencyBuckets];
+        std::atomic<uint64_t> peakDecodeTransientBytes;
+        std::atomic<uint64_t> peakEncodeTransientBytes;
+    };
+
+    MetricsShard shards[ShardCount];
+    std::atomic<unsigned int> nextShardIndex(0);
+
+    MetricsShard& GetThreadShard()
+    {
+        thread_local unsigned int shardIndex = nextShardIndex.fetch_add(1, std::memory_order_relaxed) % ShardCount;
+
+        return shards[shardIndex];
+    }
+
+    void Increment(std::atomic<uint64_t>& counter, uint64_t value = 1)
+    {
+        counter.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    void UpdateMaximum(std::atomic<uint64_t>& counter, uint64_t value)
+    {
+        uint64_t current = counter.load(std::memory_order_relaxed);
+
+        while (value > current && !counter.compare_exchange_weak(current, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    int GetMegapixelBucket(uint64_t pixelCount)
+    {
+        uint64_t threshold = 262144; // 0.25 megapixels
+        int bucket = 0;
+
+        while (bucket < MetricsMegapixelBuckets - 1 && pixelCount >= threshold)
+        {
+            threshold *= 4;
+            bucket++;
+        }
+
+        return bucket;
+    }
+
+    int GetLatencyBucket(double milliseconds)
+    {
+        double threshold = 1.0;
+        int bucket = 0;
+
+        while (bucket < MetricsLatencyBuckets - 1 && milliseconds >= threshold)
+        {
+            threshold *= 2.0;
+            bucket++;
+        }
+
+        return bucket;
+    }
+
+    int GetStatusIndex(WebPStatus status)
+    {
+        const int index = static_cast<int>(status);
+
+        return index >= 0 && index < MetricsStatusCount ? index : static_cast<int>(WebPStatus::UnknownError);
+    }
+}
+
+void Metrics::RecordDecode(
+    WebPStatus status,
+    size_t dataSize,
+    const OperationInfo& info,
+    double milliseconds)
+{
+    MetricsShard& shard = GetThreadShard();
+
+    if (status == WebPStatus::Ok)
+    {
+        Increment(shard.imagesDecoded);
+        Increment(shard.bytesDecoded, dataSize);
+        Increment(shard.pixelsDecoded, info.pixelCount);
+        Increment(shard.decodeLatency[GetMegapixelBucket(info.pixelCount)][GetLatencyBucket(milliseconds)]);
+    }
+    else
+    {
+        Increment(shard.decodeFailures[GetStatusIndex(status)]);
+    }
+
+    UpdateMaximum(shard.peakDecodeTransientBytes, info.transientBytes);
+}
+
+void Metrics::RecordEncode(
+    WebPStatus status,
+    bool lossless,
+    int effort,
+    const OperationInfo& info,
+    double milliseconds)
+{
+    MetricsShard& shard = GetThreadShard();
+
+    if (status == WebPStatus::Ok)
+    {
+        const int mode = lossless ? 1 : 0;
+        const int effortIndex = effort < 0 ? 0 : effort >= MetricsEffortLevels ? MetricsEffortLevels - 1 : effort;
+
+        Increment(shard.imagesEncoded);
+        Increment(shard.bytesEncoded, info.outputSize);
+        Increment(shard.pixelsEncoded, info.pixelCount);
+        Increment(shard.encodeLatency[mode][effortIndex][GetMegapixelBucket(info.pixelCount)][GetLatencyBucket(milliseconds)]);
+    }
+    else
+    {
+        Increment(shard.encodeFailures[GetStatusIndex(status)]);
+    }
+
+    UpdateMaximum(shard.peakEncodeTransientBytes, info.transientBytes);
+}
+
+void Metrics::GetSnapshot(WebPMetrics* metrics)
+{
+    *metrics = {};
+
+    for (const MetricsShard& shard : shards)
+    {
+        metrics->imagesDecoded += shard.imagesDecoded.load(std::memory_order_relaxed);
+        metrics->bytesDecoded += shard.bytesDecoded.load(std::memory_order_relaxed);
+        metrics->pixelsDecoded += shard.pixelsDecoded.load(std::memory_order_relaxed);
+        metrics->imagesEncoded += shard.imagesEncoded.load(std::memory_order_relaxed);
+        metrics->bytesEncoded += shard.bytesEncoded.load(std::memory_order_relaxed);
+        metrics->pixelsEncoded += shard.pixelsEncoded.load(std::memory_order_relaxed);
+
+        for (int i = 0; i < MetricsStatusCount; i++)
+        {
+            metrics->decodeFailures[i] += shard.decodeFailures[i].load(std::memory_order_relaxed);
+            metrics->encodeFailures[i] += shard.encodeFailures[i].load(std::memory_order_relaxed);
+        }
+
+        for (int megapixels = 0; megapixels < MetricsMegapixelBuckets; megapixels++)
+        {
+            for (int latency = 0; latency < MetricsLatencyBuckets; latency++)
+            {
+                metrics->decodeLatency[megapixels][latency] += shard.decodeLatency[megapixels][latency].load(std::memory_order_relaxed);
+
+                for (int mode = 0; mode < 2; mode++)
+                {
+                    for (int effort = 0; effort < MetricsEffortLevels; effort++)
+                    {
+                        metrics->encodeLatency[mode][effort][megapixels][latency] +=
+                            shard.encodeLatency[mode][effort][megapixels][latency].load(std::memory_order_relaxed);
+                    }
+                }
+            }
+        }
+
+        const uint64_t peakDecode = shard.peakDecodeTransientBytes.load(std::memory_order_relaxed);
+        const uint64_t peakEncode = shard.peakEncodeTransientBytes.load(std::memory_order_relaxed);
+
+        if (peakDecode > metrics->peakDecodeTransientBytes)
+        {
+            metrics->peakDecodeTransientBytes = peakDecode;
+        }
+
+        if (peakEncode > metrics->peakEncodeTransientBytes)
+        {
+            metrics->peakEncodeTransientBytes = peakEncode;
+        }
+    }
+}
+
+void Metrics::Reset()
+{
+    for (MetricsShard& shard : shards)
+    {
+        shard.imagesDecoded.store(0, std::memory_order_relaxed);
+        shard.bytesDecoded.store(0, std::memory_order_relaxed);
+        shard.pixelsDecoded.store(0, std::memory_order_relaxed);
+        shard.imagesEncoded.store(0, std::memory_order_relaxed);
+        shard.bytesEncoded.store(0, std::memory_order_relaxed);
+        shard.pixelsEncoded.store(0, std::memory_order_relaxed);
+
+        for (int i = 0; i < MetricsStatusCount; i++)
+        {
+            shard.decodeFailures[i].store(0, std::memory_order_relaxed);
+            shard.encodeFailures[i].store(0, std::memory_order_relaxed);
+        }
+
+        for (int megapixels = 0; megapixels < MetricsMegapixelBuckets; megapixels++)
+        {
+            for (int latency = 0; latency < MetricsLatencyBuckets; latency++)
+            {
+                shard.decodeLatency[megapixels][latency].store(0, std::memory_order_relaxed);
+
+                for (int mode = 0; mode < 2; mode++)
+                {
+                    for (int effort = 0; effort < MetricsEffortLevels; effort++)
+                    {
+                        shard.encodeLatency[mode][effort][megapixels][latency].store(0, std::memory_order_relaxed);
+                    }
+                }
+            }
+        }
+
+        shard.peakDecodeTransientBytes.store(0, std::memory_order_relaxed);
+        shard.peakEncodeTransientBytes.store(0, std::memory_order_relaxed);
+    }
+}
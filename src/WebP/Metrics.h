@@ -0,0 +1,72 @@
+////////////////////////////////////////////////////////////////////////
+//
+// This file is part of pdn-webp, a FileType plugin for Paint.NET
+// that loads and saves WebP images.
+//
+// Copyright (c) 2011-2026 Nicholas Hayes
+//
+// This file is licensed under the MIT License.
+// See LICENSE.txt for complete licensing and attribution information.
+//
+////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Common.h"
+
+constexpr int MetricsStatusCount = static_cast<int>(WebPStatus::DecodeFailed) + 1;
+constexpr int MetricsEffortLevels = 10;
+// The megapixel buckets are < 0.25, < 1, < 4, < 16, < 64 and >= 64 megapixels.
+constexpr int MetricsMegapixelBuckets = 6;
+// Bucket 0 is < 1 ms, bucket N is [2^(N-1), 2^N) ms and the last bucket is everything above that.
+constexpr int MetricsLatencyBuckets = 16;
+
+// A snapshot of the process-wide decoder and encoder metrics.
+// This must be kept in sync with the WebPMetrics structure in WebPMetrics.cs.
+typedef struct WebPMetrics
+{
+    uint64_t imagesDecoded;
+    uint64_t bytesDecoded; // The size of the compressed input.
+    uint64_t pixelsDecoded;
+    uint64_t imagesEncoded;
+    uint64_t bytesEncoded; // The size of the output file.
+    uint64_t pixelsEncoded;
+    uint64_t decodeFailures[MetricsStatusCount];
+    uint64_t encodeFailures[MetricsStatusCount];
+    uint64_t decodeLatency[MetricsMegapixelBuckets][MetricsLatencyBuckets];
+    // Indexed by lossy/lossless, effort level and megapixel bucket.
+    uint64_t encodeLatency[2][MetricsEffortLevels][MetricsMegapixelBuckets][MetricsLatencyBuckets];
+    // The largest transient allocation of a single call.
+    uint64_t peakDecodeTransientBytes;
+    uint64_t peakEncodeTransientBytes;
+}WebPMetrics;
+
+// The counters are sharded per thread to avoid contention between
+// concurrent decoder and encoder calls, a snapshot sums the shards.
+namespace Metrics
+{
+    // The values that are collected over a single decode or encode call.
+    struct OperationInfo
+    {
+        uint64_t pixelCount;
+        uint64_t outputSize;
+        uint64_t transientBytes;
+    };
+
+    void RecordDecode(
+        WebPStatus status,
+        size_t dataSize,
+        const OperationInfo& info,
+        double milliseconds);
+
+    void RecordEncode(
+        WebPStatus status,
+        bool lossless,
+        int effort,
+        const OperationInfo& info,
+        double milliseconds);
+
+    void GetSnapshot(WebPMetrics* metrics);
+
+    void Reset();
+}
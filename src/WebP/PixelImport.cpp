@@ -0,0 +1,239 @@
+////////////////////////////////////////////////////////////////////////
+//
+// This file is part of pdn-webp, a FileType plugin for Paint.NET
+// that loads and saves WebP images.
+//
+// Copyright (c) 2011-2026 Nicholas Hayes
+//
+// This file is licensed under the MIT License.
+// See LICENSE.txt for complete licensing and attribution information.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include "PixelImport.h"
+#include <algorithm>
+
+namespace
+{
+    uint32_t PackARGB(uint32_t a, uint32_t r, uint32_t g, uint32_t b)
+    {
+        return (a << 24) | (r << 16) | (g << 8) | b;
+    }
+
+    struct BgraReader
+    {
+        uint8_t GetAlpha(const uint8_t* row, int x) const
+        {
+            return row[(x * 4) + 3];
+        }
+
+        uint32_t GetARGB(const uint8_t* row, int x, int) const
+        {
+            const uint8_t* ptr = row + (x * 4);
+
+            return PackARGB(ptr[3], ptr[2], ptr[1], ptr[0]);
+        }
+    };
+
+    struct RgbaReader
+    {
+        uint8_t GetAlpha(const uint8_t* row, int x) const
+        {
+            return row[(x * 4) + 3];
+        }
+
+        uint32_t GetARGB(const uint8_t* row, int x, int) const
+        {
+            const uint8_t* ptr = row + (x * 4);
+
+            return PackARGB(ptr[3], ptr[0], ptr[1], ptr[2]);
+        }
+    };
+
+    // The scale factors are 16.16 fixed point values of 255 / alpha, so that the
+    // color channels can be un-premultiplied without a division per channel.
+    const uint32_t* GetUnpremultiplyTable()
+    {
+        static const struct Table
+        {
+            uint32_t values[256];
+
+            Table() : values()
+            {
+                for (uint32_t alpha = 1; alpha < 256; alpha++)
+                {
+                    values[alpha] = ((255 << 16) + (alpha / 2)) / alpha;
+                }
+            }
+        } table;
+
+        return table.values;
+    }
+
+    struct PremultipliedBgraReader
+    {
+        const uint32_t* scale = GetUnpremultiplyTable();
+
+        uint8_t GetAlpha(const uint8_t* row, int x) const
+        {
+            return row[(x * 4) + 3];
+        }
+
+        uint32_t GetARGB(const uint8_t* row, int x, int) const
+        {
+            const uint8_t* ptr = row + (x * 4);
+            const uint32_t alpha = ptr[3];
+
+            if (alpha == 255)
+            {
+                return PackARGB(alpha, ptr[2], ptr[1], ptr[0]);
+            }
+            else if (alpha == 0)
+            {
+                return 0;
+            }
+
+            const uint32_t factor = scale[alpha];
+
+            return PackARGB(alpha, Unpremultiply(ptr[2], factor), Unpremultiply(ptr[1], factor), Unpremultiply(ptr[0], factor));
+        }
+
+        static uint32_t Unpremultiply(uint32_t value, uint32_t factor)
+        {
+            return std::min((value * factor + 0x8000) >> 16, 255u);
+        }
+    };
+
+    // The color channels are reduced to 8-bit with a 4x4 ordered dither to avoid banding in gradients,
+    // the alpha channel is rounded so that opaque pixels stay opaque.
+    struct Rgba64Reader
+    {
+        uint8_t GetAlpha(const uint8_t* row, int x) const
+        {
+            return static_cast<uint8_t>(Reduce(GetChannels(row, x)[3], 32767));
+        }
+
+        uint32_t GetARGB(const uint8_t* row, int x, int y) const
+        {
+            static const uint16_t bayerThresholds[4][4] =
+            {
+                {  2047, 34815, 10239, 43007 },
+                { 51199, 18431, 59391, 26623 },
+                { 14335, 47103,  6143, 38911 },
+                { 63487, 30719, 55295, 22527 }
+            };
+
+            const uint16_t* channels = GetChannels(row, x);
+            const uint32_t threshold = bayerThresholds[y & 3][x & 3];
+
+            return PackARGB(
+                Reduce(channels[3], 32767),
+                Reduce(channels[0], threshold),
+                Reduce(channels[1], threshold),
+                Reduce(channels[2], threshold));
+        }
+
+        static const uint16_t* GetChannels(const uint8_t* row, int x)
+        {
+            return reinterpret_cast<const uint16_t*>(row) + (x * 4);
+        }
+
+        // Maps [0, 65535] to [0, 255], a threshold of 32767 rounds to the nearest value.
+        static uint32_t Reduce(uint32_t value, uint32_t threshold)
+        {
+            return ((value * 255) + threshold) / 65535;
+        }
+    };
+
+    template <typename Reader>
+    bool HasTransparency(const Reader& reader, const uint8_t* scan0, int width, int height, int stride)
+    {
+        for (int y = 0; y < height; y++)
+        {
+            const uint8_t* row = scan0 + (static_cast<int64_t>(y) * stride);
+
+            for (int x = 0; x < width; x++)
+            {
+                if (reader.GetAlpha(row, x) < 255)
+                {
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    template <typename Reader>
+    bool ImportARGB(const Reader& reader, WebPPicture* picture, const uint8_t* scan0, int stride)
+    {
+        picture->use_argb = 1;
+
+        if (!WebPPictureAlloc(picture))
+        {
+            return false;
+        }
+
+        const int width = picture->width;
+        const int height = picture->height;
+
+        for (int y = 0; y < height; y++)
+        {
+            const uint8_t* src = scan0 + (static_cast<int64_t>(y) * stride);
+            uint32_t* dst = picture->argb + (static_cast<int64_t>(y) * picture->argb_stride);
+
+            for (int x = 0; x < width; x++)
+            {
+                dst[x] = reader.GetARGB(src, x, y);
+            }
+        }
+
+        return true;
+    }
+}
+
+bool PixelImport::IsValidFormat(EncoderPixelFormat format)
+{
+    return format >= EncoderPixelFormat::Bgra && format <= EncoderPixelFormat::Rgba64;
+}
+
+int PixelImport::GetBytesPerPixel(EncoderPixelFormat format)
+{
+    return format == EncoderPixelFormat::Rgba64 ? 8 : 4;
+}
+
+bool PixelImport::HasTransparency(const void* bitmap, int width, int height, int stride, EncoderPixelFormat format)
+{
+    const uint8_t* scan0 = static_cast<const uint8_t*>(bitmap);
+
+    switch (format)
+    {
+    case EncoderPixelFormat::PremultipliedBgra:
+        return ::HasTransparency(PremultipliedBgraReader(), scan0, width, height, stride);
+    case EncoderPixelFormat::Rgba:
+        return ::HasTransparency(RgbaReader(), scan0, width, height, stride);
+    case EncoderPixelFormat::Rgba64:
+        return ::HasTransparency(Rgba64Reader(), scan0, width, height, stride);
+    case EncoderPixelFormat::Bgra:
+    default:
+        return ::HasTransparency(BgraReader(), scan0, width, height, stride);
+    }
+}
+
+bool PixelImport::ImportARGB(WebPPicture* picture, const void* bitmap, int stride, EncoderPixelFormat format)
+{
+    const uint8_t* scan0 = static_cast<const uint8_t*>(bitmap);
+
+    switch (format)
+    {
+    case EncoderPixelFormat::PremultipliedBgra:
+        return ::ImportARGB(PremultipliedBgraReader(), picture, scan0, stride);
+    case EncoderPixelFormat::Rgba:
+        return ::ImportARGB(RgbaReader(), picture, scan0, stride);
+    case EncoderPixelFormat::Rgba64:
+        return ::ImportARGB(Rgba64Reader(), picture, scan0, stride);
+    case EncoderPixelFormat::Bgra:
+    default:
+        return ::ImportARGB(BgraReader(), picture, scan0, stride);
+    }
+}
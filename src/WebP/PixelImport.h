@@ -0,0 +1,33 @@
+////////////////////////////////////////////////////////////////////////
+//
+// This file is part of pdn-webp, a FileType plugin for Paint.NET
+// that loads and saves WebP images.
+//
+// Copyright (c) 2011-2026 Nicholas Hayes
+//
+// This file is licensed under the MIT License.
+// See LICENSE.txt for complete licensing and attribution information.
+//
+////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Common.h"
+#include "encode.h"
+#include "WebPEncoder.h"
+
+// The import kernels for the bitmap formats that libwebp cannot import directly.
+// Each format is a compile-time specialization that converts the pixels while writing the picture.
+namespace PixelImport
+{
+    bool IsValidFormat(EncoderPixelFormat format);
+
+    int GetBytesPerPixel(EncoderPixelFormat format);
+
+    // Returns true if any pixel in the bitmap has an alpha value below 255 after it is converted to 8-bit.
+    bool HasTransparency(const void* bitmap, int width, int height, int stride, EncoderPixelFormat format);
+
+    // Converts the bitmap into the ARGB picture in a single pass, the picture must have its width and height set.
+    // Returns false if the picture could not be allocated.
+    bool ImportARGB(WebPPicture* picture, const void* bitmap, int stride, EncoderPixelFormat format);
+}
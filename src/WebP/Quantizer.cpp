@@ -0,0 +1,500 @@
+////////////////////////////////////////////////////////////////////////
+//
+// This file is part of pdn-webp, a FileType plugin for Paint.NET
+// that loads and saves WebP images.
+//
+// Copyright (c) 2011-2026 Nicholas Hayes
+//
+// This file is licensed under the MIT License.
+// See LICENSE.txt for complete licensing and attribution information.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include "Quantizer.h"
+#include <algorithm>
+#include <new>
+#include <unordered_set>
+#include <vector>
+
+namespace
+{
+    constexpr int HistogramBits = 5;
+    constexpr int HistogramShift = 8 - HistogramBits;
+    constexpr uint32_t HistogramSize = 1u << (HistogramBits * 4);
+    constexpr uint32_t OpaqueLevel = (1u << HistogramBits) - 1;
+    constexpr uint16_t NoColor = 0xffff;
+
+    // Added to the distance of the palette entries that would change a fully transparent or
+    // fully opaque pixel, it is larger than any distance between two colors.
+    constexpr int32_t AlphaMismatchDistance = 1 << 20;
+
+    // The channels are in A, R, G, B order.
+    uint32_t GetChannel(uint32_t color, int channel)
+    {
+        return (color >> (24 - (channel * 8))) & 0xff;
+    }
+
+    // Fully transparent and fully opaque pixels have their own alpha levels so that they are never
+    // merged with translucent pixels, the other alpha values share the levels in between.
+    uint32_t GetAlphaLevel(uint32_t alpha)
+    {
+        if (alpha == 0)
+        {
+            return 0;
+        }
+        else if (alpha == 255)
+        {
+            return OpaqueLevel;
+        }
+
+        return 1 + (((alpha - 1) * (OpaqueLevel - 1)) / 254);
+    }
+
+    uint32_t GetHistogramIndex(uint32_t color)
+    {
+        uint32_t index = GetAlphaLevel(GetChannel(color, 0));
+
+        for (int channel = 1; channel < 4; channel++)
+        {
+            index = (index << HistogramBits) | (GetChannel(color, channel) >> HistogramShift);
+        }
+
+        return index;
+    }
+
+    uint32_t GetBinChannel(uint32_t index, int channel)
+    {
+        return (index >> ((3 - channel) * HistogramBits)) & ((1u << HistogramBits) - 1);
+    }
+
+    // The color at the center of a histogram bin.
+    uint32_t GetBinColor(uint32_t index)
+    {
+        const uint32_t alphaLevel = GetBinChannel(index, 0);
+        uint32_t color;
+
+        if (alphaLevel == 0 || alphaLevel == OpaqueLevel)
+        {
+            color = alphaLevel == 0 ? 0 : 255u << 24;
+        }
+        else
+        {
+            color = (1 + (((2 * alphaLevel - 1) * 254) / (2 * (OpaqueLevel - 1)))) << 24;
+        }
+
+        for (int channel = 1; channel < 4; channel++)
+        {
+            const uint32_t value = (GetBinChannel(index, channel) << HistogramShift) | (1u << (HistogramShift - 1));
+
+            color |= value << (24 - (channel * 8));
+        }
+
+        return color;
+    }
+
+    // The transparent, opaque and translucent bins, in the order that MedianCut groups them.
+    int GetAlphaClass(uint32_t index)
+    {
+        const uint32_t alphaLevel = GetBinChannel(index, 0);
+
+        return alphaLevel == 0 ? 0 : alphaLevel == OpaqueLevel ? 1 : 2;
+    }
+
+    bool HasFewColors(const uint32_t* argb, int width, int height, int stride, int maxColors)
+    {
+        std::unordered_set<uint32_t> colors;
+        colors.reserve(static_cast<size_t>(maxColors) + 1);
+
+        for (int y = 0; y < height; y++)
+        {
+            const uint32_t* row = argb + (static_cast<int64_t>(y) * stride);
+
+            for (int x = 0; x < width; x++)
+            {
+                colors.insert(row[x]);
+
+                if (colors.size() > static_cast<size_t>(maxColors))
+                {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    struct Bin
+    {
+        uint32_t index;
+        uint32_t count;
+    };
+
+    // A range of the occupied histogram bins.
+    struct Box
+    {
+        size_t begin;
+        size_t end;
+        uint64_t count;
+        int longestChannel;
+        uint32_t longestExtent;
+        uint32_t maximumAlphaLevel;
+    };
+
+    void MeasureBox(const std::vector<Bin>& bins, Box& box)
+    {
+        uint32_t minimum[4] = { 255, 255, 255, 255 };
+        uint32_t maximum[4] = { 0, 0, 0, 0 };
+
+        box.count = 0;
+
+        for (size_t i = box.begin; i < box.end; i++)
+        {
+            for (int channel = 0; channel < 4; channel++)
+            {
+                const uint32_t value = GetBinChannel(bins[i].index, channel);
+
+                minimum[channel] = std::min(minimum[channel], value);
+                maximum[channel] = std::max(maximum[channel], value);
+            }
+
+            box.count += bins[i].count;
+        }
+
+        box.longestChannel = 0;
+        box.longestExtent = 0;
+        box.maximumAlphaLevel = maximum[0];
+
+        for (int channel = 0; channel < 4; channel++)
+        {
+            const uint32_t extent = maximum[channel] - minimum[channel];
+
+            if (extent > box.longestExtent)
+            {
+                box.longestChannel = channel;
+                box.longestExtent = extent;
+            }
+        }
+    }
+
+    // Splits the boxes until there are maxColors of them, each time splitting the box with the largest
+    // population times extent along its longest channel at the median pixel.
+    // The transparent, opaque and translucent bins start in separate boxes, unless there are only two
+    // colors, in which case the translucent bins share the box of the opaque bins.
+    std::vector<Box> MedianCut(std::vector<Bin>& bins, int maxColors)
+    {
+        std::vector<Box> boxes;
+        boxes.reserve(maxColors);
+
+        std::sort(bins.begin(), bins.end(), [](const Bin& left, const Bin& right)
+        {
+            return GetAlphaClass(left.index) < GetAlphaClass(right.index);
+        });
+
+        size_t begin = 0;
+
+        while (begin < bins.size())
+        {
+            size_t end = begin + 1;
+
+            if (boxes.size() + 1 < static_cast<size_t>(maxColors))
+            {
+                while (end < bins.size() && GetAlphaClass(bins[end].index) == GetAlphaClass(bins[begin].index))
+                {
+                    end++;
+                }
+            }
+            else
+            {
+                end = bins.size();
+            }
+
+            Box box{ begin, end, 0, 0, 0, 0 };
+            MeasureBox(bins, box);
+            boxes.push_back(box);
+
+            begin = end;
+        }
+
+        while (boxes.size() < static_cast<size_t>(maxColors))
+        {
+            size_t selected = boxes.size();
+            uint64_t selectedScore = 0;
+
+            for (size_t i = 0; i < boxes.size(); i++)
+            {
+                const uint64_t score = boxes[i].count * boxes[i].longestExtent;
+
+                if (score > selectedScore && boxes[i].end - boxes[i].begin > 1)
+                {
+                    selected = i;
+                    selectedScore = score;
+                }
+            }
+
+            if (selected == boxes.size())
+            {
+                break;
+            }
+
+            Box& box = boxes[selected];
+            const int channel = box.longestChannel;
+
+            std::sort(bins.begin() + box.begin, bins.begin() + box.end, [channel](const Bin& left, const Bin& right)
+            {
+                return GetBinChannel(left.index, channel) < GetBinChannel(right.index, channel);
+            });
+
+            // Both halves keep at least one bin.
+            size_t split = box.begin + 1;
+            uint64_t lowerCount = bins[box.begin].count;
+
+            while (split < box.end - 1 && lowerCount + bins[split].count <= box.count / 2)
+            {
+                lowerCount += bins[split].count;
+                split++;
+            }
+
+            Box upper{ split, box.end, 0, 0, 0, 0 };
+            box.end = split;
+
+            MeasureBox(bins, box);
+            MeasureBox(bins, upper);
+            boxes.push_back(upper);
+        }
+
+        return boxes;
+    }
+
+    // The palette is stored as one array per channel so that the distance loop can be vectorized.
+    struct Palette
+    {
+        int size;
+        int32_t channels[4][256];
+        uint32_t colors[256];
+
+        uint16_t FindNearest(uint32_t color) const
+        {
+            int32_t distances[256];
+
+            const int32_t a = GetChannel(color, 0);
+            const int32_t r = GetChannel(color, 1);
+            const int32_t g = GetChannel(color, 2);
+            const int32_t b = GetChannel(color, 3);
+
+            // Fully transparent and fully opaque colors only map to an entry with the same alpha, if there is one.
+            const int32_t mismatchDistance = (a == 0 || a == 255) ? AlphaMismatchDistance : 0;
+
+            for (int i = 0; i < size; i++)
+            {
+                const int32_t da = channels[0][i] - a;
+                const int32_t dr = channels[1][i] - r;
+                const int32_t dg = channels[2][i] - g;
+                const int32_t db = channels[3][i] - b;
+
+                distances[i] = (da * da) + (dr * dr) + (dg * dg) + (db * db) + (da != 0 ? mismatchDistance : 0);
+            }
+
+            return static_cast<uint16_t>(std::min_element(distances, distances + size) - distances);
+        }
+    };
+
+    // The nearest palette entry of each histogram bin, computed when the bin is first used.
+    class NearestColorCache
+    {
+    public:
+        NearestColorCache(const Palette& palette) : palette(palette), entries(HistogramSize, NoColor)
+        {
+        }
+
+        uint32_t Map(uint32_t color)
+        {
+            const uint32_t index = GetHistogramIndex(color);
+            uint16_t& entry = entries[index];
+
+            if (entry == NoColor)
+            {
+                entry = palette.FindNearest(GetBinColor(index));
+            }
+
+            return palette.colors[entry];
+        }
+
+    private:
+        const Palette& palette;
+        std::vector<uint16_t> entries;
+    };
+
+    int ClampChannel(int value)
+    {
+        return std::min(std::max(value, 0), 255);
+    }
+
+    // Floyd-Steinberg error diffusion, the error of each channel is carried in 1/16 units.
+    // The alpha error is not added to fully transparent or fully opaque pixels.
+    void MapWithDither(uint32_t* argb, int width, int height, int stride, NearestColorCache& cache)
+    {
+        std::vector<int32_t> currentErrors((static_cast<size_t>(width) + 2) * 4, 0);
+        std::vector<int32_t> nextErrors((static_cast<size_t>(width) + 2) * 4, 0);
+
+        for (int y = 0; y < height; y++)
+        {
+            uint32_t* row = argb + (static_cast<int64_t>(y) * stride);
+
+            std::fill(nextErrors.begin(), nextErrors.end(), 0);
+
+            for (int x = 0; x < width; x++)
+            {
+                int32_t* error = &currentErrors[(static_cast<size_t>(x) + 1) * 4];
+                uint32_t adjusted = 0;
+
+                const uint32_t alpha = GetChannel(row[x], 0);
+                const int alphaError = (alpha == 0 || alpha == 255) ? 0 : ((error[0] + 8) >> 4);
+
+                adjusted = static_cast<uint32_t>(ClampChannel(static_cast<int>(alpha) + alphaError)) << 24;
+
+                for (int channel = 1; channel < 4; channel++)
+                {
+                    const int value = ClampChannel(static_cast<int>(GetChannel(row[x], channel)) + ((error[channel] + 8) >> 4));
+
+                    adjusted |= static_cast<uint32_t>(value) << (24 - (channel * 8));
+                }
+
+                const uint32_t mapped = cache.Map(adjusted);
+
+                for (int channel = 0; channel < 4; channel++)
+                {
+                    const int32_t difference = static_cast<int32_t>(GetChannel(adjusted, channel)) - static_cast<int32_t>(GetChannel(mapped, channel));
+
+                    error[4 + channel] += difference * 7;
+                    nextErrors[(static_cast<size_t>(x) * 4) + channel] += difference * 3;
+                    nextErrors[((static_cast<size_t>(x) + 1) * 4) + channel] += difference * 5;
+                    nextErrors[((static_cast<size_t>(x) + 2) * 4) + channel] += difference;
+                }
+
+                row[x] = mapped;
+            }
+
+            currentErrors.swap(nextErrors);
+        }
+    }
+}
+
+bool Quantizer::QuantizeARGB(uint32_t* argb, int width, int height, int stride, int maxColors, bool dither)
+{
+    maxColors = std::min(std::max(maxColors, 2), 256);
+
+    try
+    {
+        if (HasFewColors(argb, width, height, stride, maxColors))
+        {
+            return true;
+        }
+
+        std::vector<uint32_t> histogram(HistogramSize, 0);
+
+        for (int y = 0; y < height; y++)
+        {
+            const uint32_t* row = argb + (static_cast<int64_t>(y) * stride);
+
+            for (int x = 0; x < width; x++)
+            {
+                histogram[GetHistogramIndex(row[x])]++;
+            }
+        }
+
+        std::vector<Bin> bins;
+
+        for (uint32_t i = 0; i < HistogramSize; i++)
+        {
+            if (histogram[i] != 0)
+            {
+                bins.push_back(Bin{ i, histogram[i] });
+            }
+        }
+
+        const std::vector<Box> boxes = MedianCut(bins, maxColors);
+
+        // Each palette entry is the mean of the pixels in its box, the histogram is reused to map the bins to the boxes.
+        for (size_t i = 0; i < boxes.size(); i++)
+        {
+            for (size_t j = boxes[i].begin; j < boxes[i].end; j++)
+            {
+                histogram[bins[j].index] = static_cast<uint32_t>(i);
+            }
+        }
+
+        std::vector<uint64_t> sums(boxes.size() * 4, 0);
+
+        for (int y = 0; y < height; y++)
+        {
+            const uint32_t* row = argb + (static_cast<int64_t>(y) * stride);
+
+            for (int x = 0; x < width; x++)
+            {
+                const uint32_t box = histogram[GetHistogramIndex(row[x])];
+
+                for (int channel = 0; channel < 4; channel++)
+                {
+                    sums[(box * 4) + channel] += GetChannel(row[x], channel);
+                }
+            }
+        }
+
+        Palette palette{};
+        palette.size = static_cast<int>(boxes.size());
+
+        for (size_t i = 0; i < boxes.size(); i++)
+        {
+            uint32_t color = 0;
+
+            for (int channel = 0; channel < 4; channel++)
+            {
+                uint32_t value = static_cast<uint32_t>((sums[(i * 4) + channel] + (boxes[i].count / 2)) / boxes[i].count);
+
+                // A box that has opaque pixels is only mixed with translucent pixels when there are two colors,
+                // it stays opaque.
+                if (channel == 0 && (boxes[i].maximumAlphaLevel == 0 || boxes[i].maximumAlphaLevel == OpaqueLevel))
+                {
+                    value = boxes[i].maximumAlphaLevel == 0 ? 0 : 255;
+                }
+
+                palette.channels[channel][i] = static_cast<int32_t>(value);
+                color |= value << (24 - (channel * 8));
+            }
+
+            palette.colors[i] = color;
+        }
+
+        NearestColorCache cache(palette);
+
+        if (dither)
+        {
+            MapWithDither(argb, width, height, stride, cache);
+        }
+        else
+        {
+            for (int y = 0; y < height; y++)
+            {
+                uint32_t* row = argb + (static_cast<int64_t>(y) * stride);
+
+                for (int x = 0; x < width; x++)
+                {
+                    row[x] = cache.Map(row[x]);
+                }
+            }
+        }
+    }
+    catch (const std::bad_alloc&)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+uint64_t Quantizer::EstimateWorkingSet(int width)
+{
+    // The histogram, the nearest color cache, the occupied bins and the dither error rows.
+    return (static_cast<uint64_t>(HistogramSize) * (sizeof(uint32_t) + sizeof(uint16_t) + sizeof(uint64_t))) +
+        ((static_cast<uint64_t>(width) + 2) * 4 * sizeof(int32_t) * 2);
+}
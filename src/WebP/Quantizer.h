@@ -0,0 +1,27 @@
+////////////////////////////////////////////////////////////////////////
+//
+// This file is part of pdn-webp, a FileType plugin for Paint.NET
+// that loads and saves WebP images.
+//
+// Copyright (c) 2011-2026 Nicholas Hayes
+//
+// This file is licensed under the MIT License.
+// See LICENSE.txt for complete licensing and attribution information.
+//
+////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Common.h"
+
+namespace Quantizer
+{
+    // Reduces the ARGB pixels to at most maxColors colors in place, using median cut over a
+    // 5-bit per channel histogram. Images that already have few enough colors are not changed.
+    // Fully transparent and fully opaque pixels keep their alpha values.
+    // Returns false if the work memory could not be allocated.
+    bool QuantizeARGB(uint32_t* argb, int width, int height, int stride, int maxColors, bool dither);
+
+    // Estimates the work memory that QuantizeARGB allocates.
+    uint64_t EstimateWorkingSet(int width);
+}
@@ -0,0 +1,202 @@
+////////////////////////////////////////////////////////////////////////
+//
+// This file is part of pdn-webp, a FileType plugin for Paint.NET
+// that loads and saves WebP images.
+//
+// Copyright (c) 2011-2026 Nicholas Hayes
+//
+// This file is licensed under the MIT License.
+// See LICENSE.txt for complete licensing and attribution information.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include "Resampler.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <new>
+#include <vector>
+
+namespace
+{
+    // The number of destination rows that each thread pool item produces.
+    constexpr int BandHeight = 16;
+
+    // The source pixels covered by each destination pixel along one axis, and their weights.
+    // The weights of a destination pixel add up to 1.
+    struct AreaWeights
+    {
+        std::vector<int> start;
+        std::vector<int> count;
+        std::vector<int> offset;
+        std::vector<float> weights;
+
+        AreaWeights(int sourceSize, int destinationSize)
+            : start(destinationSize), count(destinationSize), offset(destinationSize)
+        {
+            const double scale = static_cast<double>(sourceSize) / destinationSize;
+
+            weights.reserve(static_cast<size_t>(std::ceil(scale) + 1) * destinationSize);
+
+            for (int i = 0; i < destinationSize; i++)
+            {
+                const double begin = i * scale;
+                const double end = std::min((i + 1) * scale, static_cast<double>(sourceSize));
+                const int first = static_cast<int>(begin);
+                const int last = std::min(static_cast<int>(std::ceil(end)), sourceSize);
+
+                start[i] = first;
+                count[i] = last - first;
+                offset[i] = static_cast<int>(weights.size());
+
+                for (int j = first; j < last; j++)
+                {
+                    const double coverage = std::min<double>(j + 1, end) - std::max<double>(j, begin);
+
+                    weights.push_back(static_cast<float>(coverage / scale));
+                }
+            }
+        }
+    };
+
+    // Filters a source row horizontally into alpha-premultiplied B, G, R and A values.
+    void FilterRow(const uint8_t* source, const AreaWeights& weights, float* row)
+    {
+        const int width = static_cast<int>(weights.start.size());
+
+        for (int x = 0; x < width; x++)
+        {
+            const uint8_t* ptr = source + (static_cast<int64_t>(weights.start[x]) * 4);
+            const float* weight = weights.weights.data() + weights.offset[x];
+
+            float b = 0;
+            float g = 0;
+            float r = 0;
+            float a = 0;
+
+            for (int i = 0; i < weights.count[x]; i++)
+            {
+                const float alpha = weight[i] * ptr[3];
+
+                b += alpha * ptr[0];
+                g += alpha * ptr[1];
+                r += alpha * ptr[2];
+                a += alpha;
+
+                ptr += 4;
+            }
+
+            row[0] = b;
+            row[1] = g;
+            row[2] = r;
+            row[3] = a;
+            row += 4;
+        }
+    }
+
+    uint8_t ToByte(float value)
+    {
+        return static_cast<uint8_t>(std::min(std::max(value + 0.5f, 0.0f), 255.0f));
+    }
+
+    void WriteRow(const float* accumulator, int width, uint8_t* destination)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            const float alpha = accumulator[3];
+
+            if (alpha > 0)
+            {
+                const float inverseAlpha = 1.0f / alpha;
+
+                destination[0] = ToByte(accumulator[0] * inverseAlpha);
+                destination[1] = ToByte(accumulator[1] * inverseAlpha);
+                destination[2] = ToByte(accumulator[2] * inverseAlpha);
+                destination[3] = ToByte(alpha);
+            }
+            else
+            {
+                destination[0] = 0;
+                destination[1] = 0;
+                destination[2] = 0;
+                destination[3] = 0;
+            }
+
+            accumulator += 4;
+            destination += 4;
+        }
+    }
+}
+
+bool Resampler::DownscaleArea(
+    const uint8_t* source,
+    int sourceWidth,
+    int sourceHeight,
+    int sourceStride,
+    uint8_t* destination,
+    int destinationWidth,
+    int destinationHeight,
+    int destinationStride)
+{
+    if (destinationWidth > sourceWidth || destinationHeight > sourceHeight)
+    {
+        return false;
+    }
+
+    try
+    {
+        const AreaWeights horizontal(sourceWidth, destinationWidth);
+        const AreaWeights vertical(sourceHeight, destinationHeight);
+
+        const size_t bandCount = (static_cast<size_t>(destinationHeight) + BandHeight - 1) / BandHeight;
+        const size_t rowLength = static_cast<size_t>(destinationWidth) * 4;
+
+        std::atomic<bool> outOfMemory(false);
+
+        ThreadPool::GetDefault().ParallelFor(bandCount, [&](size_t band)
+        {
+            try
+            {
+                std::vector<float> filteredRow(rowLength);
+                std::vector<float> accumulator(rowLength);
+
+                const int firstRow = static_cast<int>(band) * BandHeight;
+                const int lastRow = std::min(firstRow + BandHeight, destinationHeight);
+
+                for (int y = firstRow; y < lastRow; y++)
+                {
+                    std::fill(accumulator.begin(), accumulator.end(), 0.0f);
+
+                    const float* weight = vertical.weights.data() + vertical.offset[y];
+
+                    for (int i = 0; i < vertical.count[y]; i++)
+                    {
+                        const int sourceRow = vertical.start[y] + i;
+
+                        FilterRow(source + (static_cast<int64_t>(sourceRow) * sourceStride), horizontal, filteredRow.data());
+
+                        const float rowWeight = weight[i];
+
+                        for (size_t j = 0; j < rowLength; j++)
+                        {
+                            accumulator[j] += rowWeight * filteredRow[j];
+                        }
+                    }
+
+                    WriteRow(accumulator.data(), destinationWidth, destination + (static_cast<int64_t>(y) * destinationStride));
+                }
+            }
+            catch (const std::bad_alloc&)
+            {
+                outOfMemory = true;
+            }
+        });
+
+        return !outOfMemory;
+    }
+    catch (const std::bad_alloc&)
+    {
+        return false;
+    }
+}
@@ -0,0 +1,33 @@
+////////////////////////////////////////////////////////////////////////
+//
+// This file is part of pdn-webp, a FileType plugin for Paint.NET
+// that loads and saves WebP images.
+//
+// Copyright (c) 2011-2026 Nicholas Hayes
+//
+// This file is licensed under the MIT License.
+// See LICENSE.txt for complete licensing and attribution information.
+//
+////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Common.h"
+
+namespace Resampler
+{
+    // Downscales a BGRA image with an area (box) filter that weights the colors by their alpha,
+    // so that the color of fully transparent pixels does not bleed into the visible pixels.
+    // The destination must not be larger than the source in either dimension.
+    // The rows are processed in bands on the process-wide thread pool.
+    // Returns false if the work memory could not be allocated.
+    bool DownscaleArea(
+        const uint8_t* source,
+        int sourceWidth,
+        int sourceHeight,
+        int sourceStride,
+        uint8_t* destination,
+        int destinationWidth,
+        int destinationHeight,
+        int destinationStride);
+}
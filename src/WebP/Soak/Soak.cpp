@@ -0,0 +1,864 @@
+////////////////////////////////////////////////////////////////////////
+//
+// This file is part of pdn-webp, a FileType plugin for Paint.NET
+// that loads and saves WebP images.
+//
+// Copyright (c) 2011-2026 Nicholas Hayes
+//
+// This file is licensed under the MIT License.
+// See LICENSE.txt for complete licensing and attribution information.
+//
+////////////////////////////////////////////////////////////////////////
+
+// A long-running soak test for the exported WebP API, run with --help for the options.
+// Each iteration runs the successful encode and decode paths, including the metadata mux and demux,
+// and the error paths. The resident set size and the allocator statistics are sampled periodically,
+// and the test fails when either one grows past its threshold after the warm-up iterations.
+
+#include "Corpus.h"
+#include "WebP.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <Windows.h>
+#include <Psapi.h>
+#elif defined(__linux__)
+#include <malloc.h>
+#include <unistd.h>
+#include <fstream>
+#endif
+
+namespace
+{
+    struct Options
+    {
+        uint64_t iterations;
+        uint64_t durationSeconds;
+        uint64_t warmup;
+        uint64_t sampleInterval;
+        int width;
+        int height;
+        double maxResidentGrowthMB;
+        double maxHeapGrowthMB;
+    };
+
+    struct MemorySample
+    {
+        uint64_t iteration;
+        uint64_t residentBytes;
+        int64_t heapBytes; // -1 when the allocator statistics are not available.
+    };
+
+    class SoakFailure
+    {
+    public:
+        explicit SoakFailure(const std::string& message) : message(message)
+        {
+        }
+
+        std::string message;
+    };
+
+    void PrintUsage()
+    {
+        std::cerr <<
+            "Usage: WebPSoak [options]\n"
+            "  --iterations <n>          The number of iterations, 0 for no limit (default: 1000000).\n"
+            "  --duration <seconds>      Stop after the specified time, 0 for no limit (default: 0).\n"
+            "  --size <WIDTHxHEIGHT>     The test image size (default: 128x96).\n"
+            "  --warmup <n>              The iterations before the baseline memory sample (default: 10000).\n"
+            "  --sample-interval <n>     The iterations between memory samples (default: 10000).\n"
+            "  --max-rss-growth <MB>     The allowed resident set size growth (default: 32).\n"
+            "  --max-heap-growth <MB>    The allowed allocator in-use growth (default: 4).\n";
+    }
+
+    bool TryParseUInt(const std::string& value, uint64_t& result)
+    {
+        char* end = nullptr;
+        const unsigned long long parsed = std::strtoull(value.c_str(), &end, 10);
+
+        if (value.empty() || value[0] == '-' || *end != '\0')
+        {
+            return false;
+        }
+
+        result = parsed;
+        return true;
+    }
+
+    bool TryParseOptions(int argc, char** argv, Options& options)
+    {
+        options.iterations = 1000000;
+        options.durationSeconds = 0;
+        options.warmup = 10000;
+        options.sampleInterval = 10000;
+        options.width = 128;
+        options.height = 96;
+        options.maxResidentGrowthMB = 32;
+        options.maxHeapGrowthMB = 4;
+
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string name = argv[i];
+
+            if (name == "--help" || name == "-h")
+            {
+                return false;
+            }
+
+            if (i + 1 >= argc)
+            {
+                std::cerr << "Missing value for " << name << ".\n";
+                return false;
+            }
+
+            const std::string value = argv[++i];
+            uint64_t number = 0;
+            bool valid = true;
+
+            if (name == "--size")
+            {
+                const size_t separator = value.find('x');
+                uint64_t width = 0;
+                uint64_t height = 0;
+
+                valid = separator != std::string::npos &&
+                        TryParseUInt(value.substr(0, separator), width) &&
+                        TryParseUInt(value.substr(separator + 1), height) &&
+                        width >= 1 && width <= 16383 && height >= 1 && height <= 16383;
+
+                options.width = static_cast<int>(width);
+                options.height = static_cast<int>(height);
+            }
+            else if (!TryParseUInt(value, number))
+            {
+                valid = false;
+            }
+            else if (name == "--iterations")
+            {
+                options.iterations = number;
+            }
+            else if (name == "--duration")
+            {
+                options.durationSeconds = number;
+            }
+            else if (name == "--warmup")
+            {
+                options.warmup = number;
+            }
+            else if (name == "--sample-interval")
+            {
+                options.sampleInterval = number;
+                valid = number > 0;
+            }
+            else if (name == "--max-rss-growth")
+            {
+                options.maxResidentGrowthMB = static_cast<double>(number);
+            }
+            else if (name == "--max-heap-growth")
+            {
+                options.maxHeapGrowthMB = static_cast<double>(number);
+            }
+            else
+            {
+                std::cerr << "Unknown option " << name << ".\n";
+                return false;
+            }
+
+            if (!valid)
+            {
+                std::cerr << "Invalid value for " << name << ": " << value << "\n";
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    uint64_t GetResidentSetSize()
+    {
+#if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters{};
+
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        {
+            return counters.WorkingSetSize;
+        }
+
+        return 0;
+#elif defined(__linux__)
+        // The second field is the number of resident pages.
+        std::ifstream statm("/proc/self/statm");
+        uint64_t totalPages = 0;
+        uint64_t residentPages = 0;
+
+        if (!(statm >> totalPages >> residentPages))
+        {
+            return 0;
+        }
+
+        return residentPages * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#else
+        return 0;
+#endif
+    }
+
+    int64_t GetHeapInUse()
+    {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+        const struct mallinfo2 info = mallinfo2();
+
+        // The small allocations and the blocks that were allocated with mmap.
+        return static_cast<int64_t>(info.uordblks + info.hblkhd);
+#else
+        return -1;
+#endif
+    }
+
+    MemorySample TakeSample(uint64_t iteration)
+    {
+        MemorySample sample{};
+        sample.iteration = iteration;
+        sample.residentBytes = GetResidentSetSize();
+        sample.heapBytes = GetHeapInUse();
+
+        return sample;
+    }
+
+    double ToMB(double bytes)
+    {
+        return bytes / (1024.0 * 1024.0);
+    }
+
+    // The planar decode output, the alpha plane is only allocated when it is requested.
+    struct PlaneBuffers
+    {
+        std::vector<uint8_t> y;
+        std::vector<uint8_t> u;
+        std::vector<uint8_t> v;
+        std::vector<uint8_t> a;
+        bool allocateAlpha;
+        int width;
+        int height;
+    };
+
+    // The state that is shared by the test cases, the buffers are reused between iterations.
+    struct SoakState
+    {
+        CorpusImage image;
+        CorpusImage alphaImage;
+        CorpusImage spriteImage;
+        std::vector<uint8_t> iccProfile;
+        std::vector<uint8_t> exif;
+        std::vector<uint8_t> xmp;
+        EncoderMetadata metadata;
+        std::vector<uint8_t> encoded;
+        std::vector<uint8_t> corrupted;
+        std::vector<uint8_t> garbage;
+        std::vector<uint8_t> pixels;
+        PlaneBuffers planes;
+        std::vector<uint8_t> planesEncoded;
+        std::vector<std::vector<uint8_t>> pyramid;
+    };
+
+    // The decode callback context, the metadata sizes are checked against the encoder input.
+    struct DecodeContext
+    {
+        SoakState* state;
+        bool failCreateImage;
+        bool failMetadata;
+        int metadataCount;
+        bool metadataMismatch;
+    };
+
+    WebPStatus __stdcall WriteToVector(void* context, const uint8_t* image, const size_t imageSize)
+    {
+        std::vector<uint8_t>* output = static_cast<std::vector<uint8_t>*>(context);
+        output->insert(output->end(), image, image + imageSize);
+
+        return WebPStatus::Ok;
+    }
+
+    WebPStatus __stdcall FailWrite(void*, const uint8_t*, const size_t)
+    {
+        return WebPStatus::BadWrite;
+    }
+
+    bool __stdcall AbortProgress(void*, int)
+    {
+        return false;
+    }
+
+    void* __stdcall CreateImage(void* context, int width, int height, size_t& outImageDataSize, int& outStride)
+    {
+        DecodeContext* decode = static_cast<DecodeContext*>(context);
+
+        if (decode->failCreateImage)
+        {
+            return nullptr;
+        }
+
+        outStride = width * 4;
+        outImageDataSize = static_cast<size_t>(outStride) * height;
+        decode->state->pixels.resize(outImageDataSize);
+
+        return decode->state->pixels.data();
+    }
+
+    bool __stdcall SetMetadata(void* context, const uint8_t*, size_t size, MetadataType type)
+    {
+        DecodeContext* decode = static_cast<DecodeContext*>(context);
+
+        if (decode->failMetadata)
+        {
+            return false;
+        }
+
+        size_t expectedSize = 0;
+
+        switch (type)
+        {
+        case MetadataType::ColorProfile:
+            expectedSize = decode->state->iccProfile.size();
+            break;
+        case MetadataType::EXIF:
+            expectedSize = decode->state->exif.size();
+            break;
+        case MetadataType::XMP:
+            expectedSize = decode->state->xmp.size();
+            break;
+        }
+
+        decode->metadataCount++;
+        decode->metadataMismatch |= size != expectedSize;
+
+        return true;
+    }
+
+    bool __stdcall CreatePlanes(void* context, int width, int height, bool hasAlpha, DecoderPlanes& outPlanes)
+    {
+        PlaneBuffers* planes = static_cast<PlaneBuffers*>(context);
+
+        const int uvWidth = (width + 1) / 2;
+        const int uvHeight = (height + 1) / 2;
+
+        planes->width = width;
+        planes->height = height;
+        planes->y.resize(static_cast<size_t>(width) * height);
+        planes->u.resize(static_cast<size_t>(uvWidth) * uvHeight);
+        planes->v.resize(static_cast<size_t>(uvWidth) * uvHeight);
+
+        outPlanes.y = planes->y.data();
+        outPlanes.u = planes->u.data();
+        outPlanes.v = planes->v.data();
+        outPlanes.yStride = width;
+        outPlanes.uStride = uvWidth;
+        outPlanes.vStride = uvWidth;
+        outPlanes.ySize = planes->y.size();
+        outPlanes.uSize = planes->u.size();
+        outPlanes.vSize = planes->v.size();
+
+        if (planes->allocateAlpha && hasAlpha)
+        {
+            planes->a.resize(static_cast<size_t>(width) * height);
+
+            outPlanes.a = planes->a.data();
+            outPlanes.aStride = width;
+            outPlanes.aSize = planes->a.size();
+        }
+        else
+        {
+            planes->a.clear();
+        }
+
+        return true;
+    }
+
+    bool __stdcall IgnoreMetadata(void*, const uint8_t*, size_t, MetadataType)
+    {
+        return true;
+    }
+
+    void Expect(const char* testCase, WebPStatus status, WebPStatus expected)
+    {
+        if (status != expected)
+        {
+            std::ostringstream message;
+            message << testCase << " returned status " << static_cast<int>(status)
+                    << ", expected " << static_cast<int>(expected) << ".";
+            throw SoakFailure(message.str());
+        }
+    }
+
+    void ExpectFailure(const char* testCase, WebPStatus status)
+    {
+        if (status == WebPStatus::Ok)
+        {
+            throw SoakFailure(std::string(testCase) + " succeeded, expected an error.");
+        }
+    }
+
+    EncoderOptions GetEncoderOptions(uint64_t iteration)
+    {
+        // Cycle through every effort level in both modes, with and without the transparent area cleanup.
+        EncoderOptions options{};
+        options.quality = 75.0f;
+        options.effort = static_cast<int>(iteration % 10);
+        options.preset = 0;
+        options.lossless = ((iteration / 10) % 2) != 0;
+        options.cleanupTransparentArea = ((iteration / 20) % 2) != 0;
+        options.alphaQualityReduction = 0;
+        options.alphaFiltering = 0;
+        options.uncompressedAlpha = false;
+        options.nearLosslessStrength = 0;
+        options.paletteColors = 0;
+        options.paletteDither = false;
+
+        return options;
+    }
+
+    WebPStatus Encode(
+        SoakState& state,
+        const EncoderOptions& options,
+        const EncoderMetadata* metadata,
+        WriteImageFn writeImage,
+        ProgressFn progress,
+        MemoryBudget* memoryBudget)
+    {
+        state.encoded.clear();
+
+        return WebPSave(
+            writeImage,
+            state.image.pixels.data(),
+            state.image.width,
+            state.image.height,
+            state.image.stride,
+            EncoderPixelFormat::Bgra,
+            nullptr,
+            &options,
+            metadata,
+            progress,
+            &state.encoded,
+            nullptr,
+            memoryBudget);
+    }
+
+    WebPStatus Decode(SoakState& state, const std::vector<uint8_t>& data, size_t dataSize, DecodeContext& context, MemoryBudget* memoryBudget)
+    {
+        context.state = &state;
+        context.metadataCount = 0;
+        context.metadataMismatch = false;
+
+        return WebPLoad(data.data(), dataSize, DecoderPixelFormat::Bgra, CreateImage, SetMetadata, &context, memoryBudget);
+    }
+
+    WebPStatus EncodePlanes(SoakState& state, const EncoderOptions& options)
+    {
+        YUVImage yuvImage{};
+        yuvImage.y = state.planes.y.data();
+        yuvImage.u = state.planes.u.data();
+        yuvImage.v = state.planes.v.data();
+        yuvImage.a = state.planes.a.empty() ? nullptr : state.planes.a.data();
+        yuvImage.yStride = state.planes.width;
+        yuvImage.uvStride = (state.planes.width + 1) / 2;
+        yuvImage.aStride = state.planes.width;
+
+        state.planesEncoded.clear();
+
+        return WebPSaveYUV(
+            WriteToVector,
+            &yuvImage,
+            state.planes.width,
+            state.planes.height,
+            &options,
+            nullptr,
+            nullptr,
+            &state.planesEncoded,
+            nullptr,
+            nullptr);
+    }
+
+    // Decodes the transparent image into planes and encodes the planes again.
+    void RunPlanar(SoakState& state, const EncoderOptions& options)
+    {
+        EncoderOptions lossy = options;
+        lossy.lossless = false;
+
+        std::vector<uint8_t> encoded;
+
+        Expect("Encode the transparent image",
+               WebPSave(
+                   WriteToVector,
+                   state.alphaImage.pixels.data(),
+                   state.alphaImage.width,
+                   state.alphaImage.height,
+                   state.alphaImage.stride,
+                   EncoderPixelFormat::Bgra,
+                   nullptr,
+                   &lossy,
+                   nullptr,
+                   nullptr,
+                   &encoded,
+                   nullptr,
+                   nullptr),
+               WebPStatus::Ok);
+
+        for (bool alphaPlane : { true, false })
+        {
+            state.planes.allocateAlpha = alphaPlane;
+
+            Expect(alphaPlane ? "Decode planes with an alpha plane" : "Decode transparent planes without an alpha plane",
+                   WebPLoadPlanes(encoded.data(), encoded.size(), CreatePlanes, IgnoreMetadata, &state.planes, nullptr),
+                   WebPStatus::Ok);
+
+            if (state.planes.a.empty() == alphaPlane)
+            {
+                throw SoakFailure("Decode planes did not return the requested alpha plane.");
+            }
+
+            Expect("Encode planes", EncodePlanes(state, lossy), WebPStatus::Ok);
+
+            int width = 0;
+            int height = 0;
+
+            Expect("Get the encoded planes size",
+                   WebPGetImageSize(state.planesEncoded.data(), state.planesEncoded.size(), &width, &height),
+                   WebPStatus::Ok);
+
+            if (width != state.alphaImage.width || height != state.alphaImage.height)
+            {
+                throw SoakFailure("Encode planes returned the wrong image size.");
+            }
+        }
+    }
+
+    // Encodes the transparent sprites with a reduced palette, with and without dithering, and checks
+    // that the fully transparent and fully opaque pixels keep their alpha values.
+    void RunPalette(SoakState& state, uint64_t iteration)
+    {
+        EncoderOptions options{};
+        options.quality = 75.0f;
+        options.effort = static_cast<int>(iteration % 10);
+        options.lossless = true;
+        options.paletteColors = 16;
+        options.paletteDither = (iteration & 1) != 0;
+
+        std::vector<uint8_t> encoded;
+
+        Expect("Encode the sprites with a palette",
+               WebPSave(
+                   WriteToVector,
+                   state.spriteImage.pixels.data(),
+                   state.spriteImage.width,
+                   state.spriteImage.height,
+                   state.spriteImage.stride,
+                   EncoderPixelFormat::Bgra,
+                   nullptr,
+                   &options,
+                   nullptr,
+                   nullptr,
+                   &encoded,
+                   nullptr,
+                   nullptr),
+               WebPStatus::Ok);
+
+        DecodeContext context{};
+
+        Expect("Decode the sprites with a palette", Decode(state, encoded, encoded.size(), context, nullptr), WebPStatus::Ok);
+
+        const CorpusImage& image = state.spriteImage;
+
+        for (int y = 0; y < image.height; y++)
+        {
+            const uint8_t* source = image.pixels.data() + (static_cast<size_t>(y) * image.stride);
+            const uint8_t* decoded = state.pixels.data() + (static_cast<size_t>(y) * image.width * 4);
+
+            for (int x = 0; x < image.width; x++)
+            {
+                const uint8_t alpha = source[(x * 4) + 3];
+
+                if ((alpha == 0 || alpha == 255) && decoded[(x * 4) + 3] != alpha)
+                {
+                    throw SoakFailure("Encode the sprites with a palette changed a fully transparent or fully opaque pixel.");
+                }
+            }
+        }
+    }
+
+    // Encodes the image at full, half and quarter size, then again with a budget that
+    // cannot hold the downscaled levels.
+    void RunPyramid(SoakState& state, const EncoderOptions& options)
+    {
+        PyramidLevel levels[3]{};
+        WebPStatus levelStatus[3]{};
+
+        state.pyramid.resize(3);
+
+        for (int i = 0; i < 3; i++)
+        {
+            levels[i].width = std::max(1, state.image.width >> i);
+            levels[i].height = std::max(1, state.image.height >> i);
+            levels[i].options = options;
+            levels[i].writeImageCallback = WriteToVector;
+            levels[i].callbackContext = &state.pyramid[i];
+
+            state.pyramid[i].clear();
+        }
+
+        Expect("Encode a pyramid",
+               WebPSavePyramid(
+                   state.image.pixels.data(),
+                   state.image.width,
+                   state.image.height,
+                   state.image.stride,
+                   levels,
+                   3,
+                   &state.metadata,
+                   0,
+                   levelStatus),
+               WebPStatus::Ok);
+
+        for (int i = 0; i < 3; i++)
+        {
+            Expect("Encode a pyramid level", levelStatus[i], WebPStatus::Ok);
+
+            int width = 0;
+            int height = 0;
+
+            Expect("Get the pyramid level size",
+                   WebPGetImageSize(state.pyramid[i].data(), state.pyramid[i].size(), &width, &height),
+                   WebPStatus::Ok);
+
+            if (width != levels[i].width || height != levels[i].height)
+            {
+                throw SoakFailure("Encode a pyramid returned the wrong level size.");
+            }
+        }
+
+        Expect("Encode a pyramid over the memory budget",
+               WebPSavePyramid(
+                   state.image.pixels.data(),
+                   state.image.width,
+                   state.image.height,
+                   state.image.stride,
+                   levels,
+                   3,
+                   nullptr,
+                   1024,
+                   levelStatus),
+               WebPStatus::OutOfMemory);
+    }
+
+    void RunIteration(SoakState& state, uint64_t iteration)
+    {
+        const EncoderOptions options = GetEncoderOptions(iteration);
+
+        // The error paths, these are run first because they replace the encoded image.
+        {
+            Expect("Encode with a failing write callback",
+                   Encode(state, options, (iteration & 1) ? &state.metadata : nullptr, FailWrite, nullptr, nullptr),
+                   WebPStatus::BadWrite);
+
+            EncoderOptions lossy = options;
+            lossy.lossless = false;
+
+            Expect("Encode with a user abort",
+                   Encode(state, lossy, &state.metadata, WriteToVector, AbortProgress, nullptr),
+                   WebPStatus::UserAbort);
+
+            MemoryBudget budget{};
+            budget.limit = 1024;
+
+            Expect("Encode over the memory budget",
+                   Encode(state, options, &state.metadata, WriteToVector, nullptr, &budget),
+                   WebPStatus::OutOfMemory);
+        }
+
+        // The metadata is muxed into the image and read back by the demuxer.
+        Expect("Encode with metadata",
+               Encode(state, options, &state.metadata, WriteToVector, nullptr, nullptr),
+               WebPStatus::Ok);
+
+        DecodeContext context{};
+
+        Expect("Decode with metadata", Decode(state, state.encoded, state.encoded.size(), context, nullptr), WebPStatus::Ok);
+
+        if (context.metadataCount != 3 || context.metadataMismatch)
+        {
+            throw SoakFailure("Decode with metadata did not return the encoded metadata.");
+        }
+
+        // A caller that leaves the alpha plane null discards the alpha channel.
+        state.planes.allocateAlpha = false;
+
+        Expect("Decode planes without an alpha plane",
+               WebPLoadPlanes(state.encoded.data(), state.encoded.size(), CreatePlanes, IgnoreMetadata, &state.planes, nullptr),
+               WebPStatus::Ok);
+
+        if (state.planes.width != state.image.width || state.planes.height != state.image.height)
+        {
+            throw SoakFailure("Decode planes without an alpha plane returned the wrong image size.");
+        }
+
+        ExpectFailure("Decode truncated data", Decode(state, state.encoded, state.encoded.size() / 2, context, nullptr));
+        ExpectFailure("Decode invalid data", Decode(state, state.garbage, state.garbage.size(), context, nullptr));
+
+        // The corrupted image may or may not decode, it is only required to not leak or crash.
+        state.corrupted = state.encoded;
+        for (size_t i = state.corrupted.size() / 2; i < state.corrupted.size(); i += 7)
+        {
+            state.corrupted[i] ^= static_cast<uint8_t>(iteration | 1);
+        }
+        Decode(state, state.corrupted, state.corrupted.size(), context, nullptr);
+
+        context.failCreateImage = true;
+        Expect("Decode with a failing create image callback",
+               Decode(state, state.encoded, state.encoded.size(), context, nullptr),
+               WebPStatus::CreateImageCallbackFailed);
+        context.failCreateImage = false;
+
+        context.failMetadata = true;
+        Expect("Decode with a failing metadata callback",
+               Decode(state, state.encoded, state.encoded.size(), context, nullptr),
+               WebPStatus::SetMetadataCallbackFailed);
+        context.failMetadata = false;
+
+        MemoryBudget budget{};
+        budget.limit = 1024;
+
+        Expect("Decode over the memory budget",
+               Decode(state, state.encoded, state.encoded.size(), context, &budget),
+               WebPStatus::OutOfMemory);
+
+        RunPlanar(state, options);
+        RunPalette(state, iteration);
+        RunPyramid(state, options);
+    }
+
+    void InitializeState(SoakState& state, const Options& options)
+    {
+        state.image = Corpus::Generate(CorpusKind::Photo, options.width, options.height);
+        state.alphaImage = Corpus::Generate(CorpusKind::AlphaGradient, options.width, options.height);
+        state.spriteImage = Corpus::Generate(CorpusKind::Sprite, options.width, options.height);
+
+        // The metadata contents are not validated by the encoder, only the sizes are checked on decode.
+        state.iccProfile.assign(560, 0x11);
+        state.exif.assign(1024, 0x22);
+        state.exif[0] = 'I';
+        state.exif[1] = 'I';
+
+        const std::string xmp =
+            "<?xpacket begin=\"\" id=\"W5M0MpCehiHzreSzNTczkc9d\"?>"
+            "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\"></x:xmpmeta>"
+            "<?xpacket end=\"w\"?>";
+        state.xmp.assign(xmp.begin(), xmp.end());
+
+        state.metadata.iccProfile = state.iccProfile.data();
+        state.metadata.iccProfileSize = state.iccProfile.size();
+        state.metadata.exif = state.exif.data();
+        state.metadata.exifSize = state.exif.size();
+        state.metadata.xmp = state.xmp.data();
+        state.metadata.xmpSize = state.xmp.size();
+
+        state.garbage.resize(4096);
+        for (size_t i = 0; i < state.garbage.size(); i++)
+        {
+            state.garbage[i] = static_cast<uint8_t>((i * 2654435761u) >> 24);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+
+    if (!TryParseOptions(argc, argv, options))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    SoakState state;
+    InitializeState(state, options);
+
+    const auto start = std::chrono::steady_clock::now();
+    const double maxResidentGrowth = options.maxResidentGrowthMB * 1024 * 1024;
+    const double maxHeapGrowth = options.maxHeapGrowthMB * 1024 * 1024;
+
+    MemorySample baseline{};
+    bool haveBaseline = false;
+    uint64_t iteration = 0;
+
+    try
+    {
+        while (options.iterations == 0 || iteration < options.iterations)
+        {
+            RunIteration(state, iteration);
+            iteration++;
+
+            if (!haveBaseline && iteration >= options.warmup)
+            {
+                baseline = TakeSample(iteration);
+                haveBaseline = true;
+            }
+
+            if (iteration % options.sampleInterval == 0)
+            {
+                const MemorySample sample = TakeSample(iteration);
+                const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+                std::cout << "iteration " << iteration
+                          << ": rss " << ToMB(static_cast<double>(sample.residentBytes)) << " MB";
+
+                if (sample.heapBytes >= 0)
+                {
+                    std::cout << ", heap " << ToMB(static_cast<double>(sample.heapBytes)) << " MB";
+                }
+
+                std::cout << ", " << (static_cast<double>(iteration) / elapsed) << " iterations/s" << std::endl;
+
+                if (haveBaseline)
+                {
+                    const double residentGrowth = static_cast<double>(sample.residentBytes) - static_cast<double>(baseline.residentBytes);
+                    const double heapGrowth = static_cast<double>(sample.heapBytes - baseline.heapBytes);
+
+                    if (residentGrowth > maxResidentGrowth)
+                    {
+                        std::cout << "FAIL: the resident set size grew by " << ToMB(residentGrowth)
+                                  << " MB since iteration " << baseline.iteration << "." << std::endl;
+                        return 3;
+                    }
+
+                    if (sample.heapBytes >= 0 && heapGrowth > maxHeapGrowth)
+                    {
+                        std::cout << "FAIL: the allocator in-use bytes grew by " << ToMB(heapGrowth)
+                                  << " MB since iteration " << baseline.iteration << "." << std::endl;
+                        return 3;
+                    }
+                }
+
+                if (options.durationSeconds != 0 && elapsed >= static_cast<double>(options.durationSeconds))
+                {
+                    break;
+                }
+            }
+        }
+    }
+    catch (const SoakFailure& failure)
+    {
+        std::cout << "FAIL at iteration " << iteration << ": " << failure.message << std::endl;
+        return 2;
+    }
+
+    std::cout << "PASS: " << iteration << " iterations." << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,197 @@
+////////////////////////////////////////////////////////////////////////
+//
+// This file is part of pdn-webp, a FileType plugin for Paint.NET
+// that loads and saves WebP images.
+//
+// Copyright (c) 2011-2026 Nicholas Hayes
+//
+// This file is licensed under the MIT License.
+// See LICENSE.txt for complete licensing and attribution information.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace
+{
+    struct ParallelForState
+    {
+        ParallelForState(size_t count, const std::function<void(size_t)>& body)
+            : nextIndex(0), count(count), body(body), activeHelpers(0)
+        {
+        }
+
+        void Run()
+        {
+            size_t index;
+
+            while ((index = nextIndex.fetch_add(1, std::memory_order_relaxed)) < count)
+            {
+                body(index);
+            }
+        }
+
+        std::atomic<size_t> nextIndex;
+        const size_t count;
+        const std::function<void(size_t)>& body;
+        size_t activeHelpers;
+        std::mutex mutex;
+        std::condition_variable helpersFinished;
+    };
+}
+
+ThreadPool::ThreadPool(unsigned int threadCount) : shuttingDown(false)
+{
+    if (threadCount == 0)
+    {
+        threadCount = 1;
+    }
+
+    workers.reserve(threadCount);
+
+    try
+    {
+        for (unsigned int i = 0; i < threadCount; i++)
+        {
+            workers.emplace_back(&ThreadPool::WorkerLoop, this);
+        }
+    }
+    catch (...)
+    {
+        // The destructor does not run when the constructor throws, and destroying
+        // a joinable std::thread would terminate the process.
+        Shutdown();
+        throw;
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    Shutdown();
+}
+
+void ThreadPool::Shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        shuttingDown = true;
+    }
+
+    taskAvailable.notify_all();
+
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::GetDefault()
+{
+    // The pool is intentionally never destroyed, joining the worker threads while the
+    // DLL is being unloaded would deadlock on the loader lock.
+    static ThreadPool* pool = new ThreadPool(std::thread::hardware_concurrency());
+
+    return *pool;
+}
+
+bool ThreadPool::Submit(std::function<void()> task)
+{
+    try
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (shuttingDown)
+        {
+            return false;
+        }
+
+        tasks.push_back(std::move(task));
+    }
+    catch (const std::bad_alloc&)
+    {
+        return false;
+    }
+
+    taskAvailable.notify_one();
+
+    return true;
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& body)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    std::shared_ptr<ParallelForState> state = std::make_shared<ParallelForState>(count, body);
+
+    // The calling thread also runs items, so it needs one helper less than the item count.
+    const size_t helperCount = std::min<size_t>(workers.size(), count - 1);
+
+    for (size_t i = 0; i < helperCount; i++)
+    {
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->activeHelpers++;
+        }
+
+        bool submitted = false;
+
+        // Constructing the task can throw, which must not leave the earlier helpers running the caller's body.
+        try
+        {
+            submitted = Submit([state]()
+            {
+                state->Run();
+
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->activeHelpers--;
+                state->helpersFinished.notify_one();
+            });
+        }
+        catch (const std::bad_alloc&)
+        {
+            submitted = false;
+        }
+
+        if (!submitted)
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->activeHelpers--;
+            break;
+        }
+    }
+
+    state->Run();
+
+    // The body is owned by the caller, so wait for every helper to exit before returning.
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->helpersFinished.wait(lock, [&state]() { return state->activeHelpers == 0; });
+}
+
+void ThreadPool::WorkerLoop()
+{
+    while (true)
+    {
+        std::function<void()> task;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            taskAvailable.wait(lock, [this]() { return shuttingDown || !tasks.empty(); });
+
+            if (shuttingDown && tasks.empty())
+            {
+                return;
+            }
+
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+
+        task();
+    }
+}
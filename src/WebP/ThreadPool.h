@@ -0,0 +1,65 @@
+////////////////////////////////////////////////////////////////////////
+//
+// This file is part of pdn-webp, a FileType plugin for Paint.NET
+// that loads and saves WebP images.
+//
+// Copyright (c) 2011-2026 Nicholas Hayes
+//
+// This file is licensed under the MIT License.
+// See LICENSE.txt for complete licensing and attribution information.
+//
+////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed-size pool of worker threads.
+class ThreadPool
+{
+public:
+    // Throws std::system_error if a worker thread cannot be created.
+    ThreadPool(unsigned int threadCount);
+
+    ~ThreadPool();
+
+    // Disable copying and assignment.
+    ThreadPool(const ThreadPool&) = delete;
+    const ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Gets the process-wide pool, which has one worker per logical processor.
+    // The pool is created on first use, which throws std::system_error if it fails.
+    static ThreadPool& GetDefault();
+
+    unsigned int GetThreadCount() const
+    {
+        return static_cast<unsigned int>(workers.size());
+    }
+
+    // Queues a task to run on one of the worker threads.
+    // Returns false if the task could not be queued.
+    bool Submit(std::function<void()> task);
+
+    // Invokes the body for every index in [0, count) and waits for all of them to complete.
+    // The workers and the calling thread take the next index from a shared counter, so
+    // threads that finish their items early pick up the remaining work.
+    // Throws std::bad_alloc if the shared state cannot be allocated, before any item has run.
+    void ParallelFor(size_t count, const std::function<void(size_t)>& body);
+
+private:
+    // Stops the worker threads once the queued tasks have run.
+    void Shutdown();
+
+    void WorkerLoop();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable taskAvailable;
+    bool shuttingDown;
+};
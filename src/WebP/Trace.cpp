@@ -0,0 +1,158 @@
+////////////////////////////////////////////////////////////////////////
+//
+// This file is part of pdn-webp, a FileType plugin for Paint.NET
+// that loads and saves WebP images.
+//
+// Copyright (c) 2011-2026 Nicholas Hayes
+//
+// This file is licensed under the MIT License.
+// See LICENSE.txt for complete licensing and attribution information.
+//
+////////////////////////////////////////////////////////////////////////
+
+#include "Trace.h"
+#include <chrono>
+#include <mutex>
+
+namespace
+{
+    // Must be a power of two.
+    constexpr size_t RingBufferSize = 8192;
+
+    // A ring buffer slot, the sequence is 2 * (index + 1) when the event at that index has been
+    // written and one less while it is being written. The sequence only moves forward, so a writer
+    // that has been lapped cannot hide a newer event.
+    // The fields are relaxed atomics so that a reader can copy a slot that is being overwritten,
+    // the sequence tells it to discard the copy.
+    struct Slot
+    {
+        std::atomic<uint64_t> sequence;
+        std::atomic<uint64_t> timestamp;
+        std::atomic<uint32_t> operationId;
+        std::atomic<int32_t> phase;
+        std::atomic<int32_t> type;
+    };
+
+    Slot ringBuffer[RingBufferSize];
+    std::atomic<uint64_t> writeIndex(0);
+    uint64_t readIndex = 0;
+    std::mutex readMutex;
+
+    std::atomic<uint32_t> nextOperationId(1);
+    thread_local uint32_t currentOperationId = 0;
+
+    uint64_t GetTimestamp()
+    {
+        const auto now = std::chrono::steady_clock::now().time_since_epoch();
+
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+    }
+}
+
+std::atomic<bool> Trace::enabled(false);
+
+void Trace::SetEnabled(bool value)
+{
+    enabled.store(value, std::memory_order_relaxed);
+}
+
+size_t Trace::ReadEvents(TraceEvent* events, size_t capacity)
+{
+    if (events == nullptr || capacity == 0)
+    {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(readMutex);
+
+    const uint64_t end = writeIndex.load(std::memory_order_acquire);
+
+    // Skip any events that have been overwritten since the last read.
+    if (end - readIndex > RingBufferSize)
+    {
+        readIndex = end - RingBufferSize;
+    }
+
+    size_t count = 0;
+
+    while (readIndex < end && count < capacity)
+    {
+        const Slot& slot = ringBuffer[readIndex & (RingBufferSize - 1)];
+        const uint64_t committed = 2 * (readIndex + 1);
+        const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+
+        // The event is being written, it is returned by a later call.
+        if (sequence == committed - 1)
+        {
+            break;
+        }
+
+        // Otherwise the event was dropped or overwritten unless the sequence matches.
+        if (sequence == committed)
+        {
+            TraceEvent& event = events[count];
+            event.timestamp = slot.timestamp.load(std::memory_order_relaxed);
+            event.operationId = slot.operationId.load(std::memory_order_relaxed);
+            event.phase = static_cast<TracePhase>(slot.phase.load(std::memory_order_relaxed));
+            event.type = static_cast<TraceEventType>(slot.type.load(std::memory_order_relaxed));
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            // Skip the event if the slot was overwritten during the copy.
+            if (slot.sequence.load(std::memory_order_relaxed) == committed)
+            {
+                count++;
+            }
+        }
+
+        readIndex++;
+    }
+
+    return count;
+}
+
+void Trace::WriteEvent(TracePhase phase, TraceEventType type)
+{
+    const uint64_t index = writeIndex.fetch_add(1, std::memory_order_acq_rel);
+
+    Slot& slot = ringBuffer[index & (RingBufferSize - 1)];
+    const uint64_t writing = 2 * (index + 1) - 1;
+    uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+
+    // Drop the event if a later event has claimed the slot, or if an earlier event is still being written to it.
+    do
+    {
+        if (sequence >= writing || (sequence & 1) != 0)
+        {
+            return;
+        }
+    } while (!slot.sequence.compare_exchange_weak(sequence, writing, std::memory_order_relaxed));
+
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.timestamp.store(GetTimestamp(), std::memory_order_relaxed);
+    slot.operationId.store(currentOperationId, std::memory_order_relaxed);
+    slot.phase.store(static_cast<int32_t>(phase), std::memory_order_relaxed);
+    slot.type.store(static_cast<int32_t>(type), std::memory_order_relaxed);
+
+    slot.sequence.store(writing + 1, std::memory_order_release);
+}
+
+Trace::ScopedOperation::ScopedOperation(TracePhase phase)
+    : phase(phase), previousOperationId(currentOperationId), active(IsEnabled())
+{
+    if (active)
+    {
+        currentOperationId = nextOperationId.fetch_add(1, std::memory_order_relaxed);
+        WriteEvent(phase, TraceEventType::Begin);
+    }
+}
+
+Trace::ScopedOperation::~ScopedOperation()
+{
+    if (active)
+    {
+        WriteEvent(phase, TraceEventType::End);
+        currentOperationId = previousOperationId;
+    }
+}
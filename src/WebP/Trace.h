@@ -0,0 +1,116 @@
+////////////////////////////////////////////////////////////////////////
+//
+// This file is part of pdn-webp, a FileType plugin for Paint.NET
+// that loads and saves WebP images.
+//
+// Copyright (c) 2011-2026 Nicholas Hayes
+//
+// This file is licensed under the MIT License.
+// See LICENSE.txt for complete licensing and attribution information.
+//
+////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Common.h"
+#include <atomic>
+
+// This must be kept in sync with the TracePhase enumeration in TracePhase.cs.
+enum class TracePhase : int32_t
+{
+    Decode = 0,
+    Demux,
+    CreateImageCallback,
+    DecodeImage,
+    SetMetadataCallback,
+    Encode,
+    TransparencyScan,
+    Import,
+    WebPEncode,
+    Mux,
+    WriteImageCallback
+};
+
+enum class TraceEventType : int32_t
+{
+    Begin = 0,
+    End
+};
+
+// This must be kept in sync with the TraceEvent structure in TraceEvent.cs.
+typedef struct TraceEvent
+{
+    uint64_t timestamp; // Monotonic time in nanoseconds.
+    uint32_t operationId;
+    TracePhase phase;
+    TraceEventType type;
+}TraceEvent;
+
+// The trace events are stored in a fixed-size ring buffer, when tracing is disabled
+// the cost of each phase is a single relaxed atomic load.
+namespace Trace
+{
+    extern std::atomic<bool> enabled;
+
+    inline bool IsEnabled()
+    {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    void SetEnabled(bool value);
+
+    // Copies the events that have been recorded since the last call into the buffer.
+    // Returns the number of events that were copied.
+    // Events that are still being written are returned by a later call, events that are
+    // overwritten while they are copied are skipped.
+    size_t ReadEvents(TraceEvent* events, size_t capacity);
+
+    void WriteEvent(TracePhase phase, TraceEventType type);
+
+    // Records a phase of the current operation.
+    class ScopedPhase
+    {
+    public:
+        ScopedPhase(TracePhase phase) : phase(phase), active(IsEnabled())
+        {
+            if (active)
+            {
+                WriteEvent(phase, TraceEventType::Begin);
+            }
+        }
+
+        ~ScopedPhase()
+        {
+            if (active)
+            {
+                WriteEvent(phase, TraceEventType::End);
+            }
+        }
+
+        // Disable copying and assignment.
+        ScopedPhase(const ScopedPhase&) = delete;
+        const ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+    private:
+        TracePhase phase;
+        bool active;
+    };
+
+    // Starts a new top-level operation on the current thread, all phases recorded
+    // on this thread until it is destroyed use the same operation id.
+    class ScopedOperation
+    {
+    public:
+        ScopedOperation(TracePhase phase);
+        ~ScopedOperation();
+
+        // Disable copying and assignment.
+        ScopedOperation(const ScopedOperation&) = delete;
+        const ScopedOperation& operator=(const ScopedOperation&) = delete;
+
+    private:
+        TracePhase phase;
+        uint32_t previousOperationId;
+        bool active;
+    };
+}
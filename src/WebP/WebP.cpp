@@ -12,6 +12,7 @@
 
 #include "WebP.h"
 #include "decode.h"
+#include <system_error>
 
 DLLEXPORT int __stdcall GetLibWebPVersion()
 {
@@ -24,14 +25,80 @@ DLLEXPORT int __stdcall GetLibWebPVersion()
 WebPStatus __stdcall WebPLoad(
     const uint8_t* data,
     size_t dataSize,
+    DecoderPixelFormat pixelFormat,
     const CreateImageFn createImageCallback,
-    const SetDecoderMetadataFn setMetadataCallback)
+    const SetDecoderMetadataFn setMetadataCallback,
+    void* callbackContext,
+    MemoryBudget* memoryBudget)
 {
     return WebPDecoder::Decode(
         data,
         dataSize,
+        pixelFormat,
         createImageCallback,
-        setMetadataCallback);
+        setMetadataCallback,
+        callbackContext,
+        memoryBudget);
+}
+
+WebPStatus __stdcall WebPLoadPlanes(
+    const uint8_t* data,
+    size_t dataSize,
+    const CreatePlanesFn createPlanesCallback,
+    const SetDecoderMetadataFn setMetadataCallback,
+    void* callbackContext,
+    MemoryBudget* memoryBudget)
+{
+    return WebPDecoder::DecodePlanes(
+        data,
+        dataSize,
+        createPlanesCallback,
+        setMetadataCallback,
+        callbackContext,
+        memoryBudget);
+}
+
+WebPStatus __stdcall WebPLoadBatch(
+    const uint8_t* const* data,
+    const size_t* dataSizes,
+    size_t count,
+    DecoderPixelFormat pixelFormat,
+    const BatchCreateImageFn createImageCallback,
+    const BatchSetDecoderMetadataFn setMetadataCallback,
+    void* callbackContext,
+    WebPStatus* itemStatus)
+{
+    return WebPDecoder::DecodeBatch(
+        data,
+        dataSizes,
+        count,
+        pixelFormat,
+        createImageCallback,
+        setMetadataCallback,
+        callbackContext,
+        itemStatus);
+}
+
+WebPStatus __stdcall WebPGetImageSize(
+    const uint8_t* data,
+    size_t dataSize,
+    int* width,
+    int* height)
+{
+    return WebPDecoder::GetImageSize(data, dataSize, width, height);
+}
+
+WebPStatus __stdcall WebPLoadInto(
+    const uint8_t* data,
+    size_t dataSize,
+    DecoderPixelFormat pixelFormat,
+    void* output,
+    size_t outputSize,
+    int outputStride,
+    int x,
+    int y)
+{
+    return WebPDecoder::DecodeInto(data, dataSize, pixelFormat, output, outputSize, outputStride, x, y);
 }
 
 WebPStatus __stdcall WebPSave(
@@ -40,17 +107,199 @@ WebPStatus __stdcall WebPSave(
     const int width,
     const int height,
     const int stride,
+    const EncoderPixelFormat pixelFormat,
+    const EncoderRect* cropRect,
     const EncoderOptions* encodeOptions,
     const EncoderMetadata* metadata,
-    ProgressFn progressCallback)
+    ProgressFn progressCallback,
+    void* callbackContext,
+    EncoderStatistics* statistics,
+    MemoryBudget* memoryBudget)
 {
     return WebPEncoder::Encode(
         writeImageCallback,
+        bitmap,
+        width,
+        height,
+        stride,
+        pixelFormat,
+        cropRect,
+        encodeOptions,
+        metadata,
+        progressCallback,
+        callbackContext,
+        statistics,
+        memoryBudget);
+}
+
+WebPStatus __stdcall WebPSaveYUV(
+    const WriteImageFn writeImageCallback,
+    const YUVImage* yuvImage,
+    const int width,
+    const int height,
+    const EncoderOptions* encodeOptions,
+    const EncoderMetadata* metadata,
+    ProgressFn progressCallback,
+    void* callbackContext,
+    EncoderStatistics* statistics,
+    MemoryBudget* memoryBudget)
+{
+    return WebPEncoder::EncodeYUV(
+        writeImageCallback,
+        yuvImage,
+        width,
+        height,
+        encodeOptions,
+        metadata,
+        progressCallback,
+        callbackContext,
+        statistics,
+        memoryBudget);
+}
+
+WebPStatus __stdcall WebPSaveToFile(
+    const FilePathChar* path,
+    const void* bitmap,
+    const int width,
+    const int height,
+    const int stride,
+    const EncoderPixelFormat pixelFormat,
+    const EncoderRect* cropRect,
+    const EncoderOptions* encodeOptions,
+    const EncoderMetadata* metadata,
+    ProgressFn progressCallback,
+    void* callbackContext,
+    EncoderStatistics* statistics,
+    MemoryBudget* memoryBudget)
+{
+    return WebPEncoder::EncodeToFile(
+        path,
+        bitmap,
+        width,
+        height,
+        stride,
+        pixelFormat,
+        cropRect,
+        encodeOptions,
+        metadata,
+        progressCallback,
+        callbackContext,
+        statistics,
+        memoryBudget);
+}
+
+WebPStatus __stdcall WebPSavePyramid(
+    const void* bitmap,
+    const int width,
+    const int height,
+    const int stride,
+    const PyramidLevel* levels,
+    size_t levelCount,
+    const EncoderMetadata* metadata,
+    uint64_t memoryBudget,
+    WebPStatus* levelStatus)
+{
+    return WebPEncoder::EncodePyramid(
+        bitmap,
+        width,
+        height,
+        stride,
+        levels,
+        levelCount,
+        metadata,
+        memoryBudget,
+        levelStatus);
+}
+
+WebPStatus __stdcall WebPCreateEncodeQueue(
+    unsigned int threadCount,
+    uint64_t memoryBudget,
+    EncodeQueue** queue)
+{
+    if (queue == nullptr)
+    {
+        return WebPStatus::InvalidParameter;
+    }
+
+    try
+    {
+        *queue = new EncodeQueue(threadCount, memoryBudget);
+    }
+    catch (const std::bad_alloc&)
+    {
+        return WebPStatus::OutOfMemory;
+    }
+    catch (const std::system_error&)
+    {
+        // The thread pool joins the workers it already created before rethrowing the
+        // system_error from a std::thread that could not be started.
+        return WebPStatus::OutOfMemory;
+    }
+
+    return WebPStatus::Ok;
+}
+
+WebPStatus __stdcall WebPSubmitEncodeJob(
+    EncodeQueue* queue,
+    const void* bitmap,
+    const int width,
+    const int height,
+    const int stride,
+    const EncoderOptions* encodeOptions,
+    const EncoderMetadata* metadata,
+    const WriteImageFn writeImageCallback,
+    const EncodeJobCompletedFn completedCallback,
+    void* context)
+{
+    if (queue == nullptr)
+    {
+        return WebPStatus::InvalidParameter;
+    }
+
+    return queue->Submit(
         bitmap,
         width,
         height,
         stride,
         encodeOptions,
         metadata,
-        progressCallback);
+        writeImageCallback,
+        completedCallback,
+        context);
+}
+
+void __stdcall WebPWaitEncodeQueue(EncodeQueue* queue)
+{
+    if (queue != nullptr)
+    {
+        queue->Wait();
+    }
+}
+
+void __stdcall WebPDestroyEncodeQueue(EncodeQueue* queue)
+{
+    delete queue;
+}
+
+void __stdcall WebPSetTraceEnabled(bool enabled)
+{
+    Trace::SetEnabled(enabled);
+}
+
+size_t __stdcall WebPReadTraceEvents(TraceEvent* events, size_t capacity)
+{
+    return Trace::ReadEvents(events, capacity);
+}
+
+void __stdcall GetWebPMetrics(WebPMetrics* metrics)
+{
+    if (metrics != nullptr)
+    {
+        Metrics::GetSnapshot(metrics);
+    }
+}
+
+void __stdcall ResetWebPMetrics()
+{
+    Metrics::Reset();
 }
@@ -14,24 +14,68 @@
 
 #include "WebPDecoder.h"
 #include "WebPEncoder.h"
+#include "EncodeQueue.h"
+#include "Trace.h"
+#include "Metrics.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#if defined(_WIN32)
 #ifdef WEBP_EXPORTS
 #define DLLEXPORT  __declspec(dllexport)
 #else
 #define DLLEXPORT __declspec(dllimport)
 #endif
+#else
+#define DLLEXPORT __attribute__((visibility("default")))
+#endif
 
 DLLEXPORT int __stdcall GetLibWebPVersion();
 
 DLLEXPORT WebPStatus __stdcall WebPLoad(
     const uint8_t* data,
     size_t dataSize,
+    DecoderPixelFormat pixelFormat,
     const CreateImageFn createImageCallback,
-    const SetDecoderMetadataFn setMetadataCallback);
+    const SetDecoderMetadataFn setMetadataCallback,
+    void* callbackContext,
+    MemoryBudget* memoryBudget);
+
+DLLEXPORT WebPStatus __stdcall WebPLoadPlanes(
+    const uint8_t* data,
+    size_t dataSize,
+    const CreatePlanesFn createPlanesCallback,
+    const SetDecoderMetadataFn setMetadataCallback,
+    void* callbackContext,
+    MemoryBudget* memoryBudget);
+
+DLLEXPORT WebPStatus __stdcall WebPLoadBatch(
+    const uint8_t* const* data,
+    const size_t* dataSizes,
+    size_t count,
+    DecoderPixelFormat pixelFormat,
+    const BatchCreateImageFn createImageCallback,
+    const BatchSetDecoderMetadataFn setMetadataCallback,
+    void* callbackContext,
+    WebPStatus* itemStatus);
+
+DLLEXPORT WebPStatus __stdcall WebPGetImageSize(
+    const uint8_t* data,
+    size_t dataSize,
+    int* width,
+    int* height);
+
+DLLEXPORT WebPStatus __stdcall WebPLoadInto(
+    const uint8_t* data,
+    size_t dataSize,
+    DecoderPixelFormat pixelFormat,
+    void* output,
+    size_t outputSize,
+    int outputStride,
+    int x,
+    int y);
 
 DLLEXPORT WebPStatus __stdcall WebPSave(
     const WriteImageFn writeImageCallback,
@@ -39,9 +83,81 @@ DLLEXPORT WebPStatus __stdcall WebPSave(
     const int width,
     const int height,
     const int stride,
+    const EncoderPixelFormat pixelFormat,
+    const EncoderRect* cropRect,
+    const EncoderOptions* encodeOptions,
+    const EncoderMetadata* metadata,
+    ProgressFn progressCallback,
+    void* callbackContext,
+    EncoderStatistics* statistics,
+    MemoryBudget* memoryBudget);
+
+DLLEXPORT WebPStatus __stdcall WebPSaveYUV(
+    const WriteImageFn writeImageCallback,
+    const YUVImage* yuvImage,
+    const int width,
+    const int height,
+    const EncoderOptions* encodeOptions,
+    const EncoderMetadata* metadata,
+    ProgressFn progressCallback,
+    void* callbackContext,
+    EncoderStatistics* statistics,
+    MemoryBudget* memoryBudget);
+
+DLLEXPORT WebPStatus __stdcall WebPSaveToFile(
+    const FilePathChar* path,
+    const void* bitmap,
+    const int width,
+    const int height,
+    const int stride,
+    const EncoderPixelFormat pixelFormat,
+    const EncoderRect* cropRect,
     const EncoderOptions* encodeOptions,
     const EncoderMetadata* metadata,
-    ProgressFn progressCallback);
+    ProgressFn progressCallback,
+    void* callbackContext,
+    EncoderStatistics* statistics,
+    MemoryBudget* memoryBudget);
+
+DLLEXPORT WebPStatus __stdcall WebPSavePyramid(
+    const void* bitmap,
+    const int width,
+    const int height,
+    const int stride,
+    const PyramidLevel* levels,
+    size_t levelCount,
+    const EncoderMetadata* metadata,
+    uint64_t memoryBudget,
+    WebPStatus* levelStatus);
+
+DLLEXPORT WebPStatus __stdcall WebPCreateEncodeQueue(
+    unsigned int threadCount,
+    uint64_t memoryBudget,
+    EncodeQueue** queue);
+
+DLLEXPORT WebPStatus __stdcall WebPSubmitEncodeJob(
+    EncodeQueue* queue,
+    const void* bitmap,
+    const int width,
+    const int height,
+    const int stride,
+    const EncoderOptions* encodeOptions,
+    const EncoderMetadata* metadata,
+    const WriteImageFn writeImageCallback,
+    const EncodeJobCompletedFn completedCallback,
+    void* context);
+
+DLLEXPORT void __stdcall WebPWaitEncodeQueue(EncodeQueue* queue);
+
+DLLEXPORT void __stdcall WebPDestroyEncodeQueue(EncodeQueue* queue);
+
+DLLEXPORT void __stdcall WebPSetTraceEnabled(bool enabled);
+
+DLLEXPORT size_t __stdcall WebPReadTraceEvents(TraceEvent* events, size_t capacity);
+
+DLLEXPORT void __stdcall GetWebPMetrics(WebPMetrics* metrics);
+
+DLLEXPORT void __stdcall ResetWebPMetrics();
 
 #ifdef __cplusplus
 }
@@ -15,10 +15,21 @@
 #include "demux.h"
 #include "decode.h"
 #include "scoped.h"
+#include "Trace.h"
+#include "Metrics.h"
+#include "MemoryTracker.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <new>
+#include <system_error>
 
 namespace
 {
-    bool SetDecoderMetadata(const WebPDemuxer* dmux, SetDecoderMetadataFn setMetadata, MetadataType type)
+    template <typename SetMetadata>
+    bool SetDecoderMetadata(const WebPDemuxer* dmux, const SetMetadata& setMetadata, MetadataType type)
     {
         const char* fourcc = nullptr;
 
@@ -54,8 +65,11 @@ namespace
         return result;
     }
 
-    bool GetImageMetadata(const WebPDemuxer* demux, SetDecoderMetadataFn setMetadata)
+    template <typename SetMetadata>
+    bool GetImageMetadata(const WebPDemuxer* demux, const SetMetadata& setMetadata)
     {
+        Trace::ScopedPhase tracePhase(TracePhase::SetMetadataCallback);
+
         uint32_t flags = WebPDemuxGetI(demux, WEBP_FF_FORMAT_FLAGS);
 
         if ((flags & ICCP_FLAG) != 0)
@@ -85,14 +99,145 @@ namespace
         return true;
     }
 
+    bool IsValidPixelFormat(DecoderPixelFormat pixelFormat)
+    {
+        return pixelFormat >= DecoderPixelFormat::Bgra && pixelFormat <= DecoderPixelFormat::PremultipliedRgba;
+    }
+
+    WEBP_CSP_MODE GetColorspace(DecoderPixelFormat pixelFormat)
+    {
+        switch (pixelFormat)
+        {
+        case DecoderPixelFormat::PremultipliedBgra:
+            return MODE_bgrA;
+        case DecoderPixelFormat::Rgba:
+            return MODE_RGBA;
+        case DecoderPixelFormat::PremultipliedRgba:
+            return MODE_rgbA;
+        case DecoderPixelFormat::Bgra:
+        default:
+            return MODE_BGRA;
+        }
+    }
+
+    // Points the decoder output at a caller-owned 32-bit buffer.
+    bool SetImageOutput(DecoderPixelFormat pixelFormat, void* outData, size_t outDataSize, int outStride, WebPDecBuffer& output)
+    {
+        if (!outData)
+        {
+            return false;
+        }
+
+        output.colorspace = GetColorspace(pixelFormat);
+        output.u.RGBA.rgba = static_cast<uint8_t*>(outData);
+        output.u.RGBA.size = outDataSize;
+        output.u.RGBA.stride = outStride;
+
+        return true;
+    }
+
+    // Points the decoder output at the caller-owned YUV planes, the alpha plane is optional.
+    // The YUV output is written without upsampling the chroma or converting it to RGB.
+    bool SetPlanesOutput(const DecoderPlanes& planes, WebPDecBuffer& output)
+    {
+        if (!planes.y || !planes.u || !planes.v)
+        {
+            return false;
+        }
+
+        // libwebp rejects a MODE_YUVA buffer without an alpha plane, MODE_YUV discards the alpha.
+        output.colorspace = planes.a ? MODE_YUVA : MODE_YUV;
+        output.u.YUVA.y = planes.y;
+        output.u.YUVA.u = planes.u;
+        output.u.YUVA.v = planes.v;
+        output.u.YUVA.a = planes.a;
+        output.u.YUVA.y_stride = planes.yStride;
+        output.u.YUVA.u_stride = planes.uStride;
+        output.u.YUVA.v_stride = planes.vStride;
+        output.u.YUVA.a_stride = planes.a ? planes.aStride : 0;
+        output.u.YUVA.y_size = planes.ySize;
+        output.u.YUVA.u_size = planes.uSize;
+        output.u.YUVA.v_size = planes.vSize;
+        output.u.YUVA.a_size = planes.a ? planes.aSize : 0;
+
+        return true;
+    }
+
+    void ClearOutsideArea(uint8_t* plane, int stride, int bytesPerPixel, int coveredWidth, int coveredHeight, int width, int height, uint8_t value)
+    {
+        for (int y = 0; y < height; y++)
+        {
+            uint8_t* row = plane + (static_cast<int64_t>(y) * stride);
+            const int start = y < coveredHeight ? coveredWidth : 0;
+
+            if (start < width)
+            {
+                std::memset(row + (static_cast<size_t>(start) * bytesPerPixel), value, static_cast<size_t>(width - start) * bytesPerPixel);
+            }
+        }
+    }
+
+    // WebPDecode writes the first frame to the top-left corner of the output, which is sized from the canvas.
+    // The area that the frame does not cover is cleared to transparent black, the output memory may be reused
+    // and must not expose the pixels of a previous image.
+    void ClearUncoveredArea(const WebPDecBuffer& output, int frameWidth, int frameHeight, int outWidth, int outHeight)
+    {
+        if (frameWidth >= outWidth && frameHeight >= outHeight)
+        {
+            return;
+        }
+
+        if (WebPIsRGBMode(output.colorspace))
+        {
+            const WebPRGBABuffer& rgba = output.u.RGBA;
+
+            ClearOutsideArea(rgba.rgba, rgba.stride, 4, frameWidth, frameHeight, outWidth, outHeight, 0);
+        }
+        else
+        {
+            const WebPYUVABuffer& yuva = output.u.YUVA;
+            const int uvFrameWidth = (frameWidth + 1) / 2;
+            const int uvFrameHeight = (frameHeight + 1) / 2;
+            const int uvWidth = (outWidth + 1) / 2;
+            const int uvHeight = (outHeight + 1) / 2;
+
+            ClearOutsideArea(yuva.y, yuva.y_stride, 1, frameWidth, frameHeight, outWidth, outHeight, 16);
+            ClearOutsideArea(yuva.u, yuva.u_stride, 1, uvFrameWidth, uvFrameHeight, uvWidth, uvHeight, 128);
+            ClearOutsideArea(yuva.v, yuva.v_stride, 1, uvFrameWidth, uvFrameHeight, uvWidth, uvHeight, 128);
+
+            if (yuva.a != nullptr)
+            {
+                ClearOutsideArea(yuva.a, yuva.a_stride, 1, frameWidth, frameHeight, outWidth, outHeight, 0);
+            }
+        }
+    }
+
+    // Returns the minimum size of the output buffer that the create output callback allocates.
+    typedef uint64_t(*GetOutputSizeFn)(int width, int height, bool hasAlpha);
+
+    uint64_t GetImageOutputSize(int width, int height, bool)
+    {
+        // Every DecoderPixelFormat is 32 bits per pixel.
+        return static_cast<uint64_t>(width) * static_cast<uint64_t>(height) * 4;
+    }
+
+    uint64_t GetPlanesOutputSize(int width, int height, bool hasAlpha)
+    {
+        const uint64_t lumaSize = static_cast<uint64_t>(width) * static_cast<uint64_t>(height);
+        const uint64_t chromaSize = static_cast<uint64_t>((width + 1) / 2) * static_cast<uint64_t>((height + 1) / 2);
+
+        return (lumaSize * (hasAlpha ? 2 : 1)) + (chromaSize * 2);
+    }
+
     WebPStatus DecodeImage(
         const WebPData& data,
+        const WebPDecBuffer& output,
         int outWidth,
         int outHeight,
-        void* outData,
-        size_t outDataSize,
-        int outStride)
+        bool useScaling)
     {
+        Trace::ScopedPhase tracePhase(TracePhase::DecodeImage);
+
         WebPDecoderConfig config;
 
         if (!WebPInitDecoderConfig(&config))
@@ -102,13 +247,17 @@ namespace
 
         WebPStatus status = WebPStatus::Ok;
 
-        config.output.colorspace = MODE_BGRA;
+        config.output = output;
         config.output.is_external_memory = 1;
         config.output.width = outWidth;
         config.output.height = outHeight;
-        config.output.u.RGBA.rgba = static_cast<uint8_t*>(outData);
-        config.output.u.RGBA.size = outDataSize;
-        config.output.u.RGBA.stride = outStride;
+
+        if (useScaling)
+        {
+            config.options.use_scaling = 1;
+            config.options.scaled_width = outWidth;
+            config.options.scaled_height = outHeight;
+        }
 
         switch (WebPDecode(data.bytes, data.size, &config))
         {
@@ -138,82 +287,454 @@ namespace
 
         return status;
     }
+
+    // Estimates the memory that libwebp allocates internally when decoding the image.
+    uint64_t EstimateDecoderWorkingSet(const WebPBitstreamFeatures& features, uint64_t width, uint64_t height)
+    {
+        if (features.format == 2)
+        {
+            // The lossless decoder decodes the whole image into a 32-bit ARGB buffer and a 16 row cache.
+            return (width * height * 4) + (width * 16 * 4);
+        }
+        else
+        {
+            // The lossy decoder works on rows of macroblocks, but the alpha plane is decoded in full.
+            return (width * 96) + (features.has_alpha ? width * height : 0);
+        }
+    }
+
+    // Reserves the estimated decoder working set and the output buffer, selecting an output size that
+    // fits within the remaining memory budget and downscaling the image when allowed.
+    WebPStatus SelectOutputSize(
+        const WebPData& data,
+        int canvasWidth,
+        int canvasHeight,
+        bool allowDownscale,
+        GetOutputSizeFn getOutputSize,
+        MemoryTracker& memoryTracker,
+        int& outWidth,
+        int& outHeight,
+        bool& useScaling,
+        bool& hasAlpha)
+    {
+        WebPBitstreamFeatures features;
+
+        if (WebPGetFeatures(data.bytes, data.size, &features) != VP8_STATUS_OK)
+        {
+            return WebPStatus::InvalidImage;
+        }
+
+        hasAlpha = features.has_alpha != 0;
+
+        // The rescaler needs a few rows of 32-bit work memory, allow for it when the image may be downscaled.
+        const uint64_t workingSet = EstimateDecoderWorkingSet(features, canvasWidth, canvasHeight) +
+            (allowDownscale ? static_cast<uint64_t>(canvasWidth) * 32 : 0);
+
+        if (!memoryTracker.Reserve(workingSet))
+        {
+            return WebPStatus::OutOfMemory;
+        }
+
+        outWidth = canvasWidth;
+        outHeight = canvasHeight;
+        useScaling = false;
+
+        const uint64_t canvasOutputSize = getOutputSize(canvasWidth, canvasHeight, hasAlpha);
+
+        if (!memoryTracker.CanReserve(canvasOutputSize))
+        {
+            const uint64_t available = memoryTracker.GetAvailable();
+
+            if (!allowDownscale || available == 0)
+            {
+                return WebPStatus::OutOfMemory;
+            }
+
+            const double scale = std::sqrt(static_cast<double>(available) / static_cast<double>(canvasOutputSize));
+
+            outWidth = std::max(1, static_cast<int>(canvasWidth * scale));
+            outHeight = std::max(1, static_cast<int>(canvasHeight * scale));
+
+            // Correct any rounding error in the scale calculation.
+            while (!memoryTracker.CanReserve(getOutputSize(outWidth, outHeight, hasAlpha)) && (outWidth > 1 || outHeight > 1))
+            {
+                if (outWidth > 1)
+                {
+                    outWidth--;
+                }
+
+                if (outHeight > 1)
+                {
+                    outHeight--;
+                }
+            }
+
+            useScaling = true;
+        }
+
+        // The output is reserved before the create output callback allocates it.
+        if (!memoryTracker.Reserve(getOutputSize(outWidth, outHeight, hasAlpha)))
+        {
+            return WebPStatus::OutOfMemory;
+        }
+
+        return WebPStatus::Ok;
+    }
+
+    // The callbacks are template parameters so that the single image and batch decoders can share this
+    // function, the batch decoder uses lambdas that pass the item index to its callbacks.
+    // The create output callback points the WebPDecBuffer at the caller's memory, see SetImageOutput.
+    template <typename CreateOutput, typename SetMetadata>
+    WebPStatus DecodeFile(
+        const uint8_t* data,
+        size_t dataSize,
+        const CreateOutput& createOutputCallback,
+        const SetMetadata& setMetadataCallback,
+        GetOutputSizeFn getOutputSize,
+        bool allowDownscale,
+        MemoryTracker& memoryTracker,
+        Metrics::OperationInfo& metricsInfo)
+    {
+        WebPData webpData{};
+        webpData.bytes = data;
+        webpData.size = dataSize;
+
+        ScopedWebPDemuxer demux;
+
+        {
+            Trace::ScopedPhase tracePhase(TracePhase::Demux);
+            demux.reset(WebPDemux(&webpData));
+        }
+
+        if (!demux)
+        {
+            return WebPStatus::InvalidImage;
+        }
+
+        const uint32_t canvasWidth = WebPDemuxGetI(demux.get(), WEBP_FF_CANVAS_WIDTH);
+        const uint32_t canvasHeight = WebPDemuxGetI(demux.get(), WEBP_FF_CANVAS_HEIGHT);
+
+        if (canvasWidth == 0 || canvasWidth > static_cast<uint32_t>(std::numeric_limits<int>::max()) ||
+            canvasHeight == 0 || canvasHeight > static_cast<uint32_t>(std::numeric_limits<int>::max()))
+        {
+            return WebPStatus::DecodeFailed;
+        }
+
+        metricsInfo.pixelCount = static_cast<uint64_t>(canvasWidth) * canvasHeight;
+
+        // The metadata is delivered before the image is decoded so that the caller
+        // can parse it while the decode is running.
+        if (!GetImageMetadata(demux.get(), setMetadataCallback))
+        {
+            return WebPStatus::SetMetadataCallbackFailed;
+        }
+
+        WebPDecBuffer output;
+
+        if (!WebPInitDecBuffer(&output))
+        {
+            return WebPStatus::ApiVersionMismatch;
+        }
+
+        WebPStatus status = WebPStatus::Ok;
+
+        WebPIterator iter{};
+        if (WebPDemuxGetFrame(demux.get(), 1, &iter))
+        {
+            int outWidth = 0;
+            int outHeight = 0;
+            bool useScaling = false;
+            bool hasAlpha = false;
+
+            status = SelectOutputSize(
+                iter.fragment,
+                static_cast<int>(canvasWidth),
+                static_cast<int>(canvasHeight),
+                allowDownscale,
+                getOutputSize,
+                memoryTracker,
+                outWidth,
+                outHeight,
+                useScaling,
+                hasAlpha);
+
+            if (status == WebPStatus::Ok)
+            {
+                bool outputCreated = false;
+
+                {
+                    Trace::ScopedPhase tracePhase(TracePhase::CreateImageCallback);
+
+                    outputCreated = createOutputCallback(
+                        outWidth,
+                        outHeight,
+                        hasAlpha,
+                        output);
+                }
+
+                if (outputCreated)
+                {
+                    // A scaled frame is resized to the whole output.
+                    if (!useScaling)
+                    {
+                        ClearUncoveredArea(output, iter.width, iter.height, outWidth, outHeight);
+                    }
+
+                    status = DecodeImage(
+                        iter.fragment,
+                        output,
+                        outWidth,
+                        outHeight,
+                        useScaling);
+                }
+                else
+                {
+                    status = WebPStatus::CreateImageCallbackFailed;
+                }
+            }
+
+            WebPDemuxReleaseIterator(&iter);
+        }
+        else
+        {
+            status = WebPStatus::DecodeFailed;
+        }
+
+        return status;
+    }
+
+    template <typename CreateOutput, typename SetMetadata>
+    WebPStatus DecodeWithMetrics(
+        const uint8_t* data,
+        size_t dataSize,
+        const CreateOutput& createOutputCallback,
+        const SetMetadata& setMetadataCallback,
+        GetOutputSizeFn getOutputSize,
+        MemoryBudget* memoryBudget)
+    {
+        Trace::ScopedOperation traceOperation(TracePhase::Decode);
+
+        const auto start = std::chrono::steady_clock::now();
+
+        MemoryTracker memoryTracker(memoryBudget != nullptr ? memoryBudget->limit : 0);
+        const bool allowDownscale = memoryBudget != nullptr && memoryBudget->allowDownscale;
+
+        Metrics::OperationInfo metricsInfo{};
+
+        WebPStatus status = DecodeFile(
+            data,
+            dataSize,
+            createOutputCallback,
+            setMetadataCallback,
+            getOutputSize,
+            allowDownscale,
+            memoryTracker,
+            metricsInfo);
+
+        metricsInfo.transientBytes = memoryTracker.GetPeakUsage();
+
+        if (memoryBudget != nullptr)
+        {
+            memoryBudget->peakUsage = memoryTracker.GetPeakUsage();
+        }
+
+        Metrics::RecordDecode(
+            status,
+            dataSize,
+            metricsInfo,
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+        return status;
+    }
 }
 
 WebPStatus __stdcall WebPDecoder::Decode(
     const uint8_t* data,
     size_t dataSize,
+    DecoderPixelFormat pixelFormat,
     const CreateImageFn createImageCallback,
-    const SetDecoderMetadataFn setMetadataCallback)
+    const SetDecoderMetadataFn setMetadataCallback,
+    void* callbackContext,
+    MemoryBudget* memoryBudget)
 {
-    if (!data || !createImageCallback || !setMetadataCallback)
+    if (!data || !IsValidPixelFormat(pixelFormat) || !createImageCallback || !setMetadataCallback)
     {
         return WebPStatus::InvalidParameter;
     }
 
-    WebPData webpData{};
-    webpData.bytes = data;
-    webpData.size = dataSize;
+    auto createOutput = [pixelFormat, createImageCallback, callbackContext](int width, int height, bool, WebPDecBuffer& output)
+    {
+        size_t outDataSize = 0;
+        int outStride = 0;
+        void* outData = createImageCallback(callbackContext, width, height, outDataSize, outStride);
 
-    ScopedWebPDemuxer demux(WebPDemux(&webpData));
+        return SetImageOutput(pixelFormat, outData, outDataSize, outStride, output);
+    };
 
-    if (!demux)
+    auto setMetadata = [setMetadataCallback, callbackContext](const uint8_t* metadata, size_t size, MetadataType type)
     {
-        return WebPStatus::InvalidImage;
-    }
+        return setMetadataCallback(callbackContext, metadata, size, type);
+    };
 
-    const uint32_t canvasWidth = WebPDemuxGetI(demux.get(), WEBP_FF_CANVAS_WIDTH);
-    const uint32_t canvasHeight = WebPDemuxGetI(demux.get(), WEBP_FF_CANVAS_HEIGHT);
+    return DecodeWithMetrics(data, dataSize, createOutput, setMetadata, GetImageOutputSize, memoryBudget);
+}
 
-    if (canvasWidth == 0 || canvasWidth > static_cast<uint32_t>(std::numeric_limits<int>::max()) ||
-        canvasHeight == 0 || canvasHeight > static_cast<uint32_t>(std::numeric_limits<int>::max()))
+WebPStatus __stdcall WebPDecoder::DecodePlanes(
+    const uint8_t* data,
+    size_t dataSize,
+    const CreatePlanesFn createPlanesCallback,
+    const SetDecoderMetadataFn setMetadataCallback,
+    void* callbackContext,
+    MemoryBudget* memoryBudget)
+{
+    if (!data || !createPlanesCallback || !setMetadataCallback)
     {
-        return WebPStatus::DecodeFailed;
+        return WebPStatus::InvalidParameter;
     }
 
-    WebPStatus status = WebPStatus::Ok;
+    auto createOutput = [createPlanesCallback, callbackContext](int width, int height, bool hasAlpha, WebPDecBuffer& output)
+    {
+        DecoderPlanes planes{};
+
+        return createPlanesCallback(callbackContext, width, height, hasAlpha, planes) && SetPlanesOutput(planes, output);
+    };
 
-    WebPIterator iter{};
-    if (WebPDemuxGetFrame(demux.get(), 1, &iter))
+    auto setMetadata = [setMetadataCallback, callbackContext](const uint8_t* metadata, size_t size, MetadataType type)
     {
-        size_t outDataSize = 0;
-        int outStride = 0;
+        return setMetadataCallback(callbackContext, metadata, size, type);
+    };
 
-        void* outData = createImageCallback(
-            static_cast<int>(canvasWidth),
-            static_cast<int>(canvasHeight),
-            outDataSize,
-            outStride);
+    return DecodeWithMetrics(data, dataSize, createOutput, setMetadata, GetPlanesOutputSize, memoryBudget);
+}
 
-        if (outData)
-        {
-            status = DecodeImage(
-                iter.fragment,
-                static_cast<int>(canvasWidth),
-                static_cast<int>(canvasHeight),
-                outData,
-                outDataSize,
-                outStride);
-        }
-        else
+WebPStatus __stdcall WebPDecoder::DecodeBatch(
+    const uint8_t* const* data,
+    const size_t* dataSizes,
+    size_t count,
+    DecoderPixelFormat pixelFormat,
+    const BatchCreateImageFn createImageCallback,
+    const BatchSetDecoderMetadataFn setMetadataCallback,
+    void* callbackContext,
+    WebPStatus* itemStatus)
+{
+    if (!data || !dataSizes || !IsValidPixelFormat(pixelFormat) || !createImageCallback || !itemStatus)
+    {
+        return WebPStatus::InvalidParameter;
+    }
+
+    try
+    {
+        ThreadPool::GetDefault().ParallelFor(count, [&](size_t index)
         {
-            status = WebPStatus::CreateImageCallbackFailed;
-        }
+            if (!data[index])
+            {
+                itemStatus[index] = WebPStatus::InvalidParameter;
+                return;
+            }
+
+            auto createOutput = [pixelFormat, createImageCallback, callbackContext, index](int width, int height, bool, WebPDecBuffer& output)
+            {
+                size_t outDataSize = 0;
+                int outStride = 0;
+                void* outData = createImageCallback(callbackContext, index, width, height, outDataSize, outStride);
 
-        WebPDemuxReleaseIterator(&iter);
+                return SetImageOutput(pixelFormat, outData, outDataSize, outStride, output);
+            };
+
+            // The metadata callback is optional, when it is not set the metadata is ignored.
+            auto setMetadata = [setMetadataCallback, callbackContext, index](const uint8_t* metadata, size_t size, MetadataType type)
+            {
+                return setMetadataCallback == nullptr || setMetadataCallback(callbackContext, index, metadata, size, type);
+            };
+
+            itemStatus[index] = DecodeWithMetrics(data[index], dataSizes[index], createOutput, setMetadata, GetImageOutputSize, nullptr);
+        });
+    }
+    catch (const std::bad_alloc&)
+    {
+        return WebPStatus::OutOfMemory;
     }
-    else
+    catch (const std::system_error&)
     {
-        status = WebPStatus::DecodeFailed;
+        // The default thread pool is created on first use.
+        return WebPStatus::OutOfMemory;
     }
 
-    if (status == WebPStatus::Ok)
+    return WebPStatus::Ok;
+}
+
+WebPStatus __stdcall WebPDecoder::GetImageSize(
+    const uint8_t* data,
+    size_t dataSize,
+    int* width,
+    int* height)
+{
+    if (!data || !width || !height)
     {
-        if (!GetImageMetadata(demux.get(), setMetadataCallback))
+        return WebPStatus::InvalidParameter;
+    }
+
+    if (!WebPGetInfo(data, dataSize, width, height))
+    {
+        return WebPStatus::InvalidImage;
+    }
+
+    return WebPStatus::Ok;
+}
+
+WebPStatus __stdcall WebPDecoder::DecodeInto(
+    const uint8_t* data,
+    size_t dataSize,
+    DecoderPixelFormat pixelFormat,
+    void* output,
+    size_t outputSize,
+    int outputStride,
+    int x,
+    int y)
+{
+    if (!data || !IsValidPixelFormat(pixelFormat) || !output || outputStride <= 0 || x < 0 || y < 0)
+    {
+        return WebPStatus::InvalidParameter;
+    }
+
+    int width = 0;
+    int height = 0;
+
+    WebPStatus status = GetImageSize(data, dataSize, &width, &height);
+
+    if (status != WebPStatus::Ok)
+    {
+        return status;
+    }
+
+    // The checks are done before decoding so that an image that does not fit is reported as an
+    // invalid parameter instead of a create image callback failure.
+    const uint64_t rowBytes = static_cast<uint64_t>(width) * 4;
+    const uint64_t offset = (static_cast<uint64_t>(y) * outputStride) + (static_cast<uint64_t>(x) * 4);
+    const uint64_t requiredSize = (static_cast<uint64_t>(height - 1) * outputStride) + rowBytes;
+
+    if ((static_cast<uint64_t>(x) * 4) + rowBytes > static_cast<uint64_t>(outputStride) ||
+        offset + requiredSize > outputSize)
+    {
+        return WebPStatus::InvalidParameter;
+    }
+
+    uint8_t* const destination = static_cast<uint8_t*>(output) + offset;
+
+    auto createOutput = [&](int outWidth, int outHeight, bool, WebPDecBuffer& decBuffer)
+    {
+        if (outWidth != width || outHeight != height)
         {
-            status = WebPStatus::SetMetadataCallbackFailed;
+            return false;
         }
-    }
 
-    return status;
+        return SetImageOutput(pixelFormat, destination, static_cast<size_t>(requiredSize), outputStride, decBuffer);
+    };
+
+    auto setMetadata = [](const uint8_t*, size_t, MetadataType)
+    {
+        return true;
+    };
+
+    return DecodeWithMetrics(data, dataSize, createOutput, setMetadata, GetImageOutputSize, nullptr);
 }
@@ -13,10 +13,21 @@
 #pragma once
 
 #include "Common.h"
+#include "MemoryTracker.h"
 
-// The create image callback.
+// The pixel format of the decoded image, libwebp writes it directly in its output stage.
+// This must be kept in sync with the DecoderPixelFormat enumeration in DecoderPixelFormat.cs.
+enum class DecoderPixelFormat : int32_t
+{
+    Bgra = 0,
+    PremultipliedBgra,
+    Rgba,
+    PremultipliedRgba
+};
+
+// The create image callback, context is the value that was passed to the decode function.
 // Returns a null pointer on error.
-typedef void* (__stdcall* CreateImageFn)(int width, int height, size_t& outImageDataSize, int& outStride);
+typedef void* (__stdcall* CreateImageFn)(void* context, int width, int height, size_t& outImageDataSize, int& outStride);
 
 enum class MetadataType : int32_t
 {
@@ -26,14 +37,91 @@ enum class MetadataType : int32_t
 };
 
 // The set decoder metadata callback function.
+// This is called for each metadata chunk before the create image callback.
+// Returns true if successful, false otherwise.
+typedef bool(__stdcall* SetDecoderMetadataFn)(void* context, const uint8_t* data, size_t size, MetadataType type);
+
+// The create image callback used by the batch decoder, index is the position of the image in the batch.
+// This is called concurrently from multiple threads.
+// Returns a null pointer on error.
+typedef void* (__stdcall* BatchCreateImageFn)(void* context, size_t index, int width, int height, size_t& outImageDataSize, int& outStride);
+
+// The set decoder metadata callback used by the batch decoder.
+// This is called concurrently from multiple threads, and before the create image callback for the same index.
+// Returns true if successful, false otherwise.
+typedef bool(__stdcall* BatchSetDecoderMetadataFn)(void* context, size_t index, const uint8_t* data, size_t size, MetadataType type);
+
+// The caller-owned planes of a YUV 4:2:0 image, using the BT.601 limited range that libwebp outputs.
+// The U and V planes are (width + 1) / 2 by (height + 1) / 2, the alpha plane may be null.
+typedef struct DecoderPlanes
+{
+    uint8_t* y;
+    uint8_t* u;
+    uint8_t* v;
+    uint8_t* a;
+    int yStride;
+    int uStride;
+    int vStride;
+    int aStride;
+    size_t ySize;
+    size_t uSize;
+    size_t vSize;
+    size_t aSize;
+}DecoderPlanes;
+
+// The create planes callback, context is the value that was passed to the decode function.
+// hasAlpha is true if the image has an alpha channel, the alpha is discarded when outPlanes.a is null.
 // Returns true if successful, false otherwise.
-typedef bool(__stdcall* SetDecoderMetadataFn)(const uint8_t* data, size_t size, MetadataType type);
+typedef bool(__stdcall* CreatePlanesFn)(void* context, int width, int height, bool hasAlpha, DecoderPlanes& outPlanes);
 
 namespace WebPDecoder
 {
     WebPStatus __stdcall Decode(
         const uint8_t* data,
         size_t dataSize,
+        DecoderPixelFormat pixelFormat,
         const CreateImageFn createImageCallback,
-        const SetDecoderMetadataFn setMetadataCallback);
+        const SetDecoderMetadataFn setMetadataCallback,
+        void* callbackContext,
+        MemoryBudget* memoryBudget);
+
+    // Decodes the image into caller-owned YUV(A) planes.
+    WebPStatus __stdcall DecodePlanes(
+        const uint8_t* data,
+        size_t dataSize,
+        const CreatePlanesFn createPlanesCallback,
+        const SetDecoderMetadataFn setMetadataCallback,
+        void* callbackContext,
+        MemoryBudget* memoryBudget);
+
+    // Decodes the images on the process-wide thread pool, the status of each image is written to itemStatus.
+    // setMetadataCallback may be null if the image metadata is not required.
+    WebPStatus __stdcall DecodeBatch(
+        const uint8_t* const* data,
+        const size_t* dataSizes,
+        size_t count,
+        DecoderPixelFormat pixelFormat,
+        const BatchCreateImageFn createImageCallback,
+        const BatchSetDecoderMetadataFn setMetadataCallback,
+        void* callbackContext,
+        WebPStatus* itemStatus);
+
+    // Gets the canvas size of the image without decoding it.
+    WebPStatus __stdcall GetImageSize(
+        const uint8_t* data,
+        size_t dataSize,
+        int* width,
+        int* height);
+
+    // Decodes the image into a caller-owned buffer with its top left corner at (x, y).
+    // The image must fit within the buffer, the image metadata is not read.
+    WebPStatus __stdcall DecodeInto(
+        const uint8_t* data,
+        size_t dataSize,
+        DecoderPixelFormat pixelFormat,
+        void* output,
+        size_t outputSize,
+        int outputStride,
+        int x,
+        int y);
 }
\ No newline at end of file
@@ -11,59 +11,380 @@
 ////////////////////////////////////////////////////////////////////////
 
 #include "WebPEncoder.h"
+#include "PixelImport.h"
+#include "Quantizer.h"
 #include "encode.h"
 #include "mux_types.h"
 #include "mux.h"
 #include "scoped.h"
+#include "Trace.h"
+#include "Metrics.h"
+#include "MemoryTracker.h"
+#include "FileWriter.h"
+#include "decode.h"
+#include "Resampler.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <system_error>
+#include <vector>
 
 namespace
 {
-    bool HasTransparency(const void* data, int width, int height, int stride)
+    // The source image, either a bitmap or a set of YUV planes.
+    struct EncoderInput
     {
-        const uint8_t* scan0 = reinterpret_cast<const uint8_t*>(data);
+        const void* bitmap;
+        int stride;
+        EncoderPixelFormat pixelFormat;
+        const YUVImage* yuv;
+    };
+
+    // Points the input at the top left corner of the crop rectangle, the rows keep the bitmap stride
+    // so that the rectangle is encoded in place without copying it.
+    bool ApplyCropRect(const EncoderRect* cropRect, EncoderInput& input, int& width, int& height)
+    {
+        if (cropRect == nullptr)
+        {
+            return true;
+        }
+
+        if (cropRect->x < 0 || cropRect->y < 0 || cropRect->width <= 0 || cropRect->height <= 0 ||
+            static_cast<int64_t>(cropRect->x) + cropRect->width > width ||
+            static_cast<int64_t>(cropRect->y) + cropRect->height > height)
+        {
+            return false;
+        }
+
+        const int64_t offset = (static_cast<int64_t>(cropRect->y) * input.stride) +
+            (static_cast<int64_t>(cropRect->x) * PixelImport::GetBytesPerPixel(input.pixelFormat));
+
+        input.bitmap = static_cast<const uint8_t*>(input.bitmap) + offset;
+        width = cropRect->width;
+        height = cropRect->height;
+
+        return true;
+    }
+
+    bool HasTransparency(const YUVImage* yuv, int width, int height)
+    {
+        if (yuv->a == nullptr)
+        {
+            return false;
+        }
 
         for (int y = 0; y < height; y++)
         {
-            const uint8_t* ptr = scan0 + (static_cast<int64_t>(y) * stride);
+            const uint8_t* ptr = yuv->a + (static_cast<int64_t>(y) * yuv->aStride);
             for (int x = 0; x < width; x++)
             {
-                if (ptr[3] < 255)
+                if (ptr[x] < 255)
                 {
                     return true;
                 }
-
-                ptr += 4;
             }
         }
 
         return false;
     }
 
+    bool HasTransparency(const EncoderInput& input, int width, int height)
+    {
+        Trace::ScopedPhase tracePhase(TracePhase::TransparencyScan);
+
+        if (input.yuv != nullptr)
+        {
+            return HasTransparency(input.yuv, width, height);
+        }
+
+        return PixelImport::HasTransparency(input.bitmap, width, height, input.stride, input.pixelFormat);
+    }
+
+    // Points the picture at the caller's YUV planes without copying them.
+    // The picture must have its width and height set.
+    void SetYUVPlanes(WebPPicture* picture, const YUVImage* yuv, bool hasTransparency)
+    {
+        picture->use_argb = 0;
+        picture->colorspace = hasTransparency ? WEBP_YUV420A : WEBP_YUV420;
+        picture->y = const_cast<uint8_t*>(yuv->y);
+        picture->u = const_cast<uint8_t*>(yuv->u);
+        picture->v = const_cast<uint8_t*>(yuv->v);
+        picture->a = hasTransparency ? const_cast<uint8_t*>(yuv->a) : nullptr;
+        picture->y_stride = yuv->yStride;
+        picture->uv_stride = yuv->uvStride;
+        picture->a_stride = hasTransparency ? yuv->aStride : 0;
+    }
+
+    void CopyPlane(const uint8_t* src, int srcStride, uint8_t* dst, int dstStride, int width, int height)
+    {
+        for (int y = 0; y < height; y++)
+        {
+            memcpy(dst, src, static_cast<size_t>(width));
+
+            src += srcStride;
+            dst += dstStride;
+        }
+    }
+
+    // The lossy encoder modifies the YUV planes of images that have transparency
+    // when it cleans up the transparent area, so those planes are copied.
+    bool ImportYUV(WebPPicture* picture, const YUVImage* yuv, bool hasTransparency)
+    {
+        if (!hasTransparency)
+        {
+            SetYUVPlanes(picture, yuv, false);
+            return true;
+        }
+
+        picture->use_argb = 0;
+        picture->colorspace = WEBP_YUV420A;
+
+        if (WebPPictureAlloc(picture) == 0)
+        {
+            return false;
+        }
+
+        const int width = picture->width;
+        const int height = picture->height;
+        const int uvWidth = (width + 1) / 2;
+        const int uvHeight = (height + 1) / 2;
+
+        CopyPlane(yuv->y, yuv->yStride, picture->y, picture->y_stride, width, height);
+        CopyPlane(yuv->u, yuv->uvStride, picture->u, picture->uv_stride, uvWidth, uvHeight);
+        CopyPlane(yuv->v, yuv->uvStride, picture->v, picture->uv_stride, uvWidth, uvHeight);
+        CopyPlane(yuv->a, yuv->aStride, picture->a, picture->a_stride, width, height);
+
+        return true;
+    }
+
+    // The non-premultiplied 8-bit formats are imported by libwebp, the other formats
+    // are converted to ARGB by the import kernels.
+    bool IsLibWebPImportFormat(EncoderPixelFormat format)
+    {
+        return format == EncoderPixelFormat::Bgra || format == EncoderPixelFormat::Rgba;
+    }
+
+    bool ImportImage(WebPPicture* picture, const EncoderInput& input, bool hasTransparency)
+    {
+        if (input.yuv != nullptr)
+        {
+            return ImportYUV(picture, input.yuv, hasTransparency);
+        }
+
+        if (!IsLibWebPImportFormat(input.pixelFormat))
+        {
+            return PixelImport::ImportARGB(picture, input.bitmap, input.stride, input.pixelFormat);
+        }
+
+        const uint8_t* bitmap = static_cast<const uint8_t*>(input.bitmap);
+
+        // libwebp converts BGRA and RGBA directly to YUV for lossy images.
+        // If the image does not have any transparency import using the BGRX or RGBX method which will ignore the alpha channel.
+        if (input.pixelFormat == EncoderPixelFormat::Rgba)
+        {
+            return hasTransparency ? WebPPictureImportRGBA(picture, bitmap, input.stride) != 0 : WebPPictureImportRGBX(picture, bitmap, input.stride) != 0;
+        }
+
+        return hasTransparency ? WebPPictureImportBGRA(picture, bitmap, input.stride) != 0 : WebPPictureImportBGRX(picture, bitmap, input.stride) != 0;
+    }
+
+    double GetElapsedMilliseconds(const std::chrono::steady_clock::time_point& start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void CopyAuxStats(const WebPAuxStats& auxStats, EncoderStatistics* statistics)
+    {
+        statistics->codedSize = auxStats.coded_size;
+
+        for (int i = 0; i < 5; i++)
+        {
+            statistics->psnr[i] = auxStats.PSNR[i];
+        }
+
+        for (int i = 0; i < 3; i++)
+        {
+            statistics->blockCount[i] = auxStats.block_count[i];
+        }
+
+        statistics->headerBytes[0] = auxStats.header_bytes[0];
+        statistics->headerBytes[1] = auxStats.header_bytes[1];
+
+        for (int i = 0; i < 4; i++)
+        {
+            for (int j = 0; j < 3; j++)
+            {
+                statistics->residualBytes[j][i] = auxStats.residual_bytes[j][i];
+            }
+
+            statistics->segmentSize[i] = auxStats.segment_size[i];
+            statistics->segmentQuant[i] = auxStats.segment_quant[i];
+            statistics->segmentLevel[i] = auxStats.segment_level[i];
+        }
+
+        statistics->alphaDataSize = auxStats.alpha_data_size;
+        statistics->losslessFeatures = auxStats.lossless_features;
+        statistics->histogramBits = auxStats.histogram_bits;
+        statistics->transformBits = auxStats.transform_bits;
+        statistics->cacheBits = auxStats.cache_bits;
+        statistics->paletteSize = auxStats.palette_size;
+        statistics->losslessSize = auxStats.lossless_size;
+        statistics->losslessHeaderSize = auxStats.lossless_hdr_size;
+        statistics->losslessDataSize = auxStats.lossless_data_size;
+    }
+
+    // Computes the PSNR and SSIM of the encoded image against the source image.
+    // The encoded picture cannot be used for this because the lossy encoder converts it to YUV.
+    // Returns false and leaves the distortion at zero if it could not be computed.
+    bool ComputeDistortion(
+        const uint8_t* image,
+        const size_t imageSize,
+        const EncoderInput& input,
+        const int width,
+        const int height,
+        EncoderStatistics* statistics,
+        MemoryTracker& memoryTracker)
+    {
+        ScopedWebPPicture source;
+        ScopedWebPPicture decoded;
+
+        std::fill_n(statistics->distortionPsnr, 5, 0.0f);
+        std::fill_n(statistics->distortionSsim, 5, 0.0f);
+
+        if (source == nullptr || decoded == nullptr || !source.IsInitalized() || !decoded.IsInitalized())
+        {
+            return false;
+        }
+
+        // The decoded BGRA buffer and the ARGB copies of the source and decoded images.
+        // The budget is checked first so that a distortion that does not fit is not recorded as
+        // a failure of the save.
+        const uint64_t workingSet = static_cast<uint64_t>(width) * static_cast<uint64_t>(height) * 4 * 3;
+
+        if (!memoryTracker.CanReserve(workingSet))
+        {
+            return false;
+        }
+
+        memoryTracker.Reserve(workingSet);
+
+        int decodedWidth = 0;
+        int decodedHeight = 0;
+        uint8_t* decodedPixels = WebPDecodeBGRA(image, imageSize, &decodedWidth, &decodedHeight);
+
+        if (decodedPixels == nullptr)
+        {
+            memoryTracker.Release(workingSet);
+            return false;
+        }
+
+        source->use_argb = 1;
+        source->width = width;
+        source->height = height;
+        decoded->use_argb = 1;
+        decoded->width = decodedWidth;
+        decoded->height = decodedHeight;
+
+        bool sourceImported = false;
+
+        if (input.yuv != nullptr)
+        {
+            // The conversion allocates a separate ARGB buffer, the caller's planes are only read.
+            SetYUVPlanes(source.Get(), input.yuv, input.yuv->a != nullptr);
+            sourceImported = WebPPictureYUVAToARGB(source.Get()) != 0;
+        }
+        else if (input.pixelFormat != EncoderPixelFormat::Bgra)
+        {
+            sourceImported = PixelImport::ImportARGB(source.Get(), input.bitmap, input.stride, input.pixelFormat);
+        }
+        else
+        {
+            sourceImported = WebPPictureImportBGRA(source.Get(), static_cast<const uint8_t*>(input.bitmap), input.stride) != 0;
+        }
+
+        bool computed = sourceImported &&
+            WebPPictureImportBGRA(decoded.Get(), decodedPixels, decodedWidth * 4) != 0 &&
+            WebPPictureDistortion(source.Get(), decoded.Get(), 0, statistics->distortionPsnr) != 0 &&
+            WebPPictureDistortion(source.Get(), decoded.Get(), 1, statistics->distortionSsim) != 0;
+
+        if (!computed)
+        {
+            std::fill_n(statistics->distortionPsnr, 5, 0.0f);
+            std::fill_n(statistics->distortionSsim, 5, 0.0f);
+        }
+
+        WebPFree(decodedPixels);
+        memoryTracker.Release(workingSet);
+
+        return computed;
+    }
+
+    template <typename WriteImageCallback>
+    WebPStatus WriteImage(
+        const WriteImageCallback& writeImageCallback,
+        const uint8_t* image,
+        const size_t imageSize,
+        EncoderStatistics* statistics,
+        Metrics::OperationInfo& metricsInfo)
+    {
+        Trace::ScopedPhase tracePhase(TracePhase::WriteImageCallback);
+
+        metricsInfo.outputSize = imageSize;
+
+        const auto writeStart = std::chrono::steady_clock::now();
+
+        WebPStatus status = writeImageCallback(image, imageSize);
+
+        if (statistics != nullptr)
+        {
+            statistics->fileSize = imageSize;
+            statistics->writeTime = GetElapsedMilliseconds(writeStart);
+        }
+
+        return status;
+    }
+
+    struct ProgressContext
+    {
+        ProgressFn callback;
+        void* callbackContext;
+    };
+
     int ProgressReport(int percent, const WebPPicture* picture)
     {
-        ProgressFn callback = reinterpret_cast<ProgressFn>(picture->user_data);
-        bool continueProcessing = callback(percent);
+        const ProgressContext* progress = static_cast<const ProgressContext*>(picture->user_data);
+        bool continueProcessing = progress->callback(progress->callbackContext, percent);
 
         return continueProcessing ? 1 : 0;
     }
 
+    template <typename WriteImageCallback>
     WebPStatus EncodeImageMetadata(
         const uint8_t* image,
         const size_t imageSize,
         const EncoderMetadata* metadata,
-        const WriteImageFn writeImageCallback)
+        const WriteImageCallback& writeImageCallback,
+        EncoderStatistics* statistics,
+        MemoryTracker& memoryTracker,
+        Metrics::OperationInfo& metricsInfo)
     {
-        if (image == nullptr || metadata == nullptr || writeImageCallback == nullptr)
+        if (image == nullptr || metadata == nullptr)
         {
             return WebPStatus::InvalidParameter;
         }
 
+        Trace::ScopedPhase tracePhase(TracePhase::Mux);
+
         ScopedWebPMux mux(WebPMuxNew());
         if (mux == nullptr)
         {
             return WebPStatus::OutOfMemory;
         }
 
+        const auto muxStart = std::chrono::steady_clock::now();
+
         WebPStatus status = WebPStatus::Ok;
 
         WebPData imageData{};
@@ -108,7 +429,19 @@ namespace
 
                 if (muxError == WEBP_MUX_OK)
                 {
-                    status = writeImageCallback(assembler.GetBuffer(), assembler.GetBufferSize());
+                    if (statistics != nullptr)
+                    {
+                        statistics->muxTime = GetElapsedMilliseconds(muxStart);
+                    }
+
+                    if (memoryTracker.Reserve(assembler.GetBufferSize()))
+                    {
+                        status = WriteImage(writeImageCallback, assembler.GetBuffer(), assembler.GetBufferSize(), statistics, metricsInfo);
+                    }
+                    else
+                    {
+                        status = WebPStatus::OutOfMemory;
+                    }
                 }
             }
         }
@@ -133,6 +466,345 @@ namespace
 
         return status;
     }
+
+    // The write callback is a template parameter so that the encode queue can use a lambda
+    // that passes the job context to its callback.
+    template <typename WriteImageCallback>
+    WebPStatus EncodeFile(
+        const WriteImageCallback& writeImageCallback,
+        const EncoderInput& input,
+        const int width,
+        const int height,
+        const EncoderOptions* encodeOptions,
+        const EncoderMetadata* metadata,
+        ProgressFn progressCallback,
+        void* callbackContext,
+        EncoderStatistics* statistics,
+        MemoryTracker& memoryTracker,
+        Metrics::OperationInfo& metricsInfo)
+    {
+        WebPConfig config;
+        ScopedWebPPicture pic;
+        TrackedMemoryWriter wrt(memoryTracker);
+
+        if (pic == nullptr)
+        {
+            return WebPStatus::OutOfMemory;
+        }
+
+        if (encodeOptions->alphaQualityReduction < 0 || encodeOptions->alphaQualityReduction > 100 ||
+            encodeOptions->alphaFiltering < 0 || encodeOptions->alphaFiltering > 3)
+        {
+            return WebPStatus::InvalidEncoderConfiguration;
+        }
+
+        if (encodeOptions->nearLosslessStrength < 0 || encodeOptions->nearLosslessStrength > 100 ||
+            encodeOptions->paletteColors < 0 || encodeOptions->paletteColors == 1 || encodeOptions->paletteColors > 256)
+        {
+            return WebPStatus::InvalidEncoderConfiguration;
+        }
+
+        if (!WebPConfigPreset(&config, static_cast<WebPPreset>(encodeOptions->preset), encodeOptions->quality) || !pic.IsInitalized())
+        {
+            return WebPStatus::ApiVersionMismatch; // WebP API version mismatch
+        }
+
+        config.thread_level = 1;
+        config.alpha_quality = 100 - encodeOptions->alphaQualityReduction;
+        config.alpha_compression = encodeOptions->uncompressedAlpha ? 0 : 1;
+
+        if (encodeOptions->lossless)
+        {
+            WebPConfigLosslessPreset(&config, encodeOptions->effort);
+            // Preserve color values of invisible/transparent pixels like the built-in PNG output of PDN,
+            // unless the caller allows libwebp to replace them with a single color.
+            config.exact = encodeOptions->cleanupTransparentArea ? 0 : 1;
+            // libwebp uses 100 for off and 0 for the most preprocessing.
+            config.near_lossless = 100 - encodeOptions->nearLosslessStrength;
+            pic->use_argb = 1;
+
+            switch (encodeOptions->preset)
+            {
+            case WEBP_PRESET_PHOTO:
+                config.image_hint = WEBP_HINT_PHOTO;
+                break;
+            case WEBP_PRESET_PICTURE:
+                config.image_hint = WEBP_HINT_PICTURE;
+                break;
+            case WEBP_PRESET_DRAWING:
+                config.image_hint = WEBP_HINT_GRAPH;
+                break;
+            }
+        }
+        else
+        {
+            switch (encodeOptions->effort)
+            {
+            case 0:
+                config.method = 0;
+                break;
+            case 1:
+                config.method = 1;
+                break;
+            case 2:
+                config.method = 2;
+                break;
+            case 3:
+                config.method = 3;
+                break;
+            case 4:
+                config.method = 4;
+                break;
+            case 5:
+                config.method = 5;
+                break;
+            case 6:
+                config.method = 6;
+                break;
+            case 7:
+                config.method = 6;
+                config.use_sharp_yuv = 1;
+                break;
+            case 8:
+                config.method = 6;
+                config.use_sharp_yuv = 1;
+                config.autofilter = 1;
+                break;
+            case 9:
+                config.method = 6;
+                config.use_sharp_yuv = 1;
+                config.autofilter = 1;
+                config.alpha_filtering = 2; // best
+                break;
+            }
+
+            // The lossy encoder always runs WebPCleanupTransparentArea, as exact is not set.
+        }
+
+        if (encodeOptions->alphaFiltering > 0)
+        {
+            config.alpha_filtering = encodeOptions->alphaFiltering - 1;
+        }
+
+        pic->width = width;
+        pic->height = height;
+
+        pic->writer = TrackedMemoryWriter::Write;
+        pic->custom_ptr = &wrt;
+
+        WebPAuxStats auxStats{};
+
+        if (statistics != nullptr)
+        {
+            pic->stats = &auxStats;
+        }
+
+        const auto importStart = std::chrono::steady_clock::now();
+
+        const bool hasTransparency = HasTransparency(input, width, height);
+
+        // Fail before importing the image if it would not fit within the memory budget.
+        if (!memoryTracker.Reserve(WebPEncoder::EstimateWorkingSet(width, height, encodeOptions->lossless, hasTransparency)))
+        {
+            return WebPStatus::OutOfMemory;
+        }
+
+        const bool quantize = encodeOptions->lossless && encodeOptions->paletteColors > 0;
+
+        if (quantize && !memoryTracker.Reserve(Quantizer::EstimateWorkingSet(width)))
+        {
+            return WebPStatus::OutOfMemory;
+        }
+
+        // The import kernels write an ARGB picture that the lossy encoder converts to YUV afterwards.
+        if (input.yuv == nullptr && !IsLibWebPImportFormat(input.pixelFormat) && !encodeOptions->lossless &&
+            !memoryTracker.Reserve(static_cast<uint64_t>(width) * static_cast<uint64_t>(height) * 4))
+        {
+            return WebPStatus::OutOfMemory;
+        }
+
+        {
+            Trace::ScopedPhase tracePhase(TracePhase::Import);
+
+            if (!ImportImage(pic.Get(), input, hasTransparency))
+            {
+                return WebPStatus::OutOfMemory;
+            }
+
+            // The YUV input is converted here instead of in WebPEncode so that the colors can be reduced.
+            if (quantize && ((!pic->use_argb && !WebPPictureYUVAToARGB(pic.Get())) ||
+                !Quantizer::QuantizeARGB(pic->argb, width, height, pic->argb_stride, encodeOptions->paletteColors, encodeOptions->paletteDither)))
+            {
+                return WebPStatus::OutOfMemory;
+            }
+        }
+
+        if (statistics != nullptr)
+        {
+            statistics->importTime = GetElapsedMilliseconds(importStart);
+        }
+
+        ProgressContext progressContext{ progressCallback, callbackContext };
+
+        if (progressCallback != nullptr)
+        {
+            pic->user_data = &progressContext;
+            pic->progress_hook = ProgressReport;
+        }
+
+        WebPStatus status = WebPStatus::Ok;
+
+        const auto encodeStart = std::chrono::steady_clock::now();
+
+        int encodeResult = 0;
+
+        {
+            Trace::ScopedPhase tracePhase(TracePhase::WebPEncode);
+            encodeResult = WebPEncode(&config, pic.Get());
+        }
+
+        if (encodeResult != 0) // C-style Boolean
+        {
+            if (statistics != nullptr)
+            {
+                statistics->encodeTime = GetElapsedMilliseconds(encodeStart);
+                CopyAuxStats(auxStats, statistics);
+
+                if (statistics->computeDistortion)
+                {
+                    const auto distortionStart = std::chrono::steady_clock::now();
+
+                    // The image has been encoded, so a failure leaves the distortion at zero instead of failing the save.
+                    ComputeDistortion(wrt.GetBuffer(), wrt.GetBufferSize(), input, width, height, statistics, memoryTracker);
+
+                    statistics->distortionTime = GetElapsedMilliseconds(distortionStart);
+                }
+            }
+
+            if (status == WebPStatus::Ok)
+            {
+                if (metadata != nullptr)
+                {
+                    status = EncodeImageMetadata(wrt.GetBuffer(), wrt.GetBufferSize(), metadata, writeImageCallback, statistics, memoryTracker, metricsInfo);
+                }
+                else
+                {
+                    status = WriteImage(writeImageCallback, wrt.GetBuffer(), wrt.GetBufferSize(), statistics, metricsInfo);
+                }
+            }
+        }
+        else
+        {
+            switch (pic->error_code)
+            {
+            case VP8_ENC_OK:
+                status = WebPStatus::Ok;
+                break;
+            case VP8_ENC_ERROR_OUT_OF_MEMORY:
+            case VP8_ENC_ERROR_BITSTREAM_OUT_OF_MEMORY:
+                status = WebPStatus::OutOfMemory;
+                break;
+            case VP8_ENC_ERROR_NULL_PARAMETER:
+                status = WebPStatus::InvalidParameter;
+                break;
+            case VP8_ENC_ERROR_INVALID_CONFIGURATION:
+                status = WebPStatus::InvalidEncoderConfiguration;
+                break;
+            case VP8_ENC_ERROR_BAD_DIMENSION:
+                status = WebPStatus::BadDimension;
+                break;
+            case VP8_ENC_ERROR_PARTITION0_OVERFLOW:
+                status = WebPStatus::PartitionZeroOverflow;
+                break;
+            case VP8_ENC_ERROR_PARTITION_OVERFLOW:
+                status = WebPStatus::PartitionOverflow;
+                break;
+            case VP8_ENC_ERROR_BAD_WRITE:
+                // The memory writer fails when its buffer would exceed the memory budget.
+                status = memoryTracker.IsLimitExceeded() ? WebPStatus::OutOfMemory : WebPStatus::BadWrite;
+                break;
+            case VP8_ENC_ERROR_FILE_TOO_BIG:
+                status = WebPStatus::FileTooBig;
+                break;
+            case VP8_ENC_ERROR_USER_ABORT:
+                status = WebPStatus::UserAbort;
+                break;
+            default:
+                status = WebPStatus::UnknownError;
+                break;
+            }
+        }
+
+        return status;
+    }
+
+    template <typename WriteImageCallback>
+    WebPStatus EncodeWithMetrics(
+        const WriteImageCallback& writeImageCallback,
+        const EncoderInput& input,
+        const int width,
+        const int height,
+        const EncoderOptions* encodeOptions,
+        const EncoderMetadata* metadata,
+        ProgressFn progressCallback,
+        void* callbackContext,
+        EncoderStatistics* statistics,
+        MemoryBudget* memoryBudget)
+    {
+        Trace::ScopedOperation traceOperation(TracePhase::Encode);
+
+        const auto start = std::chrono::steady_clock::now();
+
+        MemoryTracker memoryTracker(memoryBudget != nullptr ? memoryBudget->limit : 0);
+
+        Metrics::OperationInfo metricsInfo{};
+        metricsInfo.pixelCount = static_cast<uint64_t>(width) * static_cast<uint64_t>(height);
+
+        WebPStatus status = EncodeFile(
+            writeImageCallback,
+            input,
+            width,
+            height,
+            encodeOptions,
+            metadata,
+            progressCallback,
+            callbackContext,
+            statistics,
+            memoryTracker,
+            metricsInfo);
+
+        metricsInfo.transientBytes = memoryTracker.GetPeakUsage();
+
+        if (memoryBudget != nullptr)
+        {
+            memoryBudget->peakUsage = memoryTracker.GetPeakUsage();
+        }
+
+        Metrics::RecordEncode(
+            status,
+            encodeOptions->lossless,
+            encodeOptions->effort,
+            metricsInfo,
+            GetElapsedMilliseconds(start));
+
+        return status;
+    }
+}
+
+uint64_t WebPEncoder::EstimateWorkingSet(int width, int height, bool lossless, bool hasTransparency)
+{
+    const uint64_t pixelCount = static_cast<uint64_t>(width) * static_cast<uint64_t>(height);
+
+    if (lossless)
+    {
+        // The ARGB picture plus the transform and backward reference buffers.
+        return pixelCount * 12;
+    }
+    else
+    {
+        // The YUV 4:2:0 planes and the macroblock data, the alpha plane is compressed with the lossless encoder.
+        return ((pixelCount * 5) / 2) + (hasTransparency ? pixelCount * 9 : 0);
+    }
 }
 
 WebPStatus WebPEncoder::Encode(
@@ -141,173 +813,338 @@ WebPStatus WebPEncoder::Encode(
     const int width,
     const int height,
     const int stride,
+    const EncoderPixelFormat pixelFormat,
+    const EncoderRect* cropRect,
     const EncoderOptions* encodeOptions,
     const EncoderMetadata* metadata,
-    ProgressFn progressCallback)
+    ProgressFn progressCallback,
+    void* callbackContext,
+    EncoderStatistics* statistics,
+    MemoryBudget* memoryBudget)
 {
-    if (writeImageCallback == nullptr || bitmap == nullptr || encodeOptions == nullptr)
+    if (writeImageCallback == nullptr || bitmap == nullptr || !PixelImport::IsValidFormat(pixelFormat) || encodeOptions == nullptr)
     {
         return WebPStatus::InvalidParameter;
     }
 
-    WebPConfig config;
-    ScopedWebPPicture pic;
-    ScopedWebPMemoryWriter wrt;
+    auto writeImage = [writeImageCallback, callbackContext](const uint8_t* image, const size_t imageSize)
+    {
+        return writeImageCallback(callbackContext, image, imageSize);
+    };
+
+    EncoderInput input{ bitmap, stride, pixelFormat, nullptr };
+    int encodeWidth = width;
+    int encodeHeight = height;
 
-    if (pic == nullptr || wrt == nullptr)
+    if (!ApplyCropRect(cropRect, input, encodeWidth, encodeHeight))
     {
-        return WebPStatus::OutOfMemory;
+        return WebPStatus::InvalidParameter;
     }
 
-    if (!WebPConfigPreset(&config, static_cast<WebPPreset>(encodeOptions->preset), encodeOptions->quality) || !pic.IsInitalized())
+    return EncodeWithMetrics(
+        writeImage,
+        input,
+        encodeWidth,
+        encodeHeight,
+        encodeOptions,
+        metadata,
+        progressCallback,
+        callbackContext,
+        statistics,
+        memoryBudget);
+}
+
+WebPStatus WebPEncoder::EncodeToFile(
+    const FilePathChar* path,
+    const void* bitmap,
+    const int width,
+    const int height,
+    const int stride,
+    const EncoderPixelFormat pixelFormat,
+    const EncoderRect* cropRect,
+    const EncoderOptions* encodeOptions,
+    const EncoderMetadata* metadata,
+    ProgressFn progressCallback,
+    void* callbackContext,
+    EncoderStatistics* statistics,
+    MemoryBudget* memoryBudget)
+{
+    if (path == nullptr || bitmap == nullptr || !PixelImport::IsValidFormat(pixelFormat) || encodeOptions == nullptr)
     {
-        return WebPStatus::ApiVersionMismatch; // WebP API version mismatch
+        return WebPStatus::InvalidParameter;
     }
 
-    config.thread_level = 1;
+    auto writeImage = [path](const uint8_t* image, const size_t imageSize)
+    {
+        return FileWriter::WriteFile(path, image, imageSize);
+    };
+
+    EncoderInput input{ bitmap, stride, pixelFormat, nullptr };
+    int encodeWidth = width;
+    int encodeHeight = height;
 
-    if (encodeOptions->lossless)
+    if (!ApplyCropRect(cropRect, input, encodeWidth, encodeHeight))
     {
-        WebPConfigLosslessPreset(&config, encodeOptions->effort);
-        config.exact = 1; // Preserve color values of invisible/transparent pixels like the built-in PNG output of PDN
-        pic->use_argb = 1;
+        return WebPStatus::InvalidParameter;
+    }
 
-        switch (encodeOptions->preset)
-        {
-        case WEBP_PRESET_PHOTO:
-            config.image_hint = WEBP_HINT_PHOTO;
-            break;
-        case WEBP_PRESET_PICTURE:
-            config.image_hint = WEBP_HINT_PICTURE;
-            break;
-        case WEBP_PRESET_DRAWING:
-            config.image_hint = WEBP_HINT_GRAPH;
-            break;
-        }
+    return EncodeWithMetrics(
+        writeImage,
+        input,
+        encodeWidth,
+        encodeHeight,
+        encodeOptions,
+        metadata,
+        progressCallback,
+        callbackContext,
+        statistics,
+        memoryBudget);
+}
+
+WebPStatus WebPEncoder::EncodeYUV(
+    const WriteImageFn writeImageCallback,
+    const YUVImage* yuvImage,
+    const int width,
+    const int height,
+    const EncoderOptions* encodeOptions,
+    const EncoderMetadata* metadata,
+    ProgressFn progressCallback,
+    void* callbackContext,
+    EncoderStatistics* statistics,
+    MemoryBudget* memoryBudget)
+{
+    if (writeImageCallback == nullptr || yuvImage == nullptr || encodeOptions == nullptr ||
+        yuvImage->y == nullptr || yuvImage->u == nullptr || yuvImage->v == nullptr)
+    {
+        return WebPStatus::InvalidParameter;
     }
-    else
+
+    if (width <= 0 || height <= 0 ||
+        yuvImage->yStride < width ||
+        yuvImage->uvStride < (width + 1) / 2 ||
+        (yuvImage->a != nullptr && yuvImage->aStride < width))
     {
-        switch (encodeOptions->effort)
-        {
-        case 0:
-            config.method = 0;
-            break;
-        case 1:
-            config.method = 1;
-            break;
-        case 2:
-            config.method = 2;
-            break;
-        case 3:
-            config.method = 3;
-            break;
-        case 4:
-            config.method = 4;
-            break;
-        case 5:
-            config.method = 5;
-            break;
-        case 6:
-            config.method = 6;
-            break;
-        case 7:
-            config.method = 6;
-            config.use_sharp_yuv = 1;
-            break;
-        case 8:
-            config.method = 6;
-            config.use_sharp_yuv = 1;
-            config.autofilter = 1;
-            break;
-        case 9:
-            config.method = 6;
-            config.use_sharp_yuv = 1;
-            config.autofilter = 1;
-            config.alpha_filtering = 2; // best
-            break;
-        }
+        return WebPStatus::InvalidParameter;
     }
 
-    pic->width = width;
-    pic->height = height;
+    auto writeImage = [writeImageCallback, callbackContext](const uint8_t* image, const size_t imageSize)
+    {
+        return writeImageCallback(callbackContext, image, imageSize);
+    };
+
+    const EncoderInput input{ nullptr, 0, EncoderPixelFormat::Bgra, yuvImage };
 
-    pic->writer = WebPMemoryWrite;
-    pic->custom_ptr = wrt.Get();
+    return EncodeWithMetrics(
+        writeImage,
+        input,
+        width,
+        height,
+        encodeOptions,
+        metadata,
+        progressCallback,
+        callbackContext,
+        statistics,
+        memoryBudget);
+}
 
-    if (HasTransparency(bitmap, width, height, stride))
+WebPStatus WebPEncoder::EncodePyramid(
+    const void* bitmap,
+    const int width,
+    const int height,
+    const int stride,
+    const PyramidLevel* levels,
+    size_t levelCount,
+    const EncoderMetadata* metadata,
+    uint64_t memoryBudget,
+    WebPStatus* levelStatus)
+{
+    if (bitmap == nullptr || width <= 0 || height <= 0 || levels == nullptr || levelStatus == nullptr)
     {
-        if (WebPPictureImportBGRA(pic.Get(), reinterpret_cast<const uint8_t*>(bitmap), stride) == 0)
-        {
-            return WebPStatus::OutOfMemory;
-        }
+        return WebPStatus::InvalidParameter;
     }
-    else
+
+    for (size_t i = 0; i < levelCount; i++)
     {
-        // If the image does not have any transparency import using the BGRX method which will ignore the alpha channel.
-        if (WebPPictureImportBGRX(pic.Get(), reinterpret_cast<const uint8_t*>(bitmap), stride) == 0)
+        const PyramidLevel& level = levels[i];
+
+        if (level.writeImageCallback == nullptr ||
+            level.width <= 0 || level.width > width ||
+            level.height <= 0 || level.height > height)
         {
-            return WebPStatus::OutOfMemory;
+            return WebPStatus::InvalidParameter;
         }
     }
 
-    if (progressCallback != nullptr)
+    // The pixels of each level, the levels that are the same size as their source share its pixels.
+    struct LevelImage
     {
-        pic->user_data = progressCallback;
-        pic->progress_hook = ProgressReport;
-    }
+        const uint8_t* pixels;
+        int stride;
+        std::vector<uint8_t> storage;
+    };
 
-    WebPStatus status = WebPStatus::Ok;
-    if (WebPEncode(&config, pic.Get()) != 0) // C-style Boolean
+    try
     {
-        if (metadata != nullptr)
+        std::vector<LevelImage> images(levelCount);
+        std::vector<size_t> order(levelCount);
+        uint64_t levelImagesSize = 0;
+
+        for (size_t i = 0; i < levelCount; i++)
         {
-            status = EncodeImageMetadata(wrt.GetBuffer(), wrt.GetBufferSize(), metadata, writeImageCallback);
+            order[i] = i;
         }
-        else
+
+        // Build the largest levels first so that each level can be downscaled from a smaller source.
+        std::sort(order.begin(), order.end(), [levels](size_t left, size_t right)
+        {
+            return static_cast<int64_t>(levels[left].width) * levels[left].height >
+                   static_cast<int64_t>(levels[right].width) * levels[right].height;
+        });
+
+        for (size_t i = 0; i < levelCount; i++)
         {
-            status = writeImageCallback(wrt.GetBuffer(), wrt.GetBufferSize());
+            const PyramidLevel& level = levels[order[i]];
+            LevelImage& image = images[order[i]];
+
+            const uint8_t* sourcePixels = static_cast<const uint8_t*>(bitmap);
+            int sourceWidth = width;
+            int sourceHeight = height;
+            int sourceStride = stride;
+
+            // The built levels are in decreasing size, so the last one that contains this level is the smallest.
+            for (size_t j = i; j-- > 0;)
+            {
+                const PyramidLevel& built = levels[order[j]];
+
+                if (built.width >= level.width && built.height >= level.height)
+                {
+                    sourcePixels = images[order[j]].pixels;
+                    sourceWidth = built.width;
+                    sourceHeight = built.height;
+                    sourceStride = images[order[j]].stride;
+                    break;
+                }
+            }
+
+            if (sourceWidth == level.width && sourceHeight == level.height)
+            {
+                image.pixels = sourcePixels;
+                image.stride = sourceStride;
+            }
+            else
+            {
+                image.stride = level.width * 4;
+
+                const size_t imageSize = static_cast<size_t>(image.stride) * static_cast<size_t>(level.height);
+
+                if (memoryBudget != 0 && levelImagesSize + imageSize > memoryBudget)
+                {
+                    return WebPStatus::OutOfMemory;
+                }
+
+                image.storage.resize(imageSize);
+                levelImagesSize += imageSize;
+                image.pixels = image.storage.data();
+
+                if (!Resampler::DownscaleArea(
+                    sourcePixels,
+                    sourceWidth,
+                    sourceHeight,
+                    sourceStride,
+                    image.storage.data(),
+                    level.width,
+                    level.height,
+                    image.stride))
+                {
+                    return WebPStatus::OutOfMemory;
+                }
+            }
+        }
+
+        // The downscaled levels are held until every level has been encoded.
+        const uint64_t available = memoryBudget != 0 ? memoryBudget - levelImagesSize : 0;
+        std::vector<MemoryBudget> levelBudgets(levelCount);
+        size_t waveStart = 0;
+
+        // The levels are encoded in waves whose estimated working sets fit in the remaining budget, so that
+        // the pool threads never wait for each other. A level that is larger than the remaining budget is
+        // encoded by itself.
+        while (waveStart < levelCount)
+        {
+            size_t waveEnd = waveStart + 1;
+            uint64_t waveCost = EstimateWorkingSet(
+                levels[order[waveStart]].width,
+                levels[order[waveStart]].height,
+                levels[order[waveStart]].options.lossless,
+                true);
+
+            if (memoryBudget != 0)
+            {
+                while (waveEnd < levelCount)
+                {
+                    const PyramidLevel& level = levels[order[waveEnd]];
+                    const uint64_t cost = EstimateWorkingSet(level.width, level.height, level.options.lossless, true);
+
+                    if (waveCost + cost > available)
+                    {
+                        break;
+                    }
+
+                    waveCost += cost;
+                    waveEnd++;
+                }
+
+                // Each level gets its estimate plus a share of the unused budget in proportion to its estimate.
+                // A limit of 0 means no limit, so an exhausted budget is represented by a limit of 1.
+                const uint64_t slack = available > waveCost ? available - waveCost : 0;
+
+                for (size_t i = waveStart; i < waveEnd; i++)
+                {
+                    const PyramidLevel& level = levels[order[i]];
+                    const uint64_t cost = EstimateWorkingSet(level.width, level.height, level.options.lossless, true);
+                    const uint64_t share = waveCost > 0 ? static_cast<uint64_t>(static_cast<double>(slack) * cost / waveCost) : 0;
+
+                    levelBudgets[order[i]].limit = std::max<uint64_t>(std::min(cost + share, available), 1);
+                }
+            }
+            else
+            {
+                waveEnd = levelCount;
+            }
+
+            ThreadPool::GetDefault().ParallelFor(waveEnd - waveStart, [&](size_t item)
+            {
+                const size_t index = order[waveStart + item];
+                const PyramidLevel& level = levels[index];
+
+                levelStatus[index] = Encode(
+                    level.writeImageCallback,
+                    images[index].pixels,
+                    level.width,
+                    level.height,
+                    images[index].stride,
+                    EncoderPixelFormat::Bgra,
+                    nullptr,
+                    &level.options,
+                    metadata,
+                    nullptr,
+                    level.callbackContext,
+                    nullptr,
+                    memoryBudget != 0 ? &levelBudgets[index] : nullptr);
+            });
+
+            waveStart = waveEnd;
         }
     }
-    else
+    catch (const std::bad_alloc&)
     {
-        switch (pic->error_code)
-        {
-        case VP8_ENC_OK:
-            status = WebPStatus::Ok;
-            break;
-        case VP8_ENC_ERROR_OUT_OF_MEMORY:
-        case VP8_ENC_ERROR_BITSTREAM_OUT_OF_MEMORY:
-            status = WebPStatus::OutOfMemory;
-            break;
-        case VP8_ENC_ERROR_NULL_PARAMETER:
-            status = WebPStatus::InvalidParameter;
-            break;
-        case VP8_ENC_ERROR_INVALID_CONFIGURATION:
-            status = WebPStatus::InvalidEncoderConfiguration;
-            break;
-        case VP8_ENC_ERROR_BAD_DIMENSION:
-            status = WebPStatus::BadDimension;
-            break;
-        case VP8_ENC_ERROR_PARTITION0_OVERFLOW:
-            status = WebPStatus::PartitionZeroOverflow;
-            break;
-        case VP8_ENC_ERROR_PARTITION_OVERFLOW:
-            status = WebPStatus::PartitionOverflow;
-            break;
-        case VP8_ENC_ERROR_BAD_WRITE:
-            status = WebPStatus::BadWrite;
-            break;
-        case VP8_ENC_ERROR_FILE_TOO_BIG:
-            status = WebPStatus::FileTooBig;
-            break;
-        case VP8_ENC_ERROR_USER_ABORT:
-            status = WebPStatus::UserAbort;
-            break;
-        default:
-            status = WebPStatus::UnknownError;
-            break;
-        }
+        return WebPStatus::OutOfMemory;
+    }
+    catch (const std::system_error&)
+    {
+        // The default thread pool is created on first use.
+        return WebPStatus::OutOfMemory;
     }
 
-    return status;
+    return WebPStatus::Ok;
 }
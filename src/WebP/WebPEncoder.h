@@ -13,25 +13,56 @@
 #pragma once
 
 #include "Common.h"
+#include "MemoryTracker.h"
+#include "FileWriter.h"
 
-// The progress callback function.
+// The progress callback function, context is the value that was passed to the encode function.
 // Returns true if encoding should continue, or false to abort the encoding process.
-typedef bool(__stdcall* ProgressFn)(int progress);
+typedef bool(__stdcall* ProgressFn)(void* context, int progress);
 
-// The write image callback.
+// The write image callback, context is the value that was passed to the encode function.
 // This saves memory when writing large images by allowing the caller to read the image in chunks from
 // the WebPMemoryWriter's buffer instead requiring that new memory be allocated to store the entire image.
-typedef WebPStatus(__stdcall* WriteImageFn)(const uint8_t* image, const size_t imageSize);
+typedef WebPStatus(__stdcall* WriteImageFn)(void* context, const uint8_t* image, const size_t imageSize);
 
+// The pixel format of the bitmap that is passed to the encoder.
+// This must be kept in sync with the EncoderPixelFormat enumeration in EncoderPixelFormat.cs.
+enum class EncoderPixelFormat : int32_t
+{
+    Bgra = 0,           // 8-bit straight alpha
+    PremultipliedBgra,  // 8-bit premultiplied alpha
+    Rgba,               // 8-bit straight alpha
+    Rgba64              // 16-bit straight alpha in native byte order, dithered to 8-bit
+};
+
+// The part of the bitmap that is encoded, the rows outside of it are never read.
+// This must be kept in sync with the EncoderRect structure in EncoderRect.cs.
+typedef struct EncoderRect
+{
+    int x;
+    int y;
+    int width;
+    int height;
+}EncoderRect;
+
+// This must be kept in sync with the Native structure in EncoderOptions.cs.
 typedef struct EncoderOptions
 {
     float quality;
     int effort;
     int preset;
     bool lossless;
+    bool cleanupTransparentArea;    // Lets lossless images change the color of fully transparent pixels, lossy images always do.
+    // The alpha options use 0 for the default so that a zero-initialized structure keeps the libwebp behavior.
+    int alphaQualityReduction;      // Lossy only, 0 (lossless alpha) to 100 (smallest), libwebp uses alpha_quality = 100 - value.
+    int alphaFiltering;             // 0 to select it from the effort, 1 = none, 2 = fast, 3 = best.
+    bool uncompressedAlpha;         // Stores the lossy alpha plane without compression.
+    int nearLosslessStrength;       // Lossless only, 0 = off to 100 = the most preprocessing.
+    int paletteColors;              // Lossless only, reduces the image to 2 - 256 colors before encoding, 0 = off.
+    bool paletteDither;             // Dithers the reduced colors.
 }EncoderOptions;
 
-// This must be kept in sync with the Native structure in MetadataCustomMarshaler.cs.
+// This must be kept in sync with the Native structure in EncoderMetadata.cs.
 typedef struct EncoderMetadata
 {
     uint8_t* iccProfile;
@@ -42,6 +73,73 @@ typedef struct EncoderMetadata
     size_t xmpSize;
 }EncoderMetadata;
 
+// The encoder statistics, populated when the caller passes a non-null pointer to WebPSave.
+// With the exception of computeDistortion all fields are written by the encoder.
+// This must be kept in sync with the EncoderStatistics structure in EncoderStatistics.cs.
+typedef struct EncoderStatistics
+{
+    // Input: compute the PSNR and SSIM of the encoded image against the source bitmap.
+    // This requires decoding the encoded image, so it is rather CPU-intensive.
+    bool computeDistortion;
+
+    // The values reported by the libwebp WebPAuxStats structure.
+    int codedSize;
+    float psnr[5];              // Y/U/V/All/Alpha
+    int blockCount[3];          // intra4/intra16/skipped macroblocks
+    int headerBytes[2];         // header and mode-partition #0
+    int residualBytes[3][4];    // DC/AC/uv coefficients for each segment
+    int segmentSize[4];
+    int segmentQuant[4];
+    int segmentLevel[4];
+    int alphaDataSize;
+    uint32_t losslessFeatures;  // bit0:predictor bit1:cross-color transform bit2:subtract-green bit3:color indexing
+    int histogramBits;
+    int transformBits;
+    int cacheBits;
+    int paletteSize;
+    int losslessSize;
+    int losslessHeaderSize;
+    int losslessDataSize;
+
+    // The distortion metrics in B/G/R/A/All order, only set when computeDistortion is true.
+    // They are left at zero if the distortion could not be computed.
+    float distortionPsnr[5];
+    float distortionSsim[5];
+
+    // The size of the output file, including any metadata chunks.
+    uint64_t fileSize;
+
+    // The wall time for each phase, in milliseconds.
+    double importTime;
+    double encodeTime;
+    double muxTime;
+    double writeTime;
+    double distortionTime;
+}EncoderStatistics;
+
+// The planar YUV 4:2:0 input for EncodeYUV, using the BT.601 limited range that libwebp expects.
+// The U and V planes are (width + 1) / 2 by (height + 1) / 2, the alpha plane is optional.
+typedef struct YUVImage
+{
+    const uint8_t* y;
+    const uint8_t* u;
+    const uint8_t* v;
+    const uint8_t* a;
+    int yStride;
+    int uvStride;
+    int aStride;
+}YUVImage;
+
+// One output of EncodePyramid, each level is written through its own callback.
+typedef struct PyramidLevel
+{
+    int width;
+    int height;
+    EncoderOptions options;
+    WriteImageFn writeImageCallback;
+    void* callbackContext;
+}PyramidLevel;
+
 namespace WebPEncoder
 {
     WebPStatus Encode(
@@ -50,7 +148,62 @@ namespace WebPEncoder
         const int width,
         const int height,
         const int stride,
+        const EncoderPixelFormat pixelFormat,
+        const EncoderRect* cropRect,
+        const EncoderOptions* encodeOptions,
+        const EncoderMetadata* metadata,
+        ProgressFn progressCallback,
+        void* callbackContext,
+        EncoderStatistics* statistics,
+        MemoryBudget* memoryBudget);
+
+    // Encodes the image and writes it to the specified file without going through a write callback.
+    WebPStatus EncodeToFile(
+        const FilePathChar* path,
+        const void* bitmap,
+        const int width,
+        const int height,
+        const int stride,
+        const EncoderPixelFormat pixelFormat,
+        const EncoderRect* cropRect,
         const EncoderOptions* encodeOptions,
         const EncoderMetadata* metadata,
-        ProgressFn progressCallback);
+        ProgressFn progressCallback,
+        void* callbackContext,
+        EncoderStatistics* statistics,
+        MemoryBudget* memoryBudget);
+
+    // Encodes the image from planar YUV input, this avoids the RGB to YUV conversion for lossy images.
+    // The caller's planes are passed to the encoder without copying them unless the image has transparency.
+    WebPStatus EncodeYUV(
+        const WriteImageFn writeImageCallback,
+        const YUVImage* yuvImage,
+        const int width,
+        const int height,
+        const EncoderOptions* encodeOptions,
+        const EncoderMetadata* metadata,
+        ProgressFn progressCallback,
+        void* callbackContext,
+        EncoderStatistics* statistics,
+        MemoryBudget* memoryBudget);
+
+    // Encodes the BGRA image at several sizes, the levels must not be larger than the image.
+    // Each level is downscaled from the smallest level that contains it, or from the image itself, and
+    // the levels are then encoded concurrently on the process-wide thread pool.
+    // The memory budget bounds the downscaled levels and the estimated working sets of the levels that are
+    // encoded at once, 0 for no limit. Each level is encoded with its own share of the budget.
+    // The metadata is written to every level, the status of each level is written to levelStatus.
+    WebPStatus EncodePyramid(
+        const void* bitmap,
+        const int width,
+        const int height,
+        const int stride,
+        const PyramidLevel* levels,
+        size_t levelCount,
+        const EncoderMetadata* metadata,
+        uint64_t memoryBudget,
+        WebPStatus* levelStatus);
+
+    // Estimates the memory that libwebp allocates for the picture planes and the encoder working set.
+    uint64_t EstimateWorkingSet(int width, int height, bool lossless, bool hasTransparency);
 }
\ No newline at end of file
@@ -172,73 +172,3 @@ private:
     WebPPicture* picture;
     bool initialized;
 };
-
-class ScopedWebPMemoryWriter
-{
-public:
-
-    ScopedWebPMemoryWriter() : writer(new(std::nothrow)WebPMemoryWriter)
-    {
-        if (writer != nullptr)
-        {
-            WebPMemoryWriterInit(writer);
-        }
-    }
-
-    ~ScopedWebPMemoryWriter()
-    {
-        Release();
-    }
-
-    // Disable copying and assignment.
-    ScopedWebPMemoryWriter(const ScopedWebPMemoryWriter&) = delete;
-    const ScopedWebPMemoryWriter& operator=(const ScopedWebPMemoryWriter&) = delete;
-
-    WebPMemoryWriter* Get() const
-    {
-        return writer;
-    }
-
-    uint8_t* GetBuffer() const
-    {
-        if (writer != nullptr)
-        {
-            return writer->mem;
-        }
-        else
-        {
-            return nullptr;
-        }
-    }
-
-    size_t GetBufferSize() const
-    {
-        if (writer != nullptr)
-        {
-            return writer->size;
-        }
-        else
-        {
-            return 0;
-        }
-    }
-
-    void Release()
-    {
-        if (writer != nullptr)
-        {
-            WebPMemoryWriterClear(writer);
-
-            delete writer;
-            writer = nullptr;
-        }
-    }
-
-    int operator==(nullptr_t)
-    {
-        return writer == nullptr;
-    }
-
-private:
-    WebPMemoryWriter* writer;
-};
@@ -0,0 +1,149 @@
+﻿////////////////////////////////////////////////////////////////////////
+//
+// This file is part of pdn-webp, a FileType plugin for Paint.NET
+// that loads and saves WebP images.
+//
+// Copyright (c) 2011-2026 Nicholas Hayes
+//
+// This file is licensed under the MIT License.
+// See LICENSE.txt for complete licensing and attribution information.
+//
+////////////////////////////////////////////////////////////////////////
+
+using PaintDotNet;
+using System;
+using System.IO;
+using System.Runtime.CompilerServices;
+using System.Runtime.InteropServices;
+using System.Threading.Tasks;
+using WebPFileType.Interop;
+
+namespace WebPFileType
+{
+    /// <summary>
+    /// Encodes images on the native encode queue worker threads.
+    /// </summary>
+    /// <remarks>
+    /// The memory budget bounds the estimated memory used by the jobs that are in flight,
+    /// <see cref="Submit"/> blocks until there is enough room in the budget for the new job.
+    /// </remarks>
+    internal sealed class WebPEncodeQueue : IDisposable
+    {
+        private nint queue;
+
+        /// <summary>
+        /// Initializes a new instance of the <see cref="WebPEncodeQueue"/> class.
+        /// </summary>
+        /// <param name="threadCount">The number of worker threads, 0 to use one per logical processor.</param>
+        /// <param name="memoryBudget">The maximum number of bytes used by the jobs that are in flight, 0 for no limit.</param>
+        public WebPEncodeQueue(uint threadCount, ulong memoryBudget)
+        {
+            queue = WebPNative.CreateEncodeQueue(threadCount, memoryBudget);
+        }
+
+        /// <summary>
+        /// Queues an image to be encoded.
+        /// </summary>
+        /// <param name="input">The input surface, it must not be modified or disposed until the returned task completes.</param>
+        /// <param name="output">The output stream.</param>
+        /// <param name="options">The encode parameters.</param>
+        /// <param name="metadata">The image metadata.</param>
+        /// <returns>A task that completes when the image has been written to the output stream.</returns>
+        /// <exception cref="ArgumentNullException"><paramref name="input"/> is null.
+        /// or
+        /// <paramref name="output"/> is null.</exception>
+        /// <exception cref="ObjectDisposedException">The queue has been disposed.</exception>
+        public unsafe Task Submit(Surface input, Stream output, EncoderOptions options, EncoderMetadata? metadata)
+        {
+            ArgumentNullException.ThrowIfNull(input);
+            ArgumentNullException.ThrowIfNull(output);
+            ObjectDisposedException.ThrowIf(queue == 0, this);
+
+            EncodeJob job = new(input, output);
+
+            // The handle keeps the job and its surface alive until the completion callback frees it.
+            GCHandle jobHandle = GCHandle.Alloc(job);
+
+            WebPStatus status = WebPNative.SubmitEncodeJob(queue,
+                                                           input,
+                                                           options,
+                                                           metadata,
+                                                           &WriteImage,
+                                                           &JobCompleted,
+                                                           GCHandle.ToIntPtr(jobHandle));
+
+            if (status != WebPStatus.Ok)
+            {
+                jobHandle.Free();
+                job.Completion.SetException(WebPNative.CreateEncoderException(status, null));
+            }
+
+            return job.Completion.Task;
+        }
+
+        /// <summary>
+        /// Waits until all of the queued images have been encoded.
+        /// </summary>
+        public void Wait()
+        {
+            ObjectDisposedException.ThrowIf(queue == 0, this);
+
+            WebPNative.WaitEncodeQueue(queue);
+        }
+
+        public void Dispose()
+        {
+            if (queue != 0)
+            {
+                // Destroying the queue waits for the pending jobs, so the callbacks
+                // cannot be invoked after this returns.
+                WebPNative.DestroyEncodeQueue(queue);
+                queue = 0;
+            }
+        }
+
+        [UnmanagedCallersOnly(CallConvs = new Type[] { typeof(CallConvStdcall) })]
+        private static WebPStatus WriteImage(nint context, nint image, nuint imageSize)
+        {
+            EncodeJob job = (EncodeJob)GCHandle.FromIntPtr(context).Target!;
+
+            return job.Handler.WriteImageCallback(image, imageSize);
+        }
+
+        [UnmanagedCallersOnly(CallConvs = new Type[] { typeof(CallConvStdcall) })]
+        private static void JobCompleted(nint context, WebPStatus status)
+        {
+            GCHandle jobHandle = GCHandle.FromIntPtr(context);
+            EncodeJob job = (EncodeJob)jobHandle.Target!;
+
+            jobHandle.Free();
+
+            if (status == WebPStatus.Ok)
+            {
+                job.Completion.SetResult();
+            }
+            else
+            {
+                job.Completion.SetException(WebPNative.CreateEncoderException(status, job.Handler.WriteException));
+            }
+        }
+
+        private sealed class EncodeJob
+        {
+            public EncodeJob(Surface input, Stream output)
+            {
+                Input = input;
+                Handler = new StreamIOHandler(output);
+                // The continuations must not run on the native worker thread.
+                Completion = new TaskCompletionSource(TaskCreationOptions.RunContinuationsAsynchronously);
+            }
+
+            // Keeps the surface reachable while the native encoder is reading from it.
+            public Surface Input { get; }
+
+            public StreamIOHandler Handler { get; }
+
+            public TaskCompletionSource Completion { get; }
+        }
+    }
+}
@@ -152,14 +152,10 @@ namespace WebPFileType
                         }
                     }
 
-                    byte[]? xmpBytes = metadata.GetXmpBytes();
-                    if (xmpBytes != null)
+                    XmpPacket? xmpPacket = metadata.Xmp;
+                    if (xmpPacket != null)
                     {
-                        XmpPacket? xmpPacket = XmpPacket.TryParse(xmpBytes);
-                        if (xmpPacket != null)
-                        {
-                            doc.Metadata.SetXmpPacket(xmpPacket);
-                        }
+                        doc.Metadata.SetXmpPacket(xmpPacket);
                     }
 
                     doc.Layers.Add(Layer.CreateBackgroundLayer(surface, takeOwnership: true));
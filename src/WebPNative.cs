@@ -12,9 +12,12 @@
 
 using PaintDotNet;
 using System;
+using System.Collections.Generic;
+using System.Drawing;
 using System.Globalization;
 using System.IO;
 using System.Runtime.InteropServices;
+using System.Text;
 using WebPFileType.Interop;
 using WebPFileType.Properties;
 
@@ -32,20 +35,7 @@ namespace WebPFileType
         /// </returns>
         internal static Version GetLibWebPVersion()
         {
-            int packedVersion;
-
-            if (RuntimeInformation.ProcessArchitecture == Architecture.X64)
-            {
-                packedVersion = WebP_x64.GetLibWebPVersion();
-            }
-            else if (RuntimeInformation.ProcessArchitecture == Architecture.Arm64)
-            {
-                packedVersion = WebP_ARM64.GetLibWebPVersion();
-            }
-            else
-            {
-                throw new PlatformNotSupportedException();
-            }
+            int packedVersion = WebP.GetLibWebPVersion();
 
             int major = (packedVersion >> 16) & 0xff;
             int minor = (packedVersion >> 8) & 0xff;
@@ -58,149 +48,712 @@ namespace WebPFileType
         /// The WebP load function.
         /// </summary>
         /// <param name="webpBytes">The input image data</param>
+        /// <param name="memoryBudget">The optional memory budget, the peak memory usage is written back to it.</param>
+        /// <param name="surfacePool">The optional pool that the output surface is taken from.</param>
+        /// <param name="pixelFormat">The pixel format that the image is decoded to.</param>
         /// <exception cref="ArgumentNullException"><paramref name="webpBytes"/> is null.</exception>
-        /// <exception cref="OutOfMemoryException">Insufficient memory to load the WebP image.</exception>
+        /// <exception cref="OutOfMemoryException">
+        /// Insufficient memory to load the WebP image.
+        /// -or-
+        /// The image does not fit within the memory budget.
+        /// </exception>
         /// <exception cref="WebPException">
         /// The WebP image is invalid.
         /// -or-
         /// A native API parameter is invalid.
         /// </exception>
-        internal static unsafe (Surface, DecoderMetadata) WebPLoad(byte[] webpBytes)
+        internal static unsafe (Surface, DecoderMetadata) WebPLoad(
+            byte[] webpBytes,
+            MemoryBudget? memoryBudget = null,
+            SurfacePool? surfacePool = null,
+            DecoderPixelFormat pixelFormat = DecoderPixelFormat.Bgra)
         {
             ArgumentNullException.ThrowIfNull(webpBytes, nameof(webpBytes));
 
             WebPStatus status;
 
-            DecoderCreateImage createImage = new();
-            DecoderMetadata metadata = new();
+            DecoderCallbacks callbacks = new(surfacePool);
+            GCHandle callbacksHandle = GCHandle.Alloc(callbacks);
 
-            IDecoderMetadataNative nativeDecoderMetadata = metadata;
-            WebPCreateImage createImageCallback = createImage.CreateImage;
-            WebPSetDecoderMetadata setMetadataCallback = nativeDecoderMetadata.SetDecoderMetadata;
+            MemoryBudget.Native nativeBudget = memoryBudget?.ToNative() ?? default;
+            MemoryBudget.Native* nativeBudgetPtr = memoryBudget != null ? &nativeBudget : null;
 
-            fixed (byte* ptr = webpBytes)
+            try
             {
-                if (RuntimeInformation.ProcessArchitecture == Architecture.X64)
+                fixed (byte* ptr = webpBytes)
                 {
-                    status = WebP_x64.WebPLoad(ptr, new UIntPtr((uint)webpBytes.Length), createImageCallback, setMetadataCallback);
+                    status = WebP.WebPLoad(ptr,
+                                           (nuint)webpBytes.Length,
+                                           pixelFormat,
+                                           &DecoderCallbacks.CreateImage,
+                                           &DecoderCallbacks.SetDecoderMetadata,
+                                           GCHandle.ToIntPtr(callbacksHandle),
+                                           nativeBudgetPtr);
                 }
-                else if (RuntimeInformation.ProcessArchitecture == Architecture.Arm64)
+            }
+            finally
+            {
+                callbacksHandle.Free();
+            }
+
+            if (memoryBudget != null)
+            {
+                memoryBudget.peakUsage = nativeBudget.peakUsage;
+            }
+
+            if (status != WebPStatus.Ok)
+            {
+                callbacks.ReleaseSurface();
+
+                switch (status)
                 {
-                    status = WebP_ARM64.WebPLoad(ptr, new UIntPtr((uint)webpBytes.Length), createImageCallback, setMetadataCallback);
+                    case WebPStatus.CreateImageCallbackFailed:
+                        callbacks.CallbackErrorInfo!.Throw();
+                        break;
+                    case WebPStatus.SetMetadataCallbackFailed:
+                        ((IDecoderMetadataNative)callbacks.Metadata).CallbackError!.Throw();
+                        break;
+                    default:
+                        throw CreateDecoderException(status, nameof(WebPLoad));
                 }
-                else
+            }
+
+            return (callbacks.GetSurface()!, callbacks.Metadata);
+        }
+
+        /// <summary>
+        /// Decodes a batch of WebP images on the native thread pool.
+        /// </summary>
+        /// <param name="images">The input image data for each image.</param>
+        /// <param name="surfacePool">The optional pool that the output surfaces are taken from.</param>
+        /// <param name="pixelFormat">The pixel format that the images are decoded to.</param>
+        /// <returns>
+        /// The decoded image and metadata for each input, or the exception describing why the image could not be decoded.
+        /// </returns>
+        /// <exception cref="ArgumentNullException"><paramref name="images"/> is null or contains a null item.</exception>
+        /// <exception cref="WebPException">A native API parameter is invalid.</exception>
+        internal static unsafe (Surface? Surface, DecoderMetadata? Metadata, Exception? Error)[] WebPLoadBatch(
+            IReadOnlyList<byte[]> images,
+            SurfacePool? surfacePool = null,
+            DecoderPixelFormat pixelFormat = DecoderPixelFormat.Bgra)
+        {
+            ArgumentNullException.ThrowIfNull(images, nameof(images));
+
+            int count = images.Count;
+            (Surface? Surface, DecoderMetadata? Metadata, Exception? Error)[] results = new (Surface?, DecoderMetadata?, Exception?)[count];
+
+            if (count == 0)
+            {
+                return results;
+            }
+
+            BatchDecoderCallbacks callbacks = new(count, surfacePool);
+            GCHandle callbacksHandle = GCHandle.Alloc(callbacks);
+
+            GCHandle[] handles = new GCHandle[count];
+            nint[] data = new nint[count];
+            nuint[] dataSizes = new nuint[count];
+            WebPStatus[] itemStatus = new WebPStatus[count];
+            WebPStatus status;
+
+            try
+            {
+                for (int i = 0; i < count; i++)
                 {
-                    throw new PlatformNotSupportedException();
+                    byte[] item = images[i];
+                    ArgumentNullException.ThrowIfNull(item, nameof(images));
+
+                    handles[i] = GCHandle.Alloc(item, GCHandleType.Pinned);
+                    data[i] = handles[i].AddrOfPinnedObject();
+                    dataSizes[i] = (nuint)item.Length;
+                }
+
+                fixed (nint* dataPtr = data)
+                fixed (nuint* dataSizesPtr = dataSizes)
+                fixed (WebPStatus* itemStatusPtr = itemStatus)
+                {
+                    status = WebP.WebPLoadBatch(dataPtr,
+                                                dataSizesPtr,
+                                                (nuint)count,
+                                                pixelFormat,
+                                                &BatchDecoderCallbacks.CreateImage,
+                                                &BatchDecoderCallbacks.SetDecoderMetadata,
+                                                GCHandle.ToIntPtr(callbacksHandle),
+                                                itemStatusPtr);
                 }
             }
+            finally
+            {
+                for (int i = 0; i < handles.Length; i++)
+                {
+                    if (handles[i].IsAllocated)
+                    {
+                        handles[i].Free();
+                    }
+                }
 
-            GC.KeepAlive(createImageCallback);
-            GC.KeepAlive(setMetadataCallback);
+                callbacksHandle.Free();
+            }
 
             if (status != WebPStatus.Ok)
             {
-                switch (status)
+                callbacks.ReleaseSurfaces();
+                throw CreateDecoderException(status, nameof(WebPLoadBatch));
+            }
+
+            for (int i = 0; i < count; i++)
+            {
+                switch (itemStatus[i])
                 {
-                    case WebPStatus.OutOfMemory:
-                        throw new OutOfMemoryException();
-                    case WebPStatus.InvalidParameter:
-                        throw new WebPException(string.Format(CultureInfo.InvariantCulture, Resources.InvalidParameterFormat, nameof(WebPLoad)));
-                    case WebPStatus.UnsupportedFeature:
-                        throw new WebPException(Resources.UnsupportedWebPFeature);
-                    case WebPStatus.CreateImageCallbackFailed:
-                        createImage.CallbackErrorInfo!.Throw();
+                    case WebPStatus.Ok:
+                        results[i] = (callbacks.GetSurface(i), callbacks.GetMetadata(i), null);
                         break;
+                    case WebPStatus.CreateImageCallbackFailed:
                     case WebPStatus.SetMetadataCallbackFailed:
-                        nativeDecoderMetadata.CallbackError!.Throw();
+                        callbacks.ReleaseSurface(i);
+                        results[i] = (null, null, callbacks.GetCallbackError(i));
                         break;
-                    case WebPStatus.DecodeFailed:
-                        throw new WebPException(Resources.DecoderGenericError);
                     default:
-                        throw new WebPException(Resources.InvalidWebPImage);
+                        callbacks.ReleaseSurface(i);
+                        results[i] = (null, null, CreateDecoderException(itemStatus[i], nameof(WebPLoadBatch)));
+                        break;
                 }
             }
 
-            return (createImage.GetSurface()!, metadata);
+            return results;
+        }
+
+        /// <summary>
+        /// Gets the dimensions of a WebP image without decoding it.
+        /// </summary>
+        /// <param name="webpBytes">The input image data.</param>
+        /// <returns>The width and height of the image.</returns>
+        /// <exception cref="ArgumentNullException"><paramref name="webpBytes"/> is null.</exception>
+        /// <exception cref="WebPException">The WebP image is invalid.</exception>
+        internal static unsafe (int Width, int Height) WebPGetImageSize(byte[] webpBytes)
+        {
+            ArgumentNullException.ThrowIfNull(webpBytes, nameof(webpBytes));
+
+            int width;
+            int height;
+            WebPStatus status;
+
+            fixed (byte* ptr = webpBytes)
+            {
+                status = WebP.WebPGetImageSize(ptr, (nuint)webpBytes.Length, &width, &height);
+            }
+
+            if (status != WebPStatus.Ok)
+            {
+                throw CreateDecoderException(status, nameof(WebPGetImageSize));
+            }
+
+            return (width, height);
+        }
+
+        /// <summary>
+        /// Decodes a WebP image into an existing surface.
+        /// </summary>
+        /// <param name="webpBytes">The input image data.</param>
+        /// <param name="destination">The surface that the image is decoded into.</param>
+        /// <param name="x">The x coordinate of the top left corner of the image in <paramref name="destination"/>.</param>
+        /// <param name="y">The y coordinate of the top left corner of the image in <paramref name="destination"/>.</param>
+        /// <param name="pixelFormat">The pixel format that the image is decoded to.</param>
+        /// <remarks>
+        /// This allows many images to be decoded into a single surface, such as an atlas, without an
+        /// intermediate surface for each image. Use <see cref="WebPGetImageSize(byte[])"/> to get the image
+        /// dimensions before decoding. The image metadata is not read.
+        /// </remarks>
+        /// <exception cref="ArgumentNullException">
+        /// <paramref name="webpBytes"/> is null.
+        /// -or-
+        /// <paramref name="destination"/> is null.
+        /// </exception>
+        /// <exception cref="ArgumentOutOfRangeException"><paramref name="x"/> or <paramref name="y"/> is negative.</exception>
+        /// <exception cref="OutOfMemoryException">Insufficient memory to load the WebP image.</exception>
+        /// <exception cref="WebPException">
+        /// The WebP image is invalid.
+        /// -or-
+        /// The image does not fit within <paramref name="destination"/> at the specified location.
+        /// </exception>
+        internal static unsafe void WebPLoadInto(
+            byte[] webpBytes,
+            Surface destination,
+            int x,
+            int y,
+            DecoderPixelFormat pixelFormat = DecoderPixelFormat.Bgra)
+        {
+            ArgumentNullException.ThrowIfNull(webpBytes, nameof(webpBytes));
+            ArgumentNullException.ThrowIfNull(destination, nameof(destination));
+            ArgumentOutOfRangeException.ThrowIfNegative(x, nameof(x));
+            ArgumentOutOfRangeException.ThrowIfNegative(y, nameof(y));
+
+            WebPStatus status;
+
+            fixed (byte* ptr = webpBytes)
+            {
+                status = WebP.WebPLoadInto(ptr,
+                                           (nuint)webpBytes.Length,
+                                           pixelFormat,
+                                           destination.Scan0.VoidStar,
+                                           (nuint)destination.Scan0.Length,
+                                           destination.Stride,
+                                           x,
+                                           y);
+            }
+
+            if (status != WebPStatus.Ok)
+            {
+                throw CreateDecoderException(status, nameof(WebPLoadInto));
+            }
         }
 
         /// <summary>
         /// The WebP save function.
         /// </summary>
-        /// <param name="writeImageCallback">The callback used to write the WebP image.</param>
         /// <param name="input">The input surface.</param>
+        /// <param name="output">The output stream.</param>
         /// <param name="options">The encode parameters.</param>
         /// <param name="metadata">The image metadata.</param>
         /// <param name="callback">The progress callback.</param>
-        /// <exception cref="ArgumentNullException"><paramref name="writeImageCallback"/> is null.
+        /// <param name="collectStatistics">
+        /// <see langword="true"/> if the encoder statistics should be collected; otherwise, <see langword="false"/>.
+        /// </param>
+        /// <param name="computeDistortion">
+        /// <see langword="true"/> if the PSNR and SSIM of the encoded image should be computed; otherwise, <see langword="false"/>.
+        /// This implies <paramref name="collectStatistics"/>, the distortion is left at zero if it could not be computed.
+        /// </param>
+        /// <param name="memoryBudget">The optional memory budget, the peak memory usage is written back to it.</param>
+        /// <param name="cropRect">The optional part of <paramref name="input"/> to encode, the whole surface is encoded when null.</param>
+        /// <returns>The encoder statistics, or the default value if no statistics were requested.</returns>
+        /// <exception cref="ArgumentNullException"><paramref name="input"/> is null.
         /// or
-        /// <paramref name="input"/> is null.</exception>
+        /// <paramref name="output"/> is null.</exception>
+        /// <exception cref="ArgumentOutOfRangeException"><paramref name="cropRect"/> is not within <paramref name="input"/>.</exception>
         /// <exception cref="OutOfMemoryException">Insufficient memory to save the image.</exception>
         /// <exception cref="WebPException">The encoder returned a non-memory related error.</exception>
-        internal static void WebPSave(
+        internal static unsafe EncoderStatistics WebPSave(
             Surface input,
             Stream output,
             EncoderOptions options,
             EncoderMetadata? metadata,
-            WebPReportProgress? callback)
+            WebPReportProgress? callback,
+            bool collectStatistics = false,
+            bool computeDistortion = false,
+            MemoryBudget? memoryBudget = null,
+            Rectangle? cropRect = null)
         {
             ArgumentNullException.ThrowIfNull(input);
+            ArgumentNullException.ThrowIfNull(output);
 
-            StreamIOHandler handler = new(output);
-            WebPWriteImage writeImageCallback = handler.WriteImageCallback;
+            return Encode(input, output, null, options, metadata, callback, collectStatistics, computeDistortion, memoryBudget, cropRect);
+        }
+
+        /// <summary>
+        /// Encodes the image and writes it directly to a file from the native code.
+        /// </summary>
+        /// <param name="input">The input surface.</param>
+        /// <param name="path">The path of the output file, an existing file is overwritten.</param>
+        /// <param name="options">The encode parameters.</param>
+        /// <param name="metadata">The image metadata.</param>
+        /// <param name="callback">The progress callback.</param>
+        /// <param name="collectStatistics">
+        /// <see langword="true"/> if the encoder statistics should be collected; otherwise, <see langword="false"/>.
+        /// </param>
+        /// <param name="computeDistortion">
+        /// <see langword="true"/> if the PSNR and SSIM of the encoded image should be computed; otherwise, <see langword="false"/>.
+        /// This implies <paramref name="collectStatistics"/>, the distortion is left at zero if it could not be computed.
+        /// </param>
+        /// <param name="memoryBudget">The optional memory budget, the peak memory usage is written back to it.</param>
+        /// <param name="cropRect">The optional part of <paramref name="input"/> to encode, the whole surface is encoded when null.</param>
+        /// <returns>The encoder statistics, or the default value if no statistics were requested.</returns>
+        /// <exception cref="ArgumentNullException"><paramref name="input"/> is null.
+        /// or
+        /// <paramref name="path"/> is null.</exception>
+        /// <exception cref="ArgumentOutOfRangeException"><paramref name="cropRect"/> is not within <paramref name="input"/>.</exception>
+        /// <exception cref="OutOfMemoryException">Insufficient memory to save the image.</exception>
+        /// <exception cref="IOException">The file could not be written.</exception>
+        /// <exception cref="WebPException">The encoder returned a non-memory related error.</exception>
+        internal static unsafe EncoderStatistics WebPSaveToFile(
+            Surface input,
+            string path,
+            EncoderOptions options,
+            EncoderMetadata? metadata,
+            WebPReportProgress? callback,
+            bool collectStatistics = false,
+            bool computeDistortion = false,
+            MemoryBudget? memoryBudget = null,
+            Rectangle? cropRect = null)
+        {
+            ArgumentNullException.ThrowIfNull(input);
+            ArgumentNullException.ThrowIfNull(path);
 
-            WebPStatus retVal = WebPStatus.Ok;
+            return Encode(input, null, path, options, metadata, callback, collectStatistics, computeDistortion, memoryBudget, cropRect);
+        }
 
-            if (RuntimeInformation.ProcessArchitecture == Architecture.X64)
+        /// <summary>
+        /// Creates a native encode queue.
+        /// </summary>
+        /// <param name="threadCount">The number of worker threads, 0 to use one per logical processor.</param>
+        /// <param name="memoryBudget">The estimated memory that the queued jobs may use at once, 0 for no limit.</param>
+        /// <returns>The native queue handle, which must be released with <see cref="DestroyEncodeQueue(nint)"/>.</returns>
+        /// <exception cref="OutOfMemoryException">Insufficient memory to create the queue or its worker threads.</exception>
+        /// <exception cref="WebPException">The native library returned a non-memory related error.</exception>
+        internal static unsafe nint CreateEncodeQueue(uint threadCount, ulong memoryBudget)
+        {
+            nint queue;
+            WebPStatus status = WebP.WebPCreateEncodeQueue(threadCount, memoryBudget, &queue);
+
+            if (status != WebPStatus.Ok)
             {
-                retVal = WebP_x64.WebPSave(writeImageCallback, input.Scan0.Pointer, input.Width, input.Height, input.Stride, options, metadata, callback);
+                throw CreateEncoderException(status, null);
             }
-            else if (RuntimeInformation.ProcessArchitecture == Architecture.Arm64)
+
+            return queue;
+        }
+
+        /// <summary>
+        /// Queues an encode job on a native encode queue.
+        /// </summary>
+        /// <param name="queue">The native queue handle.</param>
+        /// <param name="input">The input surface, which must not be modified or disposed until the job has completed.</param>
+        /// <param name="options">The encoder options.</param>
+        /// <param name="metadata">The optional image metadata, the native queue makes a copy of it.</param>
+        /// <param name="writeImageCallback">The callback that writes the encoded image.</param>
+        /// <param name="completedCallback">The callback that is invoked on a worker thread when the job has finished.</param>
+        /// <param name="context">The context that is passed to the callbacks.</param>
+        /// <returns>The status of the submission, the job status is passed to <paramref name="completedCallback"/>.</returns>
+        internal static unsafe WebPStatus SubmitEncodeJob(
+            nint queue,
+            Surface input,
+            EncoderOptions options,
+            EncoderMetadata? metadata,
+            delegate* unmanaged[Stdcall]<nint, nint, nuint, WebPStatus> writeImageCallback,
+            delegate* unmanaged[Stdcall]<nint, WebPStatus, void> completedCallback,
+            nint context)
+        {
+            EncoderOptions.Native nativeOptions = options.ToNative();
+
+            // The native queue copies the metadata, so it only needs to be pinned for the duration of the call.
+            using EncoderMetadata.PinnedNative pinnedMetadata = metadata?.Pin() ?? default;
+            EncoderMetadata.Native nativeMetadata = pinnedMetadata.Value;
+
+            return WebP.WebPSubmitEncodeJob(queue,
+                                            input.Scan0.Pointer,
+                                            input.Width,
+                                            input.Height,
+                                            input.Stride,
+                                            &nativeOptions,
+                                            metadata != null ? &nativeMetadata : null,
+                                            writeImageCallback,
+                                            completedCallback,
+                                            context);
+        }
+
+        /// <summary>
+        /// Waits until all of the jobs on a native encode queue have completed.
+        /// </summary>
+        /// <param name="queue">The native queue handle.</param>
+        internal static void WaitEncodeQueue(nint queue)
+        {
+            WebP.WebPWaitEncodeQueue(queue);
+        }
+
+        /// <summary>
+        /// Waits for the pending jobs and releases a native encode queue.
+        /// </summary>
+        /// <param name="queue">The native queue handle.</param>
+        internal static void DestroyEncodeQueue(nint queue)
+        {
+            WebP.WebPDestroyEncodeQueue(queue);
+        }
+
+        /// <summary>
+        /// Creates the exception that is thrown for an encoder error.
+        /// </summary>
+        /// <param name="status">The encoder status.</param>
+        /// <param name="writeException">The exception thrown by the output stream, if any.</param>
+        /// <returns>The exception for <paramref name="status"/>.</returns>
+        internal static Exception CreateEncoderException(WebPStatus status, Exception? writeException)
+        {
+            switch (status)
             {
-                retVal = WebP_ARM64.WebPSave(writeImageCallback, input.Scan0.Pointer, input.Width, input.Height, input.Stride, options, metadata, callback);
+                case WebPStatus.OutOfMemory:
+                    return new OutOfMemoryException(Resources.InsufficientMemoryOnSave);
+                case WebPStatus.FileTooBig:
+                    return new WebPException(Resources.EncoderFileTooBig);
+                case WebPStatus.ApiVersionMismatch:
+                    return new WebPException(Resources.ApiVersionMismatch);
+                case WebPStatus.MetadataEncoding:
+                    return new WebPException(Resources.EncoderMetadataError);
+                case WebPStatus.UserAbort:
+                    return new OperationCanceledException();
+                case WebPStatus.BadDimension:
+                    return new WebPException(Resources.InvalidImageDimensions);
+                case WebPStatus.InvalidParameter:
+                    return new WebPException(Resources.EncoderNullParameter);
+                case WebPStatus.InvalidConfiguration:
+                    return new WebPException(Resources.EncoderInvalidConfiguration);
+                case WebPStatus.PartitionZeroOverflow:
+                    return new WebPException(Resources.EncoderPartitionZeroOverflow);
+                case WebPStatus.PartitionOverflow:
+                    return new WebPException(Resources.EncoderPartitionOverflow);
+                case WebPStatus.BadWrite:
+                    if (writeException != null)
+                    {
+                        return new IOException(Resources.EncoderBadWrite, writeException);
+                    }
+                    else
+                    {
+                        return new IOException(Resources.EncoderBadWrite);
+                    }
+                default:
+                    return new WebPException(Resources.EncoderGenericError);
             }
-            else
+        }
+
+        /// <summary>
+        /// Enables or disables the native phase tracing.
+        /// </summary>
+        /// <param name="enabled">
+        /// <see langword="true"/> if the native library should record trace events; otherwise, <see langword="false"/>.
+        /// </param>
+        internal static void SetTraceEnabled(bool enabled)
+        {
+            WebP.WebPSetTraceEnabled((byte)(enabled ? 1 : 0));
+        }
+
+        /// <summary>
+        /// Reads the trace events recorded since the last call and formats the time spent in
+        /// each phase of every WebPLoad or WebPSave operation.
+        /// </summary>
+        /// <returns>
+        /// A string containing one line per operation.
+        /// </returns>
+        internal static unsafe string GetTraceBreakdown()
+        {
+            const int BufferSize = 1024;
+
+            TraceEvent* buffer = stackalloc TraceEvent[BufferSize];
+
+            // The phase totals are stored in the order that the operations started.
+            List<(uint OperationId, double[] Totals)> operations = [];
+            Dictionary<uint, (double[] Totals, ulong[] BeginTimestamps)> activeOperations = [];
+
+            int phaseCount = Enum.GetValues<TracePhase>().Length;
+
+            while (true)
             {
-                throw new PlatformNotSupportedException();
+                nuint count;
+
+                count = WebP.WebPReadTraceEvents(buffer, BufferSize);
+
+                if (count == 0)
+                {
+                    break;
+                }
+
+                for (nuint i = 0; i < count; i++)
+                {
+                    TraceEvent item = buffer[i];
+                    int phase = (int)item.phase;
+
+                    if (phase < 0 || phase >= phaseCount)
+                    {
+                        continue;
+                    }
+
+                    if (!activeOperations.TryGetValue(item.operationId, out (double[] Totals, ulong[] BeginTimestamps) state))
+                    {
+                        state = (new double[phaseCount], new ulong[phaseCount]);
+                        activeOperations.Add(item.operationId, state);
+                        operations.Add((item.operationId, state.Totals));
+                    }
+
+                    if (item.type == TraceEventType.Begin)
+                    {
+                        state.BeginTimestamps[phase] = item.timestamp;
+                    }
+                    else if (state.BeginTimestamps[phase] != 0)
+                    {
+                        state.Totals[phase] += (item.timestamp - state.BeginTimestamps[phase]) / 1_000_000.0;
+                        state.BeginTimestamps[phase] = 0;
+                    }
+                }
             }
 
-            GC.KeepAlive(writeImageCallback);
+            StringBuilder builder = new();
 
-            if (retVal != WebPStatus.Ok)
+            foreach ((uint operationId, double[] totals) in operations)
             {
-                switch (retVal)
+                builder.Append(CultureInfo.InvariantCulture, $"Operation {operationId}:");
+
+                for (int i = 0; i < totals.Length; i++)
                 {
-                    case WebPStatus.OutOfMemory:
-                        throw new OutOfMemoryException(Resources.InsufficientMemoryOnSave);
-                    case WebPStatus.FileTooBig:
-                        throw new WebPException(Resources.EncoderFileTooBig);
-                    case WebPStatus.ApiVersionMismatch:
-                        throw new WebPException(Resources.ApiVersionMismatch);
-                    case WebPStatus.MetadataEncoding:
-                        throw new WebPException(Resources.EncoderMetadataError);
-                    case WebPStatus.UserAbort:
-                        throw new OperationCanceledException();
-                    case WebPStatus.BadDimension:
-                        throw new WebPException(Resources.InvalidImageDimensions);
-                    case WebPStatus.InvalidParameter:
-                        throw new WebPException(Resources.EncoderNullParameter);
-                    case WebPStatus.InvalidConfiguration:
-                        throw new WebPException(Resources.EncoderInvalidConfiguration);
-                    case WebPStatus.PartitionZeroOverflow:
-                        throw new WebPException(Resources.EncoderPartitionZeroOverflow);
-                    case WebPStatus.PartitionOverflow:
-                        throw new WebPException(Resources.EncoderPartitionOverflow);
-                    case WebPStatus.BadWrite:
-                        if (handler.WriteException != null)
-                        {
-                            throw new IOException(Resources.EncoderBadWrite, handler.WriteException);
-                        }
-                        else
-                        {
-                            throw new IOException(Resources.EncoderBadWrite);
-                        }
-                    default:
-                        throw new WebPException(Resources.EncoderGenericError);
+                    if (totals[i] > 0)
+                    {
+                        builder.Append(CultureInfo.InvariantCulture, $" {(TracePhase)i}={totals[i]:F3}ms");
+                    }
+                }
+
+                builder.AppendLine();
+            }
+
+            return builder.ToString();
+        }
+
+        /// <summary>
+        /// Gets a snapshot of the process-wide decoder and encoder metrics.
+        /// </summary>
+        /// <returns>
+        /// The metrics recorded since the process started or the last call to <see cref="ResetMetrics"/>.
+        /// </returns>
+        internal static unsafe WebPMetrics GetMetrics()
+        {
+            WebPMetrics metrics;
+
+            WebP.GetWebPMetrics(&metrics);
+
+            return metrics;
+        }
+
+        /// <summary>
+        /// Resets the process-wide decoder and encoder metrics.
+        /// </summary>
+        internal static void ResetMetrics()
+        {
+            WebP.ResetWebPMetrics();
+        }
+
+        private static unsafe EncoderStatistics Encode(
+            Surface input,
+            Stream? output,
+            string? path,
+            EncoderOptions options,
+            EncoderMetadata? metadata,
+            WebPReportProgress? callback,
+            bool collectStatistics,
+            bool computeDistortion,
+            MemoryBudget? memoryBudget,
+            Rectangle? cropRect)
+        {
+            EncoderRect nativeCropRect = default;
+            EncoderRect* nativeCropRectPtr = null;
+
+            if (cropRect.HasValue)
+            {
+                Rectangle rect = cropRect.Value;
+
+                if (rect.Width <= 0 || rect.Height <= 0 || !new Rectangle(0, 0, input.Width, input.Height).Contains(rect))
+                {
+                    throw new ArgumentOutOfRangeException(nameof(cropRect));
+                }
+
+                nativeCropRect = new EncoderRect
+                {
+                    x = rect.X,
+                    y = rect.Y,
+                    width = rect.Width,
+                    height = rect.Height
+                };
+                nativeCropRectPtr = &nativeCropRect;
+            }
+
+            EncoderCallbacks callbacks = new(output, callback);
+            GCHandle callbacksHandle = GCHandle.Alloc(callbacks);
+
+            // The native encoder skips the statistics work when they are not requested.
+            EncoderStatistics statistics = new()
+            {
+                computeDistortion = (byte)(computeDistortion ? 1 : 0)
+            };
+            EncoderStatistics* statisticsPtr = collectStatistics || computeDistortion ? &statistics : null;
+
+            EncoderOptions.Native nativeOptions = options.ToNative();
+
+            MemoryBudget.Native nativeBudget = memoryBudget?.ToNative() ?? default;
+            MemoryBudget.Native* nativeBudgetPtr = memoryBudget != null ? &nativeBudget : null;
+
+            delegate* unmanaged[Stdcall]<nint, int, byte> reportProgress = callback != null ? &EncoderCallbacks.ReportProgress : null;
+
+            WebPStatus retVal;
+
+            try
+            {
+                using EncoderMetadata.PinnedNative pinnedMetadata = metadata?.Pin() ?? default;
+                EncoderMetadata.Native nativeMetadata = pinnedMetadata.Value;
+                EncoderMetadata.Native* nativeMetadataPtr = metadata != null ? &nativeMetadata : null;
+
+                if (path != null)
+                {
+                    fixed (char* pathPtr = path)
+                    {
+                        retVal = WebP.WebPSaveToFile(pathPtr,
+                                                     input.Scan0.Pointer,
+                                                     input.Width,
+                                                     input.Height,
+                                                     input.Stride,
+                                                     EncoderPixelFormat.Bgra,
+                                                     nativeCropRectPtr,
+                                                     &nativeOptions,
+                                                     nativeMetadataPtr,
+                                                     reportProgress,
+                                                     GCHandle.ToIntPtr(callbacksHandle),
+                                                     statisticsPtr,
+                                                     nativeBudgetPtr);
+                    }
                 }
+                else
+                {
+                    retVal = WebP.WebPSave(&EncoderCallbacks.WriteImage,
+                                           input.Scan0.Pointer,
+                                           input.Width,
+                                           input.Height,
+                                           input.Stride,
+                                           EncoderPixelFormat.Bgra,
+                                           nativeCropRectPtr,
+                                           &nativeOptions,
+                                           nativeMetadataPtr,
+                                           reportProgress,
+                                           GCHandle.ToIntPtr(callbacksHandle),
+                                           statisticsPtr,
+                                           nativeBudgetPtr);
+                }
+            }
+            finally
+            {
+                callbacksHandle.Free();
+            }
+
+            if (memoryBudget != null)
+            {
+                memoryBudget.peakUsage = nativeBudget.peakUsage;
+            }
+
+            if (retVal != WebPStatus.Ok)
+            {
+                callbacks.ProgressErrorInfo?.Throw();
+
+                throw CreateEncoderException(retVal, callbacks.WriteException);
+            }
+
+            return statistics;
+        }
+
+        private static Exception CreateDecoderException(WebPStatus status, string functionName)
+        {
+            switch (status)
+            {
+                case WebPStatus.OutOfMemory:
+                    return new OutOfMemoryException();
+                case WebPStatus.InvalidParameter:
+                    return new WebPException(string.Format(CultureInfo.InvariantCulture, Resources.InvalidParameterFormat, functionName));
+                case WebPStatus.UnsupportedFeature:
+                    return new WebPException(Resources.UnsupportedWebPFeature);
+                case WebPStatus.DecodeFailed:
+                    return new WebPException(Resources.DecoderGenericError);
+                default:
+                    return new WebPException(Resources.InvalidWebPImage);
             }
         }
     }